@@ -0,0 +1,78 @@
+/*
+ * @file AudioCodecMeter.h
+ *
+ * Works out the level of a packet of compressed audio without fully decoding
+ * it to a playable stream - just enough to get a number comparable to what
+ * VPMAudioMeter gives for linear16 audio, for speaker detection.
+ *
+ * G.711 (PCMU/PCMA) is expanded to linear samples via lookup tables. For GSM
+ * 06.10 we don't run the whole decoder, but use the block maximum (xmaxc) that
+ * each subframe carries for its excitation signal, which follows the speech
+ * energy closely enough for a meter.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOCODECMETER_H_
+#define AUDIOCODECMETER_H_
+
+#include <stdint.h>
+#include <string>
+
+class AudioCodecMeter
+{
+
+public:
+    enum Codec
+    {
+        UNKNOWN_CODEC,
+        PCMU,
+        PCMA,
+        GSM
+    };
+
+    /*
+     * Codec for an RTP payload name as used with VPMPayloadDecoderFactory (ie,
+     * "PCMU"), or UNKNOWN_CODEC.
+     */
+    static Codec codecFromName( std::string name );
+    static const char* getCodecName( Codec codec );
+
+    /*
+     * RMS level of the packet, from 0 to 1 (full scale). Returns a negative
+     * value if the packet isn't valid for the codec.
+     */
+    static float measure( Codec codec, const uint8_t* data, uint32_t length );
+
+    static int16_t ulawToLinear( uint8_t u );
+    static int16_t alawToLinear( uint8_t a );
+
+private:
+    static void initTables();
+    static float measureG711( const int16_t* table, const uint8_t* data,
+                              uint32_t length );
+    static float measureGSM( const uint8_t* data, uint32_t length );
+
+    static int16_t ulawTable[ 256 ];
+    static int16_t alawTable[ 256 ];
+    static bool tablesInitialized;
+
+};
+
+#endif /* AUDIOCODECMETER_H_ */
@@ -0,0 +1,107 @@
+/*
+ * @file AudioLevelMeter.h
+ *
+ * Audio processor that keeps the RMS level, peak and a running average of the
+ * level for a stream of linear16 samples. Does the same job as VPMAudioMeter,
+ * but works a whole block of samples at a time with SSE2/AVX2 when the CPU has
+ * them, since metering every sample of every source adds up on the network
+ * thread with a lot of sources.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOLEVELMETER_H_
+#define AUDIOLEVELMETER_H_
+
+#include <VPMedia/audio/VPMAudioProcessor.h>
+#include <stdint.h>
+
+// SSE2 is always there on x86-64; AVX2 is checked for at runtime, but the
+// compiler needs to support per-function targets (gcc 4.9+) to build it
+#if defined(__x86_64__) || defined(__SSE2__)
+#define GRAV_METER_SSE2
+#if defined(__GNUC__) && \
+    ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) )
+#define GRAV_METER_AVX2
+#endif
+#endif
+
+class AudioLevelMeter : public VPMAudioProcessor
+{
+
+public:
+    AudioLevelMeter();
+
+    /*
+     * Called by the decoder with each block of (interleaved) samples, on the
+     * network thread.
+     */
+    virtual void processAudio( const int16_t* samples, uint32_t numSamples,
+                               uint32_t numChannels, uint32_t sampleRate );
+
+    /*
+     * Same meanings as on VPMAudioMeter. Levels are 0-1 of full scale; these
+     * can be read from any thread.
+     */
+    float level();
+    float levelAverage();
+    float peak();
+    void resetAverage();
+
+    /*
+     * Sum of squares and largest absolute value of a block of samples. This is
+     * the kernel for the current CPU (see getKernelName). The others are
+     * public so they can be checked against each other & benchmarked - the
+     * SIMD ones are only there if supported by the compiler, and should only
+     * be called if haveSSE2/haveAVX2 say the CPU can run them.
+     */
+    static void measure( const int16_t* samples, uint32_t num,
+                         uint64_t& sumSquares, int& peak );
+    static void measureScalar( const int16_t* samples, uint32_t num,
+                               uint64_t& sumSquares, int& peak );
+#ifdef GRAV_METER_SSE2
+    static void measureSSE2( const int16_t* samples, uint32_t num,
+                             uint64_t& sumSquares, int& peak );
+#endif
+#ifdef GRAV_METER_AVX2
+    static void measureAVX2( const int16_t* samples, uint32_t num,
+                             uint64_t& sumSquares, int& peak );
+#endif
+
+    static bool haveSSE2();
+    static bool haveAVX2();
+    static const char* getKernelName();
+
+private:
+    typedef void (*MeasureFunc)( const int16_t*, uint32_t, uint64_t&, int& );
+    static MeasureFunc pickKernel();
+    static MeasureFunc kernel;
+
+    volatile float currentLevel;
+    volatile float currentPeak;
+    volatile float average;
+    volatile int averageReset;
+
+    // only touched by processAudio
+    double averageSum;
+    unsigned long averageCount;
+
+};
+
+#endif /* AUDIOLEVELMETER_H_ */
@@ -29,21 +29,75 @@
 
 class VPMSession;
 class VPMPayloadDecoder;
-class VPMAudioMeter;
+class AudioLevelMeter;
+class AudioMeterDecoder;
+class MeterDecodeWorker;
+struct MeterChannel;
 
 #include <VPMedia/VPMSessionListener.h>
 #include <VPMedia/VPMPayload.h>
 #include <VPMedia/VPMTypes.h>
+#include <VPMedia/thread_helper.h>
 #include <string>
 #include <vector>
+#include <map>
+
+#include "VoiceActivityDetector.h"
+
+/*
+ * Combined level of all the sources with a given siteID or cname (or of all
+ * sources). These are written by publishLevels() and read by getLevel()
+ * without any locking - aligned float/int loads & stores are atomic on
+ * everything we build for, and readers only ever need some recent value.
+ * Groups nobody's been in for a while are taken out of the name maps by
+ * publishLevels, but only deleted a good while after that (see retireGraceMS),
+ * so a reader that looked one up just before can't end up with a dangling
+ * pointer.
+ */
+typedef struct AudioLevelGroup
+{
+    // published values
+    volatile float level;
+    volatile float average;
+    volatile int numSources;
+    // set by readers of the average to have it restart on the next publish
+    volatile int resetAverage;
+    // whether the group counts as someone talking, according to vad
+    volatile int speaking;
+
+    VoiceActivityDetector vad;
+
+    // only touched by publishLevels
+    float passSum;
+    int passCount;
+    float averageSum;
+    unsigned long averageCount;
+
+    // only touched on the decoding thread: which map it's in, how many
+    // sources are counted in it, and when that went to 0 (0 if it hasn't)
+    std::string name;
+    bool cnames;
+    int refs;
+    long emptySinceMS;
+} AudioLevelGroup;
 
 typedef struct AudioSource
 {
     uint32_t ssrc;
     std::string siteID;
     std::string cName;
-    VPMAudioMeter* meter;
     VPMSession* session;
+
+    // linear16 sources are metered as they're decoded, anything else goes
+    // through an AudioMeterDecoder & the meter worker - only one of
+    // meter/channel is set
+    AudioLevelMeter* meter;
+    MeterChannel* channel;
+    AudioMeterDecoder* meterDecoder;
+
+    // groups this source is currently counted in (NULL if no siteID/cname)
+    AudioLevelGroup* siteGroup;
+    AudioLevelGroup* cNameGroup;
 } AudioSource;
 
 class AudioManager : public VPMSessionListener
@@ -56,6 +110,8 @@ public:
     // avg: get running level average for single source
     // cnames: check cname instead of siteID
     // if name is blank, average all sources
+    // these are safe to call from any thread, and don't wait on the decoding
+    // thread
     float getLevel( std::string name = "", bool avg = false,
                         bool cnames = false );
     float getLevelAvg( std::string name = "" );
@@ -63,7 +119,26 @@ public:
 
     unsigned int getSourceCount();
 
-    void updateNames();
+    /*
+     * Whether the sources with the given siteID/cname count as someone
+     * talking. Unlike checking getLevel against a threshold, this doesn't
+     * flicker with noise or short pauses - see VoiceActivityDetector.
+     */
+    bool isSpeaking( std::string name, bool cnames = false );
+
+    /*
+     * Goes up by one every time any group starts or stops speaking, so
+     * callers can cheaply check whether anything changed since they last
+     * looked.
+     */
+    unsigned int getSpeakerChangeCount();
+
+    /*
+     * Reads the meters of all sources & publishes the per-siteID/cname levels
+     * for getLevel. Should be called regularly on the thread that iterates the
+     * audio sessions (ie, the one the callbacks below happen on).
+     */
+    void publishLevels();
 
     virtual void vpmsession_source_created( VPMSession &session,
                                           uint32_t ssrc,
@@ -82,7 +157,54 @@ public:
                                      uint32_t data_len);
 
 private:
-    std::vector<AudioSource*> sources;
+    typedef std::pair<VPMSession*, uint32_t> SourceKey;
+
+    // should be called with sourceMutex held
+    AudioSource* findSource( VPMSession* session, uint32_t ssrc );
+    static float getSourceLevel( AudioSource* a );
+
+    /*
+     * Find the group for a name, optionally creating it. Creating should only
+     * be done on the decoding thread, with sourceMutex held.
+     */
+    AudioLevelGroup* findGroup( std::string name, bool cnames, bool create );
+
+    /*
+     * Move a source's count from one group to another (either can be NULL).
+     * Decoding thread only.
+     */
+    static void changeGroup( AudioLevelGroup*& current,
+                             AudioLevelGroup* next );
+
+    /*
+     * Take groups that have been empty for retireAfterMS out of the maps, and
+     * delete ones that were taken out more than retireGraceMS ago. Called
+     * by publishLevels.
+     */
+    void retireGroups( long nowMS );
+
+    // all sources, protected by sourceMutex
+    std::map<SourceKey, AudioSource*> sources;
+    mutex* sourceMutex;
+
+    // name -> group maps, protected by groupMutex. only the decoding thread
+    // adds to these, so it can read them without locking
+    std::map<std::string, AudioLevelGroup*> siteGroups;
+    std::map<std::string, AudioLevelGroup*> cNameGroups;
+    std::vector<AudioLevelGroup*> groups;
+    AudioLevelGroup* allGroup;
+    mutex* groupMutex;
+    // out of the maps, waiting to be deleted, with when they were taken out
+    std::vector<std::pair<long, AudioLevelGroup*> > retiredGroups;
+    static const long retireAfterMS = 60000;
+    static const long retireGraceMS = 10000;
+
+    // measures levels for non-linear16 sources, started when the first one
+    // shows up
+    MeterDecodeWorker* meterWorker;
+
+    volatile int sourceCount;
+    volatile unsigned int speakerChanges;
 
 };
 
@@ -0,0 +1,77 @@
+/*
+ * @file AudioMeterDecoder.h
+ *
+ * Payload decoder for audio formats that VPMedia doesn't have a linear16
+ * decoder for. Rather than producing audio, it just hands each packet to a
+ * MeterDecodeWorker, which works out its level - that's all AudioManager
+ * needs for speaker detection. Registered with VPMPayloadDecoderFactory under
+ * the usual RTP payload names (see registerDecoders), so sessions create it
+ * like any other decoder.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOMETERDECODER_H_
+#define AUDIOMETERDECODER_H_
+
+#include <VPMedia/VPMPayloadDecoder.h>
+
+#include "AudioCodecMeter.h"
+#include "MeterDecodeWorker.h"
+
+class VPMPayloadDecoderFactory;
+
+class AudioMeterDecoder : public VPMPayloadDecoder
+{
+
+public:
+    AudioMeterDecoder( AudioCodecMeter::Codec c );
+
+    /*
+     * Where packets go from now on. Like connectAudioProcessor on the
+     * linear16 decoder, this is done from the source created callback; NULL
+     * disconnects it (ie, when the source is deleted). Until it's connected,
+     * packets are just dropped.
+     */
+    void connectMeter( MeterChannel* channel );
+
+    AudioCodecMeter::Codec getCodec();
+
+    virtual bool initialise();
+    virtual void decodePacket( const uint8_t* payload, uint32_t length,
+                               uint32_t timestamp, bool marker );
+    virtual const char* getDesc();
+
+    /*
+     * Adds creators for all the codecs AudioCodecMeter handles to the
+     * factory. Payload types still need to be mapped to the names as usual.
+     */
+    static void registerDecoders( VPMPayloadDecoderFactory* factory );
+
+private:
+    static VPMPayloadDecoder* createPCMU();
+    static VPMPayloadDecoder* createPCMA();
+    static VPMPayloadDecoder* createGSM();
+
+    AudioCodecMeter::Codec codec;
+    MeterChannel* meter;
+
+};
+
+#endif /* AUDIOMETERDECODER_H_ */
@@ -28,6 +28,7 @@
 
 #include "Point.h"
 #include "Vector.h"
+#include "Frustum.h"
 class Earth;
 
 class Camera
@@ -35,8 +36,11 @@ class Camera
 
 public:
     Camera( Point c, Point l );
+    // also updates the frustum for the new transform
     void doGLLookat();
 
+    Frustum* getFrustum();
+
     Point getCenter();
     Point getDestCenter();
     Point getLookat();
@@ -71,6 +75,8 @@ private:
     Vector up;
     Vector destUp;
 
+    Frustum frustum;
+
     // cam has a reference to earth so it can update its up-down rotation axis
     // based on the cam position
     Earth* earth;
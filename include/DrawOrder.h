@@ -0,0 +1,78 @@
+/*
+ * @file DrawOrder.h
+ *
+ * The list of drawn objects, bottom to top. Objects are kept in a map keyed by
+ * an increasing counter (plus a reverse map from object to key), so adding,
+ * removing and moving to the top are all O(log n) instead of needing a scan
+ * and an erase from the middle of a vector. The plain vector version of the
+ * list is only rebuilt when something asks for it after a change - ie, once a
+ * frame when it's drawn.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DRAWORDER_H_
+#define DRAWORDER_H_
+
+#include <vector>
+#include <map>
+
+class RectangleBase;
+
+class DrawOrder
+{
+
+public:
+    DrawOrder();
+
+    /*
+     * Put an object on top. Returns false if it was already in the list (in
+     * which case it stays where it was).
+     */
+    bool add( RectangleBase* object );
+    bool remove( RectangleBase* object );
+    bool contains( RectangleBase* object ) const;
+
+    /*
+     * Returns false if the object isn't in the list.
+     */
+    bool moveToTop( RectangleBase* object );
+
+    unsigned int size() const;
+
+    /*
+     * The objects in drawing order (ie, last is on top). The reference stays
+     * valid, but its contents will change the next time this is called after
+     * the list is modified, so don't hold onto it across changes.
+     */
+    const std::vector<RectangleBase*>& getList();
+
+private:
+    typedef unsigned long OrderKey;
+
+    std::map<OrderKey, RectangleBase*> objects;
+    std::map<RectangleBase*, OrderKey> keyOf;
+    OrderKey nextKey;
+
+    std::vector<RectangleBase*> list;
+    bool listDirty;
+
+};
+
+#endif /* DRAWORDER_H_ */
@@ -26,17 +26,49 @@
 #ifndef EARTH_H_
 #define EARTH_H_
 
+#include <vector>
+
 #include "GLUtil.h"
 
+class SphereMesh;
+class EarthTiles;
+class Point;
+
 class Earth
 {
 
 public:
     Earth();
     ~Earth();
-    void draw();
+
+    /*
+     * Draw with a level of detail to suit how big the earth is on screen,
+     * given where the camera is and the size of the viewport in pixels.
+     */
+    void draw( Point camPos, int viewWidth, int viewHeight );
+
+    /*
+     * Pick up the earth texture from GLUtil, if it's changed - it's loaded in
+     * the background, so it may not be there when this is created.
+     */
+    void updateTexture();
+
+    /*
+     * Convert lat/long to a world space position on the surface. This uses
+     * the transform worked out on the CPU whenever the earth moves, so it
+     * doesn't touch GL at all & is cheap enough to call per object per frame.
+     */
     void convertLatLong( float lat, float lon, float &ex, float &ey,
                         float &ez );
+    /*
+     * Same, but from a position on the unit sphere (ie from latLongToUnit),
+     * for callers that keep that around instead of redoing the trig.
+     */
+    void convertUnit( float ux, float uy, float uz, float &ex, float &ey,
+                      float &ez );
+    static void latLongToUnit( float lat, float lon, float &ux, float &uy,
+                               float &uz );
+
     void rotate( float x, float y, float z );
     float getX(); float getY(); float getZ();
     float getRadius();
@@ -46,14 +78,26 @@ private:
     GLuint earthTex;
     int texWidth, texHeight;
 
-    GLUquadric* sphereQuad;
-    GLuint sphereIndex;
+    // whole sphere at increasing tessellation, see meshSlices
+    std::vector<SphereMesh*> meshes;
+    static const int numMeshLevels = 4;
+    static const int meshSlices[ numMeshLevels ];
+    // high res imagery, if there is any (NULL otherwise)
+    EarthTiles* tiles;
+    bool anisotropic;
+    float maxAnisotropy;
+
+    // camera position in the sphere's own (drawn) coordinates
+    void toLocal( float wx, float wy, float wz, float &lx, float &ly,
+                  float &lz );
 
     // note, only doing animation for rotation for now
     bool animated;
     // indicator of whether the object is in motion
     bool rotating;
     void animateValues();
+    // recalculate matrix from the current position/rotation
+    void updateTransform();
 
     float x, y, z;
     float radius;
@@ -64,6 +108,7 @@ private:
     float moveAmt;
 
     // keep track of the transformation matrix to use with lat/long conversion
+    // (column major, like GL)
     GLdouble* matrix;
 
 };
@@ -0,0 +1,131 @@
+/*
+ * @file EarthTiles.h
+ *
+ * Higher resolution earth imagery, split into a pyramid of tiles on disk so
+ * only the parts that are actually being looked at need to be in memory.
+ *
+ * The pyramid is a directory (earth_tiles in the resource path) with one
+ * subdirectory per level: level L is an equirectangular map of the whole
+ * earth 2^(L+1) tiles across and 2^L down, with tile x,y (from the top left,
+ * ie -180 long, 90 lat) at L/x_y.png. Tiles should be square, power of 2 PNGs
+ * (tileSize pixels), so level 0 is two tiles for the whole earth.
+ *
+ * Tiles are loaded lazily (a few per frame at most, so zooming in doesn't
+ * stall drawing) and only for tiles facing the camera. Tiles that haven't
+ * been drawn for a while are freed, and there's a hard cap on how many can be
+ * loaded at once, so memory stays bounded however big the pyramid is.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EARTHTILES_H_
+#define EARTHTILES_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "GLUtil.h"
+
+class SphereMesh;
+
+struct EarthTile;
+
+class EarthTiles
+{
+
+public:
+    /*
+     * Looks for the tile pyramid in the resource path, returning NULL if it
+     * isn't there (it's optional, the normal earth texture is used without
+     * it).
+     */
+    static EarthTiles* find( float radius );
+    ~EarthTiles();
+
+    int getMaxLevel();
+    int getTileSize();
+
+    /*
+     * Draw the sphere (in its own coordinates - see SphereMesh) using tiles
+     * from the given level, for a camera at camX/Y/Z (also in sphere
+     * coordinates). Tiles facing away from the camera are skipped entirely;
+     * ones that aren't loaded yet are drawn with baseTex, the whole-earth
+     * texture, and queued to load.
+     * Texturing should be enabled already.
+     */
+    void draw( int level, float camX, float camY, float camZ,
+               GLuint baseTex );
+
+    /*
+     * Pick up tiles that have finished loading, request some of the ones
+     * asked for this frame, and free ones that haven't been used in a while.
+     * Tiles are decoded in the background and uploaded by
+     * GLUtil::updateTextures, so this doesn't wait on any files. Should be
+     * called once per frame, after draw.
+     */
+    void endFrame();
+
+    unsigned int getResidentCount();
+    unsigned int getDrawnCount();
+
+    // how many tiles to request per frame at most, and how many can be
+    // loading at once (so panning around doesn't queue up a backlog of tiles
+    // that are off screen by the time they're done)
+    static const unsigned int maxLoadsPerFrame = 2;
+    static const unsigned int maxLoadingTiles = 8;
+    // tiles not drawn for this many frames are freed
+    static const unsigned long evictAfterFrames = 180;
+    // never have more than this many tile textures at once (at 256x256 with
+    // mipmaps that's about 35MB)
+    static const unsigned int maxResidentTiles = 96;
+
+private:
+    EarthTiles( std::string dir, int levels, float radius );
+
+    std::string getTileFile( int level, int x, int y );
+    // relative to the resource path, also used as the texture name
+    std::string getTileName( int level, int x, int y );
+    EarthTile* getTile( int level, int x, int y );
+    bool loadTile( EarthTile* tile );
+    void collectLoaded();
+    void setTileParameters( EarthTile* tile );
+    void freeTile( EarthTile* tile );
+    void evictOldest();
+
+    std::string directory;
+    int maxLevel;
+    int tileSize;
+    float radius;
+
+    // keyed by level/x/y
+    std::map<unsigned long, EarthTile*> tiles;
+    unsigned int residentCount;
+    unsigned int loadingCount;
+
+    // tiles drawn with the base texture this frame, to load in endFrame,
+    // with how far they are from the center of the view (closest load first)
+    std::vector<std::pair<float, EarthTile*> > wanted;
+
+    unsigned long frame;
+    unsigned int drawnCount;
+
+};
+
+#endif /* EARTHTILES_H_ */
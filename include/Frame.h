@@ -44,6 +44,15 @@ public:
     void setInputHandler( InputHandler* i );
     void spawnPropertyWindow( wxCommandEvent& evt );
 
+    /*
+     * For things the InputHandler wants done that have to be on the GUI
+     * thread - posted as menu events, since input may be handled on a
+     * render thread. The object menu event has the position in the int &
+     * extra long.
+     */
+    static int objectMenuID;
+    static int toggleFullscreenID;
+
 private:
     // different event types for these, so we need these separate functions even
     // though they do the same thing
@@ -72,6 +81,8 @@ private:
     void toggleVCCEvent( wxCommandEvent& evt );
     void toggleSideFrameEvent( wxCommandEvent& evt );
     void toggleAutomaticEvent( wxCommandEvent& evt );
+    void objectMenuEvent( wxCommandEvent& evt );
+    void toggleFullscreenEvent( wxCommandEvent& evt );
 
     // IDs for toggles in view section of menubar
     static int toggleRunwayID;
@@ -0,0 +1,124 @@
+/*
+ * @file FrameScheduler.h
+ *
+ * Decides when the render loop should draw the next frame, based on a
+ * target frame interval and a monotonic clock, and keeps stats on how
+ * evenly frames actually come out and how long new video takes to get to
+ * the screen.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMESCHEDULER_H_
+#define FRAMESCHEDULER_H_
+
+#include <stdint.h>
+
+class VPMVideoSink;
+
+class FrameScheduler
+{
+
+public:
+    FrameScheduler();
+
+    /*
+     * Target time between frames, in microseconds. 0 (the default) means
+     * draw whenever possible, ie only limited by vsync if that's on.
+     */
+    void setInterval( long us );
+    long getInterval();
+
+    // whether the deadline for the next frame has been reached
+    bool isFrameDue();
+
+    /*
+     * Sleep until the next frame is due, but for at most maxUS, so the
+     * caller can get back to handling events in between.
+     */
+    void waitForFrame( long maxUS );
+
+    /*
+     * Call right after the buffers are swapped. Moves the deadline on by one
+     * interval from the last one (not from now, so the rate doesn't drift),
+     * unless we've fallen a whole frame behind, in which case it starts over
+     * from now rather than drawing a burst of frames to catch up.
+     */
+    void frameSwapped();
+
+    /*
+     * New frame callback for the video sinks (see
+     * VPMVideoBufferSink::addNewFrameCallback) - called on the network thread
+     * as soon as a frame's decoded, and just notes the time. It's static so a
+     * sink that outlives the canvas can't call into a deleted scheduler.
+     */
+    static void videoFrameDecoded( VPMVideoSink* sink, int bufferIndex,
+                                   void* userData );
+
+    /*
+     * Call when a new video frame is pushed to a texture. Latency is measured
+     * from when the earliest frame shown in this frame was decoded to the
+     * swap, so it includes however long the frame sat in the sink before
+     * being drawn, not just the draw.
+     */
+    void videoFrameUploaded();
+
+    // averages over the last report period (see reportIntervalUS)
+    // jitter is the mean difference between consecutive frame intervals
+    long getJitterUS();
+    long getLatencyUS();
+
+    // microseconds on a monotonic clock, ie not affected by the system time
+    // being changed
+    static int64_t getTimeUS();
+
+private:
+    long intervalUS;
+    int64_t nextDeadlineUS;
+
+    int64_t lastSwapUS;
+    long lastIntervalUS;
+    // decode time of the earliest frame uploaded since the last swap, or 0 if
+    // none
+    int64_t firstDecodeUS;
+    // earliest decode no upload has picked up yet, or 0 - set by the network
+    // thread, taken by the drawing thread
+    static volatile int64_t pendingDecodeUS;
+
+    // stats for the current report period
+    int64_t periodStartUS;
+    int frameCount;
+    int64_t jitterSumUS;
+    int jitterCount;
+    long maxIntervalUS;
+    int lateCount;
+    int64_t latencySumUS;
+    int latencyCount;
+    long maxLatencyUS;
+
+    long jitterResult;
+    long latencyResult;
+
+    static const long reportIntervalUS = 5000000;
+
+    void report( int64_t now );
+
+};
+
+#endif /* FRAMESCHEDULER_H_ */
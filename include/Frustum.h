@@ -0,0 +1,64 @@
+/*
+ * @file Frustum.h
+ *
+ * The camera's view volume as 6 planes, for skipping drawing of objects that
+ * are entirely off-screen.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+class Frustum
+{
+
+public:
+    Frustum();
+
+    /*
+     * Pull the planes out of the current GL projection & modelview matrices -
+     * so this should be called after the camera transform is set up. Also
+     * resets the counts below.
+     */
+    void update();
+
+    /*
+     * Returns false only if the sphere is entirely outside one of the planes,
+     * so this can give false positives near the corners, but never false
+     * negatives. Everything is visible until update() is first called.
+     */
+    bool sphereVisible( float x, float y, float z, float radius );
+
+    // number of sphereVisible calls & how many of those returned false since
+    // the last update (ie, for this frame)
+    int getTestedCount();
+    int getCulledCount();
+
+private:
+    // a, b, c, d for each, normalized so ax+by+cz+d is the distance
+    float planes[6][4];
+    bool valid;
+
+    int testedCount;
+    int culledCount;
+
+};
+
+#endif /* FRUSTUM_H_ */
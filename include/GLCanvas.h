@@ -27,6 +27,7 @@
 #define GLCANVAS_H_
 
 #include "GLUtil.h"
+#include "FrameScheduler.h"
 
 // note GLUtil needs to be included first, since glew/glxew needs to set up its
 // #defines and such before other libs like glu are included (via wxglcanvas)
@@ -37,6 +38,7 @@
 
 class gravManager;
 class RenderTimer;
+class RenderThread;
 
 class GLCanvas : public wxGLCanvas
 {
@@ -53,6 +55,16 @@ public:
     void stopTimer();
     void setTimer( RenderTimer* t );
 
+    /*
+     * While a render thread is set, it owns the GL context: paint events
+     * don't draw and resizes are passed over to it. The context has to be
+     * let go of on one thread before it's made current on another.
+     */
+    void setRenderThread( RenderThread* r );
+    void stopRenderThread();
+    void makeCurrent();
+    void releaseContext();
+
     long getDrawTime();
     long getNonDrawTime();
     long getDrawTimeAvg();
@@ -62,6 +74,9 @@ public:
     void setDebugTimerUsage( bool d );
     bool getDebugTimerUsage();
 
+    // decides when the next frame should be drawn - see gravApp::idleHandler
+    FrameScheduler* getScheduler();
+
 private:
     gravManager* grav;
     wxGLContext* glContext;
@@ -77,6 +92,8 @@ private:
     // it if need be
     RenderTimer* renderTimer;
 
+    RenderThread* renderThread;
+
     // for measuring the draw time
     wxStopWatch drawStopwatch;
     long lastDrawTime;
@@ -96,6 +113,8 @@ private:
 
     bool useDebugTimers;
 
+    FrameScheduler scheduler;
+
 };
 
 #endif /*GLCANVAS_H_*/
@@ -37,6 +37,7 @@
 
 #include <iostream>
 #include <map>
+#include <set>
 
 #include "Point.h"
 
@@ -49,6 +50,7 @@ typedef struct
 
 class RectangleBase;
 class GLCanvas;
+class ResourceLoader;
 
 class GLUtil
 {
@@ -133,15 +135,48 @@ public:
 
     void setBufferFontUsage( bool buf );
 
+    /*
+     * Whether to sync buffer swaps to the display refresh - like the shader
+     * enable, needs to be set before initGL. isVSyncEnabled is whether it
+     * actually got turned on (ie, the driver has a swap control extension).
+     */
+    void setVSync( bool v );
+    bool isVSyncEnabled();
+
     /*
      * Loads a PNG file as a texture and puts it in the textures map, indexed by
      * name.
      * Note, if when calling getTexture() the input is not found, it will return
      * a Texture with 0 in all fields, which will be safe to render (will just
      * be white)
+     * mipmap is passed on to PNGLoader::loadPNG.
+     */
+    bool addTexture( std::string name, std::string fileName,
+                     bool mipmap = false );
+    /*
+     * Same as addTexture, but the file is loaded on a background thread -
+     * getTexture will return the empty Texture for name until it's been
+     * uploaded by updateTextures.
+     */
+    bool addTextureAsync( std::string name, std::string fileName,
+                          bool mipmap = false );
+    /*
+     * Upload any textures from addTextureAsync that have finished loading.
+     * Should be called regularly (ie, each frame) from the GL thread. Returns
+     * how many were added.
      */
-    bool addTexture( std::string name, std::string fileName );
+    int updateTextures();
     Texture getTexture( std::string name );
+    /*
+     * For addTextureAsync textures the caller wants to manage itself (ie,
+     * delete when it's done with them). Returns false while name is still
+     * loading - otherwise fills in t (ID 0 if it failed to load) and forgets
+     * about it, so the texture belongs to the caller after that.
+     */
+    bool takeTexture( std::string name, Texture& t );
+
+    // queried once in initGL
+    int getMaxTextureSize();
 
     void setCanvas( GLCanvas* c );
     GLCanvas* getCanvas();
@@ -173,7 +208,17 @@ private:
     // switch to change to use buffer font - texture font is default
     bool useBufferFont;
 
+    bool useVSync;
+    bool vsyncEnabled;
+    void initSwapControl();
+
     std::map<std::string, Texture> textures;
+    // async textures that failed, until they're taken
+    std::set<std::string> failedTextures;
+    // created on first addTextureAsync
+    ResourceLoader* loader;
+
+    GLint maxTextureSize;
 
     GLCanvas* canvas;
 
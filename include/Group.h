@@ -80,7 +80,7 @@ protected:
      * groups of child objects & rearrange them differently) but still have
      * access to the basic rearrangeStyle rearranges for chosen objects.
      */
-    void rearrange( std::vector<RectangleBase*> objs );
+    void rearrange( const std::vector<RectangleBase*>& objs );
 
     std::vector<RectangleBase*> objects;
     float buffer;
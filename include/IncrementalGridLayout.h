@@ -0,0 +1,98 @@
+/*
+ * @file IncrementalGridLayout.h
+ *
+ * A grid layout that remembers which cell each object was put in, so that
+ * when objects come and go (ie, with --gridauto) only the affected objects
+ * move. New objects fill the first empty cell, removed objects just leave
+ * their cell empty, and the whole grid is only laid out again when its
+ * dimensions (or the area it covers) change. The column count is kept through
+ * small changes in the number of objects so that doesn't happen too often.
+ * Cells are placed the same way LayoutManager::gridArrange does it.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCREMENTALGRIDLAYOUT_H_
+#define INCREMENTALGRIDLAYOUT_H_
+
+#include <vector>
+#include <map>
+
+class RectangleBase;
+
+class IncrementalGridLayout
+{
+
+public:
+    IncrementalGridLayout();
+
+    /*
+     * Brings the grid in line with the given list of objects: objects not in
+     * the grid yet get a cell, objects that aren't in the list anymore are
+     * removed from theirs. Objects that were already placed are left alone
+     * unless the grid has to be redone.
+     * Returns true if the whole grid was laid out again.
+     * Note this is NOT thread-safe, same as the LayoutManager functions -
+     * callers should hold the source lock.
+     */
+    bool update( const std::vector<RectangleBase*>& objects,
+                 float outerL, float outerR, float outerU, float outerD );
+
+    /*
+     * Forgets all cell assignments, so the next update does a full layout.
+     * For when something else has moved the objects, or grid mode gets turned
+     * back on.
+     */
+    void reset();
+
+    /*
+     * Drop a single object from the grid - for when an object is about to be
+     * deleted, so we don't keep a dangling pointer around until the next
+     * update.
+     */
+    void remove( RectangleBase* object );
+
+    int getNumX();
+    int getNumY();
+
+private:
+    /*
+     * The grid dimensions to use for a given number of objects - what
+     * LayoutManager::gridArrange would pick, unless the current ones still
+     * fit well enough.
+     */
+    void chooseDimensions( unsigned int num, int& x, int& y );
+
+    void reflow( const std::vector<RectangleBase*>& objects );
+    void place( RectangleBase* object, unsigned int cell );
+
+    // one entry per cell, row-major, NULL for empty cells
+    std::vector<RectangleBase*> cells;
+    std::map<RectangleBase*, unsigned int> cellOf;
+
+    int numX, numY;
+    // number of objects & cells up to the last full one, as of the last time
+    // things were placed - the lone object & last row placement depend on
+    // these
+    unsigned int placedCount, placedFilled;
+    float boundL, boundR, boundU, boundD;
+
+};
+
+#endif /* INCREMENTALGRIDLAYOUT_H_ */
@@ -0,0 +1,77 @@
+/*
+ * @file LayoutBenchmark.h
+ *
+ * Timing harness for the LayoutManager arrangements - runs each layout method
+ * over increasing numbers of objects and reports time (and, in debug builds,
+ * heap allocations) per call. Can also write/check a snapshot of the resulting
+ * object positions so changes to the layout code can be verified to produce
+ * the same arrangements.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYOUTBENCHMARK_H_
+#define LAYOUTBENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+class RectangleBase;
+
+class LayoutBenchmark
+{
+
+public:
+    LayoutBenchmark();
+    ~LayoutBenchmark();
+
+    /*
+     * Runs all methods at all sizes, logging the results. If snapshotFile is
+     * non-empty, the final positions for each method/size are compared against
+     * that file if it exists, or written to it if it doesn't.
+     * Returns false if the snapshot didn't match (or couldn't be
+     * read/written).
+     */
+    bool run( std::string snapshotFile = "" );
+
+private:
+    /*
+     * Puts the objects back in the same starting state before each method so
+     * results don't depend on what ran before. Object sizes vary in a fixed
+     * pattern so aspect-preserving code paths get exercised.
+     */
+    void resetObjects( unsigned int num );
+
+    /*
+     * Runs method on the first num objects, once to record the positions and
+     * then enough times to get a stable timing.
+     */
+    void runMethod( std::string method, unsigned int num );
+
+    bool writeSnapshot( std::string filename );
+    bool checkSnapshot( std::string filename );
+
+    std::vector<RectangleBase*> objects;
+
+    // flattened "method num index: x y w h" lines, in run order
+    std::vector<std::string> snapshot;
+
+};
+
+#endif /* LAYOUTBENCHMARK_H_ */
@@ -34,52 +34,162 @@
 
 class RectangleBase;
 
+/*
+ * Options for the typed layout functions. The defaults here match the
+ * defaults the string options have always had - not every layout uses every
+ * field.
+ */
+struct LayoutOptions
+{
+    LayoutOptions();
+
+    // grid: fill rows first (vs. columns first)
+    bool horiz;
+    // grid: push the outer objects in each row/column to the edges
+    bool edge;
+    // grid: resize objects to fit their cells
+    bool resize;
+    // grid: keep object aspect ratios when resizing
+    bool preserveAspect;
+    // grid: cells in each direction - both 0 means figure it out from the
+    // number of objects
+    int numX, numY;
+
+    // aspectFocus: aspect ratio and scale (relative to the outer rect) of the
+    // generated inner rect
+    float aspect;
+    float scale;
+};
+
+/*
+ * Non-owning view of a list of objects, so layouts can pass subsets (and
+ * reversed subsets) of a list around without copying it. Only valid while the
+ * underlying vector is unchanged.
+ */
+class ObjectSpan
+{
+
+public:
+    ObjectSpan();
+    ObjectSpan( const std::vector<RectangleBase*>& objects );
+    ObjectSpan( RectangleBase* const* start, unsigned int num, int step = 1 );
+
+    RectangleBase* operator[]( unsigned int i ) const
+    {
+        return first[ (int)i * step ];
+    }
+    unsigned int size() const { return num; }
+    bool empty() const { return num == 0; }
+
+    ObjectSpan sub( unsigned int start, unsigned int count ) const;
+    ObjectSpan reversed() const;
+
+private:
+    RectangleBase* const* first;
+    unsigned int num;
+    int step;
+
+};
+
+enum LayoutMethod
+{
+    GRID_LAYOUT,
+    PERIMETER_LAYOUT,
+    FOCUS_LAYOUT,
+    ASPECTFOCUS_LAYOUT
+};
+
 class LayoutManager
 {
 
 public:
     LayoutManager();
 
-    bool arrange( std::string method,
+    /*
+     * String-keyed interface, for scripting callers. Data keys are "objects"
+     * (grid, perimeter) or "inners" and "outers" (focus, aspectFocus); options
+     * are the LayoutOptions field names with "True"/"False" or number values.
+     * These just translate to the typed functions below.
+     */
+    bool arrange( const std::string& method,
                   RectangleBase outerRect,
                   RectangleBase innerRect,
-                  std::map<std::string, std::vector<RectangleBase*> > data,
-                  std::map<std::string, std::string> options=std::map<std::string, std::string>());
-    bool arrange( std::string method,
+                  const std::map<std::string, std::vector<RectangleBase*> >& data,
+                  const std::map<std::string, std::string>& options =
+                      std::map<std::string, std::string>() );
+    bool arrange( const std::string& method,
                   float outerL, float outerR, float outerU, float outerD,
                   float innerL, float innerR, float innerU, float innerD,
-                  std::map<std::string, std::vector<RectangleBase*> > data,
-                  std::map<std::string, std::string> options=std::map<std::string, std::string>());
+                  const std::map<std::string, std::vector<RectangleBase*> >& data,
+                  const std::map<std::string, std::string>& options =
+                      std::map<std::string, std::string>() );
 
-private:
-    bool focus( float outerL, float outerR, float outerU, float outerD,
-                float innerL, float innerR, float innerU, float innerD,
-                std::map<std::string, std::vector<RectangleBase*> > data,
-                std::map<std::string, std::string> options=std::map<std::string, std::string>());
+    /*
+     * Typed interface. objects is used by grid & perimeter, inners/outers by
+     * focus & aspectFocus. Inner rect is ignored by grid & aspectFocus.
+     */
+    bool arrange( LayoutMethod method,
+                  float outerL, float outerR, float outerU, float outerD,
+                  float innerL, float innerR, float innerU, float innerD,
+                  ObjectSpan objects, ObjectSpan inners = ObjectSpan(),
+                  const LayoutOptions& options = LayoutOptions() );
+    bool arrange( LayoutMethod method,
+                  RectangleBase outerRect,
+                  RectangleBase innerRect,
+                  ObjectSpan objects, ObjectSpan inners = ObjectSpan(),
+                  const LayoutOptions& options = LayoutOptions() );
 
-    // helper function to make an inner rect based on "aspect" and "scale"
-    // options.
-    // inner rect supplied is ignored.
-    // like focus, must be passed data["outers"] and data["inners"]
-    bool aspectFocus( float outerL, float outerR, float outerU, float outerD,
-                float innerL, float innerR, float innerU, float innerD,
-                std::map<std::string, std::vector<RectangleBase*> > data,
-                std::map<std::string, std::string> options=std::map<std::string, std::string>());
+    /*
+     * Looks up a method by its string name. Returns false if there isn't one.
+     */
+    static bool findMethod( const std::string& name, LayoutMethod& method );
 
-    bool perimeterArrange( float outerL, float outerR, float outerU,
-                            float outerD, float innerL, float innerR,
-                            float innerU, float innerD,
-                            std::map<std::string, std::vector<RectangleBase*> > data,
-                            std::map<std::string, std::string> options=std::map<std::string, std::string>());
+    static LayoutOptions parseOptions(
+            const std::map<std::string, std::string>& options );
 
     /*
      * Arranges objects in a grid based on options.
-     * Inner rectangle is ignored.
      */
     bool gridArrange( float outerL, float outerR, float outerU, float outerD,
-                      float innerL, float innerR, float innerU, float innerD,
-                      std::map<std::string, std::vector<RectangleBase*> > data,
-                      std::map<std::string, std::string> options);
+                      ObjectSpan objects,
+                      const LayoutOptions& options = LayoutOptions() );
+
+    /*
+     * The pieces of gridArrange's default arrangement (rows first, no edge),
+     * for code that places grid cells one at a time (see
+     * IncrementalGridLayout).
+     * gridCellCenter gives the center of cell index of a numX x numY grid
+     * holding num objects - a partial last row is spread out evenly over the
+     * width. fitToCell resizes an object to a cell of the given size.
+     */
+    static void gridCellCenter( float outerL, float outerR,
+                                float outerU, float outerD,
+                                int numX, int numY, unsigned int num,
+                                unsigned int index, float& x, float& y );
+    static void fitToCell( RectangleBase* object, float cellWidth,
+                           float cellHeight, bool preserveAspect );
+
+    bool perimeterArrange( float outerL, float outerR, float outerU,
+                           float outerD, float innerL, float innerR,
+                           float innerU, float innerD,
+                           ObjectSpan objects );
+
+    /*
+     * Arranges inners as a grid in the inner rect, and outers around the
+     * perimeter between the inner and outer rects.
+     */
+    bool focus( float outerL, float outerR, float outerU, float outerD,
+                float innerL, float innerR, float innerU, float innerD,
+                ObjectSpan outers, ObjectSpan inners );
+
+    /*
+     * Like focus, but makes the inner rect itself based on the aspect & scale
+     * options.
+     */
+    bool aspectFocus( float outerL, float outerR, float outerU, float outerD,
+                      ObjectSpan outers, ObjectSpan inners,
+                      const LayoutOptions& options = LayoutOptions() );
+
 };
 
 #endif /*LAYOUTMANAGER_H_*/
@@ -0,0 +1,111 @@
+/*
+ * @file LayoutWorker.h
+ *
+ * Runs LayoutManager arrangements on a separate thread. Requests take a
+ * snapshot of the objects' sizes & positions when they're made, the layout is
+ * done on the snapshot, and the resulting positions/sizes are applied to the
+ * real objects in one go from the main thread (via applyResults()), so a big
+ * rearrange doesn't stretch out a frame or keep the source lock held.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYOUTWORKER_H_
+#define LAYOUTWORKER_H_
+
+#include <vector>
+#include <deque>
+#include <map>
+
+#include <VPMedia/thread_helper.h>
+
+#include "LayoutManager.h"
+#include "RectangleBase.h"
+
+struct LayoutRequest;
+
+class LayoutWorker
+{
+
+public:
+    LayoutWorker();
+    ~LayoutWorker();
+
+    /*
+     * Start/stop the worker thread. When it isn't running, requests are done
+     * immediately on the calling thread instead (still applied on the next
+     * applyResults() though, so the behavior is the same either way). Stopping
+     * finishes anything still queued on the calling thread, so no requests
+     * get lost.
+     */
+    void start();
+    void stop();
+
+    /*
+     * Queue up a layout. Objects/inners have the same meaning as in
+     * LayoutManager::arrange. This copies the objects' current state, so it
+     * should be called with the source lock held, but doesn't hold onto the
+     * lists themselves.
+     */
+    void request( LayoutMethod method, RectangleBase outerRect,
+                  RectangleBase innerRect,
+                  ObjectSpan objects, ObjectSpan inners = ObjectSpan(),
+                  const LayoutOptions& options = LayoutOptions() );
+
+    /*
+     * Moves/resizes objects according to all layouts finished since the last
+     * call. Should be called from the main thread with the source lock held.
+     * Objects whose destination changed after the request was made (ie, the
+     * user moved them) are left alone, so an old layout doesn't undo that.
+     * Returns the number of objects updated.
+     */
+    int applyResults();
+
+    /*
+     * Drop any pending results for an object, ie because it's about to be
+     * deleted.
+     */
+    void forget( RectangleBase* object );
+
+private:
+    static void* threadMain( void* args );
+    void compute( LayoutRequest* req );
+
+    LayoutManager layouts;
+
+    // an object's destination as of the last result applied to it - if it's
+    // still there, nothing else has moved the object since. only used by
+    // applyResults and forget, with the source lock held
+    typedef struct AppliedDest
+    {
+        float x, y, width, height;
+    } AppliedDest;
+    std::map<RectangleBase*, AppliedDest> lastApplied;
+
+    std::deque<LayoutRequest*> pending;
+    std::vector<LayoutRequest*> finished;
+    LayoutRequest* current; // the one the thread is working on, if any
+    mutex* queueMutex;
+
+    thread* workerThread;
+    volatile bool running;
+
+};
+
+#endif /* LAYOUTWORKER_H_ */
@@ -0,0 +1,79 @@
+/*
+ * @file LockStats.h
+ *
+ * Keeps histograms of how long a lock was waited on and held for, so we can
+ * see how much contention there is on things like the source lock.
+ * Buckets are powers of two in microseconds.
+ *
+ * Note this doesn't do any locking of its own - it's meant to be updated by
+ * whoever holds the lock being measured.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCKSTATS_H_
+#define LOCKSTATS_H_
+
+#include <string>
+
+class LockStats
+{
+
+public:
+    LockStats();
+
+    void addWait( long us );
+    void addHold( long us );
+    void reset();
+
+    /*
+     * Approximate percentile (0-1) of hold/wait times, in microseconds - this
+     * is the upper end of the bucket the percentile falls in, so it's an
+     * overestimate by up to 2x.
+     */
+    long getHoldPercentile( float p );
+    long getWaitPercentile( float p );
+    long getMaxHold();
+    long getMaxWait();
+    unsigned long getNumLocks();
+
+    /*
+     * Print both histograms (as verbose messages), with the given name for the
+     * lock.
+     */
+    void log( std::string name );
+
+private:
+    static int getBucket( long us );
+    static long getPercentile( unsigned long* counts, unsigned long total,
+                               float p );
+    static void logHistogram( unsigned long* counts, unsigned long total );
+
+    // bucket i holds times < 2^i us, last one holds everything above that
+    static const int numBuckets = 21;
+    unsigned long waitCounts[ numBuckets ];
+    unsigned long holdCounts[ numBuckets ];
+    unsigned long numWaits;
+    unsigned long numHolds;
+    long maxWait;
+    long maxHold;
+
+};
+
+#endif /* LOCKSTATS_H_ */
@@ -0,0 +1,60 @@
+/*
+ * @file MeterBenchmark.h
+ *
+ * Times the AudioLevelMeter kernels (scalar vs SSE2/AVX2) on typical packet
+ * sizes, and checks they all get exactly the same results.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METERBENCHMARK_H_
+#define METERBENCHMARK_H_
+
+#include <vector>
+#include <stdint.h>
+
+class MeterBenchmark
+{
+
+public:
+    MeterBenchmark();
+
+    /*
+     * Runs all available kernels at all block sizes, logging the results.
+     * Returns false if any kernel disagreed with the scalar one.
+     */
+    bool run();
+
+private:
+    typedef void (*MeasureFunc)( const int16_t*, uint32_t, uint64_t&, int& );
+
+    /*
+     * Times func on blocks of num samples, returning ns per sample. Also
+     * checks its result for each block against the scalar kernel, counting
+     * mismatches.
+     */
+    double runKernel( const char* name, MeasureFunc func, uint32_t num,
+                      unsigned int& mismatches );
+
+    // a few seconds of fake speech-ish audio, walked through block by block
+    std::vector<int16_t> samples;
+
+};
+
+#endif /* METERBENCHMARK_H_ */
@@ -0,0 +1,126 @@
+/*
+ * @file MeterDecodeWorker.h
+ *
+ * Thread that measures levels for audio streams VPMedia can't give us a
+ * VPMAudioMeter for (see AudioMeterDecoder). The network thread only copies
+ * packets into a queue here; measuring them happens on this thread, so
+ * metering more streams doesn't slow down receiving.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METERDECODEWORKER_H_
+#define METERDECODEWORKER_H_
+
+#include <vector>
+#include <set>
+
+#include <VPMedia/thread_helper.h>
+
+#include "AudioCodecMeter.h"
+
+class MeterDecodeWorker;
+
+/*
+ * Level for one stream. level is written by the worker thread and can be read
+ * from anywhere without locking, like VPMAudioMeter::level(). Channels are
+ * deleted by the worker (see MeterDecodeWorker::releaseChannel) so packets
+ * still queued for one can't end up pointing at freed memory.
+ */
+typedef struct MeterChannel
+{
+    AudioCodecMeter::Codec codec;
+    MeterDecodeWorker* worker;
+
+    volatile float level;
+
+    // only touched by the worker thread
+    long lastPacketMS;
+} MeterChannel;
+
+class MeterDecodeWorker
+{
+
+public:
+    MeterDecodeWorker();
+    ~MeterDecodeWorker();
+
+    /*
+     * Start/stop the thread. Packets posted while it isn't running are
+     * dropped.
+     */
+    void start();
+    void stop();
+
+    MeterChannel* createChannel( AudioCodecMeter::Codec codec );
+    /*
+     * The channel will be deleted after any packets already queued for it
+     * are done, so this can be called right after its source goes away.
+     */
+    void releaseChannel( MeterChannel* channel );
+
+    /*
+     * Queue a packet payload for measuring. Only copies the data, so it's
+     * cheap to call from the network thread.
+     */
+    void post( MeterChannel* channel, const uint8_t* data, uint32_t length );
+
+    unsigned long getDroppedCount();
+
+    // if the queue backs up past this, new packets are dropped - it's only a
+    // meter, so losing a few is better than falling further behind
+    static const uint32_t maxQueuedBytes = 256 * 1024;
+    // channels that haven't had a packet in this long (ie, the sender has
+    // silence suppression on) drop to zero rather than keep their last level
+    static const long silenceTimeoutMS = 250;
+
+private:
+    // queued work - for packets, offset/length are the payload's place in
+    // the byte buffer that goes with the job list
+    typedef struct MeterJob
+    {
+        enum Type { PACKET, RELEASE };
+        Type type;
+        MeterChannel* channel;
+        uint32_t offset;
+        uint32_t length;
+    } MeterJob;
+
+    static void* threadMain( void* args );
+    void process( std::vector<MeterJob>& jobList,
+                  std::vector<uint8_t>& byteList, long nowMS );
+    void checkSilence( long nowMS );
+    static long getTimeMS();
+
+    // filled by post() on the network thread, swapped out by the worker so
+    // neither side allocates once they've grown to their steady state size.
+    // these and the channel set are protected by queueMutex
+    std::vector<MeterJob> jobs;
+    std::vector<uint8_t> bytes;
+    std::set<MeterChannel*> channels;
+    mutex* queueMutex;
+
+    volatile unsigned long dropped;
+
+    thread* workerThread;
+    volatile bool running;
+
+};
+
+#endif /* METERDECODEWORKER_H_ */
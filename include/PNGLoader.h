@@ -26,15 +26,52 @@
 #define PNGLOADER_H_
 
 #include <string>
+#include <cstddef>
+
+#include "GLUtil.h"
+
+/*
+ * Image decoded to RGBA, padded to power of two dimensions & flipped, so it's
+ * ready to go straight into glTexImage2D. The pixels are either allocated or
+ * mapped from the texture cache (see TextureCache) - either way they should
+ * be freed with PNGLoader::freeImage.
+ */
+typedef struct DecodedImage
+{
+    // size of the actual image, and of the padded area
+    int width, height;
+    int texWidth, texHeight;
+    unsigned char* pixels;
+
+    // if the pixels are in a mapped cache file, this is the whole mapping
+    void* mapping;
+    size_t mappingSize;
+} DecodedImage;
 
 namespace PNGLoader
 {
 
     /*
      * Reads in file from filename, passes it to libpng, and returns the
-     * ID associated with the allocated GL texture.
+     * ID associated with the allocated GL texture. If mipmap is set, mipmaps
+     * are generated for it (where the driver supports GL 1.4) so it can be
+     * drawn minified without shimmering.
+     * This goes through the texture cache, so it only actually decodes the
+     * file if it's new or has changed.
      */
-    GLuint loadPNG( std::string filename, int &width, int &height );
+    GLuint loadPNG( std::string filename, int &width, int &height,
+                    bool mipmap = false );
+
+    /*
+     * The two halves of loadPNG. decodePNG doesn't touch GL, so it's safe to
+     * call from any thread (and doesn't use the cache); uploadImage has to be
+     * on the GL thread. Both return false/0 on failure.
+     */
+    bool decodePNG( std::string filename, DecodedImage& image );
+    GLuint uploadImage( const DecodedImage& image, bool mipmap );
+
+    void initImage( DecodedImage& image );
+    void freeImage( DecodedImage& image );
 
 }
 
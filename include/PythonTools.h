@@ -4,6 +4,9 @@
  * Contains a bucket class with utilities to call python
  * Relied heavily on the python documentation available at:
  *      http://docs.python.org/extending/embedding.html
+ * Python all runs on its own interpreter thread, since the calls we make
+ * (ie, SOAP calls to the venue client) can take a while. Calls are queued
+ * with callAsync & the results picked up later from the PythonRequest.
  *
  * @author Ralph Bean
  * @modified Andrew Ford
@@ -33,6 +36,67 @@
 #include <vector>
 #include <map>
 
+#include <VPMedia/thread_helper.h>
+
+class PythonTools;
+
+/*
+ * A call queued to the interpreter thread. The result is converted to C++
+ * types on that thread, so nothing here touches python - all of it is safe to
+ * use from any thread.
+ */
+class PythonRequest
+{
+
+public:
+    enum ResultType
+    {
+        NO_RESULT,
+        STRING_RESULT,
+        MAP_RESULT
+    };
+
+    bool isDone();
+    /*
+     * Block until the call is done, or timeoutMS passes (-1 to wait forever).
+     * Returns isDone().
+     */
+    bool wait( int timeoutMS = -1 );
+
+    // these are only meaningful once isDone()
+    // false if python wasn't available or the call threw
+    bool succeeded();
+    // empty if the result was None or not a string
+    std::string getString();
+    std::map<std::string, std::string> getMap();
+
+    /*
+     * The caller has to call this when it's done with the request - it can be
+     * before the call finishes, in which case the result is thrown away.
+     */
+    void release();
+
+private:
+    PythonRequest( std::string s, std::string f,
+                   std::vector<std::string> a, ResultType t );
+
+    std::string script;
+    std::string func;
+    std::vector<std::string> args;
+    ResultType type;
+
+    std::string stringResult;
+    std::map<std::string, std::string> mapResult;
+    bool success;
+
+    // the caller & the queue both hold a reference
+    volatile int refs;
+    volatile bool done;
+
+    friend class PythonTools;
+
+};
+
 class PythonTools
 {
 
@@ -41,9 +105,40 @@ public:
     static void cleanup();
 
     // as of now, this disable is only meaningful before the python interpreter
-    // etc is initialized (ie, before getInstance is ever called)
+    // etc is initialized (ie, before the first callAsync)
     static bool disableInit;
 
+    /*
+     * Queue a call to function func in script, with args passed as python
+     * strings. Never blocks. See PythonRequest for what to do with the
+     * result. The first call starts up the interpreter thread - until then,
+     * getInstance etc. doesn't touch python at all.
+     */
+    PythonRequest* callAsync( std::string script, std::string func,
+            std::vector<std::string> args,
+            PythonRequest::ResultType type = PythonRequest::NO_RESULT );
+    PythonRequest* callAsync( std::string script, std::string func,
+            std::string arg,
+            PythonRequest::ResultType type = PythonRequest::NO_RESULT );
+    PythonRequest* callAsync( std::string script, std::string func,
+            PythonRequest::ResultType type = PythonRequest::NO_RESULT );
+
+protected:
+    PythonTools();
+    ~PythonTools();
+
+private:
+    static PythonTools* instance;
+
+    static void* threadMain( void* args );
+    void runRequest( PythonRequest* req );
+
+    /*
+     * Everything below here uses the python API, so should only be called on
+     * the interpreter thread.
+     */
+    bool initialize();
+
     PyObject* call( std::string _script, std::string _func, PyObject* args );
     PyObject* call( std::string _script, std::string _func, std::string arg );
     PyObject* call( std::string _script, std::string _func );
@@ -60,20 +155,20 @@ public:
     void inspect_dictionary( PyObject *dict );
     void inspect_object( PyObject *obj );
 
-protected:
-    PythonTools();
-    ~PythonTools();
-
-private:
-    static PythonTools* instance;
-
-    bool initialize();
-
     PyObject *main_m, *main_d; // dictionary/globals/locals for python
     std::string entryModule;
     std::string entryFunc;
 
-    bool init;
+    // only set by the interpreter thread, once it's started up
+    volatile bool init;
+
+    // protected by queueMutex
+    std::vector<PythonRequest*> queue;
+    mutex* queueMutex;
+
+    // NULL until the first call
+    thread* interpThread;
+    volatile bool running;
 
 };
 
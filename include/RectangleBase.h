@@ -52,6 +52,7 @@ enum TextStyle
 // reference each other
 class Group;
 class Point;
+class Frustum;
 
 class RectangleBase
 {
@@ -183,6 +184,17 @@ public:
     float getDestX(); float getDestY();
     float getScaleX(); float getScaleY();
     float getLat(); float getLon();
+    /*
+     * Set the geographical position, also updating the cached position on
+     * the unit sphere (see getEarthUnitPos).
+     */
+    void setLocation( float newLat, float newLon );
+    /*
+     * The lat/long as a position on the unit sphere, for Earth::convertUnit -
+     * this only changes when the location does, so the trig isn't redone for
+     * every object every frame.
+     */
+    void getEarthUnitPos( float& ux, float& uy, float& uz );
 
     /*
      * Returns the original aspect ratio of the object. Will be the aspect ratio
@@ -294,6 +306,31 @@ public:
      * GL draw function to render the object.
      */
     virtual void draw();
+
+    /*
+     * Set the view volume objects are tested against in draw() - anything
+     * entirely outside it just animates & isn't drawn. NULL (the default)
+     * draws everything.
+     */
+    static void setCullFrustum( Frustum* f );
+
+    /*
+     * Occluded objects (ie, under a fullscreened video) also just animate in
+     * draw(). Set by gravManager's occlusion pass each frame.
+     */
+    void setOccluded( bool o );
+    bool isOccluded();
+    // whether the position or size is still animating to its destination
+    bool isMoving();
+
+    /*
+     * Half the width & height of everything draw() might touch around the
+     * center (border & name) - the name can be wider than the object, and is
+     * above or below it depending on the style, so this is the biggest of
+     * each.
+     */
+    void getDrawExtent( float& halfWidth, float& halfHeight );
+
     /*
      * Draw main back texture, assumes position is set up beforehand
      * (ie, no pushmatrix/popmatrix, gltranslate, etc.
@@ -315,6 +352,7 @@ protected:
 
     // for global positioning
     float lat, lon;
+    float unitX, unitY, unitZ;
 
     RGBAColor borderColor;
     RGBAColor destBColor;
@@ -372,6 +410,14 @@ protected:
     bool animated;
     void animateValues();
 
+    // set by draw() - whether the object was outside the view volume or
+    // occluded, so subclasses can skip their own drawing too
+    bool culled;
+    bool occluded;
+    // test a sphere around everything draw() might touch (border & name)
+    bool isOutsideFrustum();
+    static Frustum* cullFrustum;
+
     bool positionAnimating;
     bool scaleAnimating;
     bool borderColAnimating;
@@ -0,0 +1,97 @@
+/*
+ * @file RenderThread.h
+ *
+ * Draws the main window on a thread of its own, so the wall keeps going while
+ * the GUI thread is busy with the side windows, menus, dialogs etc. The
+ * thread owns the GL context while it's running. Input events on the canvas
+ * are copied into a queue and handed to the InputHandler between frames, and
+ * resizes are passed over the same way. Anything else on the GUI thread that
+ * touches the scene has to hold gravManager::lockScene.
+ *
+ * Currently only for GTK (GLX), since the context has to be let go of on the
+ * main thread before the render thread can make it current.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RENDERTHREAD_H_
+#define RENDERTHREAD_H_
+
+#include <vector>
+
+#include <wx/wx.h>
+#include <VPMedia/thread_helper.h>
+
+class GLCanvas;
+class gravManager;
+class InputHandler;
+
+class RenderThread : public wxEvtHandler
+{
+
+public:
+    RenderThread( GLCanvas* c, gravManager* g, InputHandler* i );
+    ~RenderThread();
+
+    /*
+     * Takes the canvas' input over from the InputHandler & starts drawing on
+     * the new thread. Call from the main thread, after GL is initialized.
+     * Returns false (and leaves everything as it was) if a render thread
+     * isn't supported here.
+     */
+    bool start();
+    /*
+     * Waits for the current frame to finish, and gives the GL context back to
+     * the main thread for cleanup. Call from the main thread.
+     */
+    void stop();
+
+    // from the canvas' size event - the GL side is done before the next frame
+    void postResize( int w, int h );
+
+private:
+    static void* threadMain( void* args );
+    void run();
+
+    void queueKeyEvent( wxKeyEvent& evt );
+    void queueMouseEvent( wxMouseEvent& evt );
+    void queueEvent( wxEvent& evt );
+
+    // apply queued resizes & input, on the render thread
+    void processMessages();
+    void dispatch( wxEvent* evt );
+
+    GLCanvas* canvas;
+    gravManager* grav;
+    InputHandler* input;
+
+    // copies of input events, oldest first
+    std::vector<wxEvent*> pendingInput;
+    bool resizePending;
+    int resizeWidth, resizeHeight;
+    mutex* messageMutex;
+
+    thread* renderThread;
+    volatile bool running;
+
+    DECLARE_EVENT_TABLE()
+
+};
+
+#endif /* RENDERTHREAD_H_ */
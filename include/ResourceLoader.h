@@ -0,0 +1,86 @@
+/*
+ * @file ResourceLoader.h
+ *
+ * Loads textures in the background. Files are decoded (or pulled from the
+ * TextureCache) on worker threads, and the finished images are uploaded to GL
+ * later, from the GL thread, via uploadFinished - so a big image doesn't hold
+ * up startup or drawing.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCELOADER_H_
+#define RESOURCELOADER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "GLUtil.h"
+#include "PNGLoader.h"
+#include "WorkerPool.h"
+
+class ResourceLoader
+{
+
+public:
+    ResourceLoader();
+    ~ResourceLoader();
+
+    /*
+     * Queue a (full path) file to be loaded as texture name. Threads are
+     * started as needed, and exit once there's nothing left to do.
+     */
+    void requestTexture( std::string name, std::string fileName,
+                         bool mipmap );
+
+    /*
+     * Upload whatever's finished and add it to textures (or its name to
+     * failed, if it couldn't be loaded). Has to be called from the GL thread.
+     * Returns how many were added.
+     */
+    int uploadFinished( std::map<std::string, Texture>& textures,
+                        std::set<std::string>& failed );
+
+    // requested but not uploaded yet
+    int getPendingCount();
+
+    static const int maxThreads = 2;
+
+private:
+    class LoadJob : public WorkerJob
+    {
+    public:
+        LoadJob();
+        ~LoadJob();
+        void run();
+
+        std::string name;
+        std::string fileName;
+        bool mipmap;
+        bool loaded;
+        DecodedImage image;
+    };
+
+    WorkerPool* workers;
+
+};
+
+#endif /* RESOURCELOADER_H_ */
@@ -0,0 +1,90 @@
+/*
+ * @file SceneCommandQueue.h
+ *
+ * Lock-free queue for passing changes to the scene (adding/removing video
+ * sources, setting their site IDs, etc.) from the network thread to the main
+ * thread. Any number of threads can push commands without ever blocking, and
+ * the main thread takes everything queued so far in one go at the start of a
+ * frame, in the order it was pushed.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENECOMMANDQUEUE_H_
+#define SCENECOMMANDQUEUE_H_
+
+#include <string>
+#include <stdint.h>
+
+class VideoSource;
+class VPMSession;
+
+struct SceneCommand
+{
+    enum Type
+    {
+        ADD_SOURCE,
+        REMOVE_SOURCE,
+        SET_SITE_ID,
+        RENAME_SOURCE
+    };
+
+    SceneCommand( Type t );
+
+    Type type;
+
+    // the new source for ADD_SOURCE - for the rest, the source is looked up by
+    // session & ssrc when the command is run, since it might be gone by then
+    VideoSource* source;
+    VPMSession* session;
+    uint32_t ssrc;
+
+    // site ID for SET_SITE_ID
+    std::string data;
+
+    SceneCommand* next;
+};
+
+class SceneCommandQueue
+{
+
+public:
+    SceneCommandQueue();
+
+    /*
+     * Add a command to the queue. Safe to call from any thread, never blocks.
+     * The queue owns the command afterwards (until it's taken).
+     */
+    void push( SceneCommand* cmd );
+
+    /*
+     * Removes & returns everything pushed so far as a list (linked by next)
+     * in the order it was pushed, or NULL if the queue is empty. Only one
+     * thread should take from the queue.
+     */
+    SceneCommand* takeAll();
+
+private:
+    // most recently pushed command - the list runs newest to oldest until
+    // it's taken & reversed
+    SceneCommand* volatile head;
+
+};
+
+#endif /* SCENECOMMANDQUEUE_H_ */
@@ -31,6 +31,7 @@
 #include "RectangleBase.h"
 
 class VPMSessionListener;
+class VPMSession;
 
 class SessionEntry : public RectangleBase
 {
@@ -42,6 +43,19 @@ public:
     bool initSession( VPMSessionListener* listener );
     void disableSession();
 
+    /*
+     * For starting the session in the background (see SessionInitializer):
+     * startConnecting marks the entry as connecting, createSession does the
+     * slow part without touching any entry (so it's safe on another thread),
+     * and finishInit takes the result (NULL if it failed) & enables the
+     * entry. initSession is the same thing all at once.
+     */
+    void startConnecting();
+    static VPMSession* createSession( std::string address, bool audio,
+                                      VPMSessionListener* listener );
+    bool finishInit( VPMSession* s );
+    bool isConnecting();
+
     // note the difference between these two: if processingEnabled = false, the
     // session will still be active but not processed/iterated, but if
     // sessionEnabled = false, the session object is NULL (therefore you won't
@@ -60,6 +74,8 @@ public:
 
     std::string getAddress();
     uint32_t getTimestamp();
+    // NULL if not enabled
+    VPMSession* getSession();
 
     bool iterate();
 
@@ -75,11 +91,13 @@ private:
 
     bool processingEnabled;
     bool initialized;
+    bool connecting;
     // this should match with the failed color. will reset on disableSession()
     bool inFailedState;
 
     RGBAColor disabledColor;
     RGBAColor failedColor;
+    RGBAColor connectingColor;
 
     VPMSession* session;
     uint32_t sessionTS;
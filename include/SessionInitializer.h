@@ -0,0 +1,102 @@
+/*
+ * @file SessionInitializer.h
+ *
+ * Starts sessions in the background. Creating a VPMSession and initialising
+ * it means DNS lookups and socket/multicast setup, which can take a while per
+ * session - doing that on the main thread (inside the session lock) holds up
+ * drawing and the network thread, especially when adding a lot of sessions at
+ * once. Instead the entry goes into a connecting state, the session is
+ * started on a worker thread, and the main thread hands it to the entry with
+ * finish() once it's ready.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSIONINITIALIZER_H_
+#define SESSIONINITIALIZER_H_
+
+#include <string>
+#include <vector>
+
+#include "WorkerPool.h"
+
+class SessionEntry;
+class VPMSession;
+class VPMSessionListener;
+
+class SessionInitializer
+{
+
+public:
+    SessionInitializer();
+    ~SessionInitializer();
+
+    /*
+     * Queue entry's session to be started. Threads are started as needed, and
+     * exit once there's nothing left to do. The entry should be set to
+     * connecting (SessionEntry::startConnecting) beforehand.
+     */
+    void request( SessionEntry* entry, VPMSessionListener* listener );
+
+    /*
+     * Drop any request for entry. If its session is already being started,
+     * it'll be thrown away when it's done. Has to be called before an entry
+     * is deleted.
+     */
+    void cancel( SessionEntry* entry );
+
+    /*
+     * Give started sessions (or failures) to their entries. Main thread only,
+     * and inside the session lock, since the network thread starts iterating
+     * the sessions right after this. Entries that were finished are added to
+     * done.
+     */
+    void finish( std::vector<SessionEntry*>& done );
+
+    // whether finish has anything to do
+    bool hasFinished();
+
+    static const int maxThreads = 4;
+
+private:
+    class InitJob : public WorkerJob
+    {
+    public:
+        InitJob();
+        // deletes the session, unless it's been handed over
+        ~InitJob();
+        void run();
+
+        // NULL if cancelled. only touched on the main thread
+        SessionEntry* entry;
+        // copied from the entry so workers never touch it
+        std::string address;
+        bool audio;
+        VPMSessionListener* listener;
+        VPMSession* session;
+    };
+
+    WorkerPool* workers;
+
+    // everything requested & not finished yet, for cancel - main thread only
+    std::vector<InitJob*> outstanding;
+
+};
+
+#endif /* SESSIONINITIALIZER_H_ */
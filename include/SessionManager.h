@@ -37,6 +37,7 @@ class SessionTreeControl;
 class SessionGroup;
 class SessionGroupButton;
 class SessionEntry;
+class SessionInitializer;
 class gravManager;
 
 #include <vector>
@@ -64,8 +65,8 @@ public:
     /*
      * Add/remove a new session. Will auto-initialize if type = video or audio.
      * Returns true if creation/removal succeeds.
-     * In add's case, will return false if new session failed to
-     * initialize.
+     * In add's case, the session is started in the background, so failing to
+     * initialize shows up later (see finishSessionInits).
      * In remove's case, will return false if session was not found.
      */
     bool addSession( std::string addr, SessionType type );
@@ -108,12 +109,36 @@ public:
      */
     void sessionGroupButtonAction( SessionGroupButton* button );
 
+    /*
+     * The two above go through the session tree, which is a GUI control - if
+     * they come from a render thread (see RenderThread), they're held until
+     * this is called from the GUI thread. Locks the scene itself, and only if
+     * there's something waiting.
+     */
+    void applyPendingActions();
+
     /*
      * Used for checking if user-moved SessionEntries should be shifted between
      * groups or not. Public, thread-safe interface.
      */
     void checkGUISessionShift();
 
+    /*
+     * Hands sessions that finished starting in the background to their
+     * entries (so they start being iterated) and tells the tree about any
+     * that failed. Should be called each frame, from the main thread.
+     */
+    void finishSessionInits();
+
+    /*
+     * Moves rotation switches along: starts the next available session
+     * shortly before the rotate timer fires so it's already decoding when the
+     * rotate happens, and on rotate keeps the old session up until the new one
+     * has video, then crossfades. Should be called each frame, from the main
+     * thread.
+     */
+    void updateRotation();
+
     std::string getCurrentRotateSessionAddress();
     std::string getLastRotateSessionAddress();
 
@@ -121,6 +146,8 @@ public:
     bool isSessionProcessEnabled( std::string addr );
 
     bool isInFailedState( std::string addr, SessionType type );
+    // still being started in the background
+    bool isConnecting( std::string addr, SessionType type );
 
     bool setEncryptionKey( std::string addr, std::string key );
     bool disableEncryption( std::string addr );
@@ -162,6 +189,12 @@ private:
      */
     bool initSession( SessionEntry* session );
     void disableSession( SessionEntry* session );
+    /*
+     * Same as initSession, but the session's started on a worker thread &
+     * the entry shows as connecting until then. Returns true if queued (or
+     * already going).
+     */
+    bool initSessionAsync( SessionEntry* session );
 
     /*
      * Finds session by address. In cases of duplicate address, will find the
@@ -179,12 +212,32 @@ private:
      */
     bool shiftSession( SessionEntry* entry );
 
+    /*
+     * Make-before-break rotation (see updateRotation). startSwitch starts to
+     * (hidden) and leaves from up until to has video. Sessions are started
+     * through the initializer, and hidden in finishSessionInits once they're
+     * connected, so none of this blocks the GUI thread. stopSession also takes
+     * the session off standby in the object manager. forgetRotateSession is
+     * for when an entry is removed or moved out of available video, and
+     * settles any switch it's part of.
+     */
+    void startSwitch( SessionEntry* from, SessionEntry* to );
+    void prewarmNext();
+    void stopSession( SessionEntry* entry );
+    void forgetRotateSession( SessionEntry* entry );
+    static long getTimeMS();
+
     /*
      * The only reason we need this is for when entries get double clicked on -
      * we need to make sure the rotate call originates from the tree so its
      * display gets updated correctly.
      */
     SessionTreeControl* sessionTree;
+    // entry/button actions waiting for the GUI thread - set with the scene
+    // locked (ie, by the render thread while drawing)
+    std::string pendingRotateTo;
+    volatile bool rotateToPending;
+    volatile bool rotateTogglePending;
 
     SessionGroup* videoSessions;
     SessionGroup* availableVideoSessions;
@@ -204,7 +257,35 @@ private:
     int rotatePos;
     SessionEntry* lastRotateSession;
 
+    enum RotateState
+    {
+        ROTATE_IDLE,
+        // new session is running hidden, waiting for its first frame
+        ROTATE_WAITING,
+        // new session's shown, old one is fading out
+        ROTATE_FADING
+    };
+    RotateState rotateState;
+    // next session, started ahead of the rotate
+    SessionEntry* warmingSession;
+    bool prewarmTried;
+    SessionEntry* switchFrom;
+    SessionEntry* switchTo;
+    bool switchWarmed;
+    long switchStartMS;
+    long fadeStartMS;
+    long firstVideoMS;
+    // for the average switch time in the log
+    int switchCount;
+    long totalSwitchMS;
+    // how long before the rotate to start the next session, how long to wait
+    // for video before switching anyway, and how long the crossfade takes
+    static const long prewarmMS = 5000;
+    static const long switchTimeoutMS = 10000;
+    static const long crossfadeMS = 600;
+
     mutex* sessionMutex;
+    SessionInitializer* initializer;
     int lockCount;
     bool pause;
 
@@ -30,6 +30,8 @@
 #define SESSIONTREECONTROL_H_
 
 #include <wx/treectrl.h>
+#include <string>
+#include <map>
 
 class SessionManager;
 class RotateTimer;
@@ -46,8 +48,15 @@ public:
 
     void addSession( std::string address, bool audio, bool rotate );
     void removeSession( std::string address );
+    // looked up in the index, but only returns sessions under root
     wxTreeItemId findSession( wxTreeItemId root, std::string address );
 
+    /*
+     * For sessions started in the background - marks the session as failed
+     * (red) if it didn't start.
+     */
+    void sessionInitFinished( std::string address, bool success );
+
     /*
      * Moves a session from regular to available or vice-versa.
      */
@@ -95,6 +104,11 @@ public:
     static int disableEncryptionID;
 
 private:
+    // the old way, by walking the tree
+    wxTreeItemId searchSession( wxTreeItemId root, std::string address );
+    // for after item's been deleted
+    void forgetSession( std::string address, wxTreeItemId item );
+
     wxTreeItemId rootID;
     wxTreeItemId videoNodeID;
     wxTreeItemId audioNodeID;
@@ -102,6 +116,9 @@ private:
 
     SessionManager* sessionManager;
 
+    // address -> item, so finding sessions doesn't mean walking the tree
+    std::map<std::string, wxTreeItemId> sessionItems;
+
     RotateTimer* timer;
     int rotateInterval;
 
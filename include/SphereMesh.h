@@ -0,0 +1,72 @@
+/*
+ * @file SphereMesh.h
+ *
+ * A textured sphere (or a lat/long rectangle of one) as a vertex/index
+ * buffer, for drawing the earth at different levels of detail. The layout
+ * and texture coordinates match what gluSphere does (z is the pole axis, s
+ * goes around, t goes from the -z pole up to +z), so the same equirectangular
+ * textures work on it.
+ *
+ * Uses VBOs when the GL has them, client-side arrays otherwise.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPHEREMESH_H_
+#define SPHEREMESH_H_
+
+#include <vector>
+
+#include "GLUtil.h"
+
+class SphereMesh
+{
+
+public:
+    /*
+     * The part of the sphere covered is given in image coordinates of an
+     * equirectangular map - u from 0 (-180 longitude) to 1 (180), v from 0
+     * (north pole) to 1 (south pole) - so (0, 0, 1, 1) is the whole sphere.
+     * Texture coordinates go from 0 to 1 across the part covered, the same
+     * way they would across a whole map image loaded by PNGLoader (ie, t=1 is
+     * the top edge).
+     * cols/rows is the number of quads across/down.
+     */
+    SphereMesh( float radius, float u0, float v0, float du, float dv,
+                int cols, int rows );
+    ~SphereMesh();
+
+    void draw();
+
+    unsigned int getNumTriangles();
+
+    static bool haveVBOs();
+
+private:
+    // interleaved x,y,z,s,t
+    std::vector<GLfloat> verts;
+    std::vector<GLushort> indices;
+    unsigned int numIndices;
+
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+
+};
+
+#endif /* SPHEREMESH_H_ */
@@ -0,0 +1,75 @@
+/*
+ * @file TextureCache.h
+ *
+ * On-disk cache of decoded images, so textures that have been loaded before
+ * can skip PNG decoding. Entries are keyed by a hash of the PNG file's
+ * contents (so changing a file just makes a new entry) and hold the pixels
+ * already converted, flipped and padded, ready to upload - loading one is
+ * just mapping the file.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXTURECACHE_H_
+#define TEXTURECACHE_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "PNGLoader.h"
+
+class TextureCache
+{
+
+public:
+    /*
+     * Sets up the cache directory ($XDG_CACHE_HOME/grav, or ~/.cache/grav),
+     * creating it if needed. Should be called once at startup, before any
+     * loading - if it isn't, or if enable is false, load just decodes.
+     */
+    static void init( bool enable );
+
+    /*
+     * Fill in image from the cache if the file's in it, otherwise decode the
+     * file and add it. Safe to call from multiple threads at once.
+     */
+    static bool load( std::string filename, DecodedImage& image );
+
+    static bool isEnabled();
+    static std::string getDirectory();
+
+    // bump this if the pixel format/layout in the files changes
+    static const uint32_t version = 1;
+
+private:
+    static bool hashFile( std::string filename, uint64_t& hash );
+    static bool readEntry( std::string entry, uint64_t hash,
+                           DecodedImage& image );
+    static bool writeEntry( std::string entry, uint64_t hash,
+                            const DecodedImage& image );
+    static long getTimeMS();
+
+    static bool enabled;
+    static std::string directory;
+    // for making unique temp file names
+    static volatile int tempCounter;
+
+};
+
+#endif /* TEXTURECACHE_H_ */
@@ -27,8 +27,10 @@
 #define TIMERS_H_
 
 #include <wx/timer.h>
+#include <stdint.h>
 
 class SessionTreeControl;
+class TreeControl;
 class GLCanvas;
 
 class RenderTimer : public wxTimer
@@ -41,6 +43,8 @@ public:
 
     // print number of microseconds since last call
     void printTiming();
+    // microseconds since the last resetTiming (on the monotonic clock, see
+    // FrameScheduler)
     time_t getTiming();
     void resetTiming();
 
@@ -50,8 +54,7 @@ private:
     // interval between timer firing, in milliseconds
     int interval;
 
-    struct timeval time;
-    time_t lastTimeMS;
+    int64_t lastTimeUS;
 
 };
 
@@ -65,6 +68,8 @@ public:
     bool Start( int milliseconds = -1, bool oneShot = false );
 
     float getProgress();
+    // ms until the next rotate, or -1 if not running
+    long getTimeLeft();
 
 private:
     void Notify();
@@ -76,4 +81,21 @@ private:
 
 };
 
+/*
+ * One-shot timer for applying queued changes to the object tree - see
+ * TreeControl::scheduleSync.
+ */
+class TreeSyncTimer : public wxTimer
+{
+
+public:
+    TreeSyncTimer( TreeControl* t );
+
+private:
+    void Notify();
+
+    TreeControl* tree;
+
+};
+
 #endif /* TIMERS_H_ */
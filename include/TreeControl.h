@@ -28,9 +28,11 @@
 
 #include <wx/treectrl.h>
 #include <string>
+#include <map>
 
 class gravManager;
 class RectangleBase;
+class TreeSyncTimer;
 
 class TreeControl : public wxTreeCtrl
 {
@@ -42,11 +44,42 @@ public:
 
     ~TreeControl();
 
+    /*
+     * These only queue the change, since they get called from the render
+     * frame - the widget itself is updated by applyChanges, at most every
+     * syncIntervalMS. Adds & renames of the same object are merged, and
+     * removing an object drops anything still queued for it, so it's safe to
+     * delete the object right after removing it.
+     */
     void addObject( RectangleBase* obj );
     void removeObject( RectangleBase* obj );
+    // (doesn't add the object if it isn't in the tree)
+    void updateObjectName( RectangleBase* obj );
+
+    // looked up in the index - root is only there for compatibility, the
+    // whole tree is searched. note this is what's in the widget, so it won't
+    // include anything still queued
     wxTreeItemId findObject( wxTreeItemId root, RectangleBase* obj );
 
-    void updateObjectName( RectangleBase* obj );
+    /*
+     * Apply everything queued by the functions above to the widget. Called by
+     * the sync timer on the main thread.
+     */
+    void applyChanges();
+    /*
+     * Starts the sync timer if something was queued from a render thread
+     * (see RenderThread). Call regularly from the GUI thread - locks the
+     * scene itself, and only if there's something waiting.
+     */
+    void startDeferredSync();
+
+    /*
+     * Between these, sorts (from adds & renames) are saved up & each parent
+     * is only sorted once at the end, and the control isn't redrawn. For
+     * when a lot of changes come in at once. These can be nested.
+     */
+    void beginBatch();
+    void endBatch();
 
     /*
      * Overrides the wxTreeCtrl's compare function to implement a custom
@@ -58,9 +91,41 @@ public:
     void setSourceManager( gravManager* g );
 
 private:
+    void scheduleSync();
+    // put a queued object where it belongs & update its name, adding it if
+    // add is set and it isn't there yet
+    void syncObject( RectangleBase* obj, bool add );
+    // delete an item whose object was removed, moving any remaining
+    // children (ie, of a group) back to be re-added
+    void deleteItem( wxTreeItemId item );
+
+    wxTreeItemId appendObject( wxTreeItemId parentID, RectangleBase* obj );
+    // drop index entries for everything under item (not item itself)
+    void forgetChildren( wxTreeItemId item );
+    void sortChildren( wxTreeItemId item );
+
     wxTreeItemId rootID;
     gravManager* sourceManager;
 
+    // object -> its item, so finding things doesn't mean walking the tree
+    std::map<RectangleBase*, wxTreeItemId> itemIndex;
+
+    int batchDepth;
+    // parents waiting to be sorted at the end of the batch, by item ID
+    std::map<void*, wxTreeItemId> pendingSorts;
+
+    // queued adds (true) & renames (false) - only live objects are in here,
+    // since removeObject takes them out
+    std::map<RectangleBase*, bool> pendingObjects;
+    // items of removed objects (already out of the index & unhooked from
+    // their objects) waiting to be deleted, by item ID
+    std::map<void*, wxTreeItemId> pendingRemovals;
+
+    TreeSyncTimer* syncTimer;
+    bool syncScheduled;
+    volatile bool syncDeferred;
+    static const int syncIntervalMS = 250;
+
 };
 
 #endif /*TREECONTROL_H_*/
@@ -36,6 +36,8 @@ class TreeNode : public wxTreeItemData
 public:
     TreeNode( RectangleBase* obj, bool session );
     RectangleBase* getObject();
+    // for unhooking an object that's about to be deleted
+    void setObject( RectangleBase* obj );
 
 private:
     bool isSession;
@@ -56,19 +56,34 @@ public:
                     std::vector<RectangleBase*>::iterator i, bool move = true );
 
     /*
-     * Attempt to find the first valid venue client via AGTools. If it fails,
-     * return false and set internal venue client URL to "".
+     * Whether there was a valid venue client (found via AGTools) as of the
+     * last refresh - if that was too long ago, a new one is started, but this
+     * never waits for it.
      * Will automatically hide if there is no venue client found. The bool
      * argument determines animation for this.
      */
     bool tryGetValidVenueClient( bool instantHide = false );
 
-    void updateExitMap();
+    /*
+     * Refetch the venue client URL & venue name, and the exits & streams if
+     * the venue changed (or full is set). All the python calls are done on
+     * the interpreter thread, and the results get picked up by checkRequests.
+     */
+    void refresh( bool full );
+    /*
+     * Pick up the results of any finished python calls & act on them. Should
+     * be called each frame, from the main thread.
+     */
+    void checkRequests();
+
     void printExitMap();
 
     void enterVenue( std::string venueName );
-    void updateVenueStreams();
-    void updateVenueName();
+    /*
+     * Refetch the venue's streams, and add them once they're in if add is
+     * set.
+     */
+    void updateVenueStreams( bool add = false );
     void removeAllVenueStreams();
     void addAllVenueStreams();
 
@@ -80,6 +95,15 @@ public:
     void setSessionControl( SessionTreeControl* s );
 
 private:
+    // the part of show() that acts on the cached venue info
+    void applyShow( bool s, bool instant );
+    // remakes the venue nodes from exitMap
+    void updateExitNodes();
+    // done refreshing - do whatever was waiting on it
+    void finishRefresh();
+    bool isRefreshing();
+    static long getTimeMS();
+
     std::map<std::string, std::string> exitMap;
     std::string currentVenue;
     // map of addresses to encryption keys
@@ -91,6 +115,22 @@ private:
     PythonTools* pyTools;
     std::string AGToolsScript;
 
+    // outstanding python calls, NULL if not waiting on one
+    PythonRequest* clientRequest;
+    PythonRequest* nameRequest;
+    PythonRequest* exitsRequest;
+    PythonRequest* streamsRequest;
+    PythonRequest* enterRequest;
+
+    // the venue info above is cached for this long before being refetched
+    static const long cacheTTLMS = 10000;
+    long lastRefreshMS;
+    bool haveRefreshed;
+    bool fullRefresh;
+    // things waiting on the refresh to finish
+    bool pendingShow;
+    bool pendingAddStreams;
+
     gravManager* grav;
 
     SessionTreeControl* sessionControl;
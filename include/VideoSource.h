@@ -30,6 +30,7 @@
 #include <VPMedia/video/VPMVideoBufferSink.h>
 #include <VPMedia/VPMSession.h>
 #include <VPMedia/VPMedia_config.h>
+#include <VPMedia/thread_helper.h>
 
 #include "RectangleBase.h"
 
@@ -92,8 +93,23 @@ public:
     void setRendering( bool r );
     bool getRendering();
 
+    // whether a frame has been decoded yet (safe to call without drawing)
+    bool hasVideo();
+
+    /*
+     * Stops using the video sink, for when VPMedia is about to delete it.
+     * Safe to call from any thread. Until the source is taken out of the
+     * scene, only the RectangleBase parts (border, name) get drawn - the
+     * video area is left empty, so it stops counting as opaque.
+     */
+    void detachSink();
+
+    // whether the video fully hides what's under it (ie, not fading, and
+    // there's still a sink to draw from)
+    bool isOpaque();
+
     // override RectangleBase::show to affect alpha usage for video rendering
-    void show( bool s, bool instant );
+    void show( bool s, bool instant = false );
 
 private:
     // reference to the session that this video comes from - needed for grabbing
@@ -105,8 +121,10 @@ private:
     // synchronization source, from rtp
     uint32_t ssrc;
 
-    // the source of the video data
+    // the source of the video data - NULL once detached. held by draw while
+    // it's using the sink, so detachSink can't pull it out from under it
     VPMVideoBufferSink* videoSink;
+    mutex* sinkMutex;
 
     // original dimensions of the video
     unsigned int vwidth, vheight;
@@ -126,9 +144,15 @@ private:
 
     // whether the texture push is enabled
     bool enableRendering;
+    // set when the texture push was skipped for being out of view, so the
+    // current frame gets pushed once it's back even if it isn't new
+    bool staleTexture;
 
     // whether to apply color's alpha to video
     bool useAlpha;
+    // still fading in after being shown - the video goes to full opacity
+    // while the border goes to its usual alpha
+    bool fadingIn;
 };
 
 #endif /* VIDEOSOURCE_H_ */
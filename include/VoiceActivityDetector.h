@@ -0,0 +1,76 @@
+/*
+ * @file VoiceActivityDetector.h
+ *
+ * Decides whether an audio stream (or group of streams) is someone talking,
+ * based on its meter level over time. The level is smoothed, and there's
+ * hysteresis in both level (separate on/off thresholds) and time (the level
+ * has to stay up for a bit before counting as speech, and stay down for a
+ * while before speech is considered over, and once someone counts as
+ * speaking they stay that way for a minimum time) so that background noise
+ * and short pauses don't flip the state back and forth.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VOICEACTIVITYDETECTOR_H_
+#define VOICEACTIVITYDETECTOR_H_
+
+class VoiceActivityDetector
+{
+
+public:
+    VoiceActivityDetector();
+
+    /*
+     * Feed in a new meter level, taken at the given time (in ms, from any
+     * monotonic-ish source as long as it's consistent). Returns true if this
+     * changed whether the stream counts as speaking.
+     */
+    bool update( float level, long timeMS );
+
+    bool isSpeaking();
+    float getSmoothedLevel();
+
+    void reset();
+
+    // level above which the smoothed level counts as (possible) speech, and
+    // below which it counts as (possible) silence
+    static const float onThreshold;
+    static const float offThreshold;
+    // how long the level has to stay above/below the thresholds before the
+    // state changes
+    static const long attackMS;
+    static const long releaseMS;
+    // once speaking, stay speaking at least this long
+    static const long minHoldMS;
+    // time constant for the level smoothing
+    static const float smoothingMS;
+
+private:
+    float smoothed;
+    bool speaking;
+    bool haveTime;
+    long lastTimeMS;
+    long aboveSinceMS; // -1 if not currently above onThreshold
+    long belowSinceMS; // -1 if not currently below offThreshold
+    long speakingSinceMS;
+
+};
+
+#endif /* VOICEACTIVITYDETECTOR_H_ */
@@ -0,0 +1,100 @@
+/*
+ * @file WorkerPool.h
+ *
+ * A small pool of worker threads for jobs that shouldn't hold up the thread
+ * that asks for them (ie, loading images, starting sessions). Threads are
+ * started as jobs come in, up to a maximum, and exit once the queue is empty,
+ * so an idle pool doesn't keep any threads around. Finished jobs wait until
+ * the owner takes them, usually once per frame.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <vector>
+
+#include <VPMedia/thread_helper.h>
+
+class WorkerJob
+{
+
+public:
+    virtual ~WorkerJob() { }
+
+    // does the actual work, on one of the pool's threads
+    virtual void run() = 0;
+
+};
+
+class WorkerPool
+{
+
+public:
+    WorkerPool( int maxThreads );
+    /*
+     * Workers finish the job they're on, then exit. Anything that hasn't been
+     * taken by then (run or not) is deleted.
+     */
+    ~WorkerPool();
+
+    /*
+     * Queue a job, starting another thread if there's room. The pool owns
+     * the job until it's taken back with takeFinished or remove.
+     * push, remove, takeFinished & hasFinished should all be called from the
+     * same (owner's) thread.
+     */
+    void push( WorkerJob* job );
+
+    /*
+     * Takes a job back out of the queue if it hasn't been started yet, and
+     * returns whether it did.
+     */
+    bool remove( WorkerJob* job );
+
+    // add jobs that have run to done, oldest first. they belong to the caller
+    void takeFinished( std::vector<WorkerJob*>& done );
+    bool hasFinished();
+
+    // pushed but not taken yet
+    int getPendingCount();
+
+private:
+    static void* threadMain( void* args );
+    // joins threads that have exited, if they all have
+    void reapThreads();
+
+    int maxThreads;
+
+    // protected by queueMutex
+    std::vector<WorkerJob*> queued;
+    std::vector<WorkerJob*> finished;
+    int activeThreads;
+    int pendingCount;
+    mutex* queueMutex;
+
+    // only touched on the owner's thread
+    std::vector<thread*> threads;
+
+    volatile bool running;
+
+};
+
+#endif /* WORKERPOOL_H_ */
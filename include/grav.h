@@ -48,6 +48,7 @@ class SessionManager;
 class VenueClientController;
 class Earth;
 class InputHandler;
+class RenderThread;
 
 class gravApp : public wxApp
 {
@@ -63,6 +64,17 @@ private:
      */
     virtual bool OnInit();
     virtual int OnExit();
+    /*
+     * Overridden so a benchmark run can skip the main loop & give its result
+     * as the exit status - see benchmarkOnly.
+     */
+    virtual int OnRun();
+
+    /*
+     * Overridden to set up Xlib for a render thread, if asked for, before wx
+     * opens the display.
+     */
+    virtual bool Initialize( int& argc, wxChar** argv );
 
     DECLARE_EVENT_TABLE()
 
@@ -98,6 +110,7 @@ private:
 
     GLCanvas* canvas;
     RenderTimer* timer;
+    RenderThread* renderThread;
     TreeControl* sourceTree;
     SessionTreeControl* sessionTree;
 
@@ -144,11 +157,22 @@ private:
 
     bool enableShaders;
     bool bufferFont;
+    bool useVSync;
+    bool useRenderThread;
+    bool useTextureCache;
 
     bool startFullscreen;
 
     bool getAGVenueStreams;
 
+    bool runLayoutBenchmark;
+    std::string layoutBenchmarkSnapshot;
+    bool runMeterBenchmark;
+    // set if a benchmark ran instead of the GUI - nothing else is set up then,
+    // and the process exits with exitCode (nonzero if the benchmark failed)
+    bool benchmarkOnly;
+    int exitCode;
+
     int windowWidth, windowHeight;
 
     int startX, startY;
@@ -217,6 +241,17 @@ static const wxCmdLineEntryDesc cmdLineDesc[] =
             _("framerate for rendering"), wxCMD_LINE_VAL_NUMBER
     },
 
+    {
+        wxCMD_LINE_SWITCH, _("nvs"), _("no-vsync"),
+            _("don't sync rendering to the display refresh rate")
+    },
+
+    {
+        wxCMD_LINE_SWITCH, _("rt"), _("render-thread"),
+            _("draw on a separate thread, so the main window keeps updating "
+              "while the side windows are in use (experimental, Linux only)")
+    },
+
     {
         wxCMD_LINE_SWITCH, _("fs"), _("fullscreen"),
             _("start in fullscreen mode")
@@ -292,6 +327,30 @@ static const wxCmdLineEntryDesc cmdLineDesc[] =
             wxCMD_LINE_VAL_NUMBER
     },
 
+    {
+        wxCMD_LINE_SWITCH, _("lb"), _("layout-benchmark"),
+            _("time the layout algorithms with increasing numbers of objects "
+              "and exit")
+    },
+
+    {
+        wxCMD_LINE_OPTION, _("lbs"), _("layout-benchmark-snapshot"),
+            _("file of layout positions for the layout benchmark to check "
+              "against (written if it doesn't exist)"),
+            wxCMD_LINE_VAL_STRING
+    },
+
+    {
+        wxCMD_LINE_SWITCH, _("mb"), _("meter-benchmark"),
+            _("time the audio level meter (scalar vs SIMD) and exit")
+    },
+
+    {
+        wxCMD_LINE_SWITCH, _("ntc"), _("no-texture-cache"),
+            _("always decode images rather than using (or filling) the "
+              "decoded image cache")
+    },
+
     {
         wxCMD_LINE_PARAM, NULL, NULL, _("video address"),
             wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_MULTIPLE
@@ -29,6 +29,8 @@
 #include <wx/wx.h>
 #include <vector>
 #include <map>
+#include <set>
+#include <stdint.h>
 
 #include "RectangleBase.h"
 #include "GLCanvas.h"
@@ -45,12 +47,28 @@ class Earth;
 class InputHandler;
 class TreeControl;
 class LayoutManager;
+class IncrementalGridLayout;
+class LayoutWorker;
+class SceneCommandQueue;
+class LockStats;
+class DrawOrder;
+struct SceneCommand;
 class Runway;
 class VenueClientController;
 class SessionManager;
 class Camera;
 class Point;
 
+/*
+ * Vertices (xyz) & colors (rgba) for a bunch of earth points or lines, so they
+ * can all be sent to GL in one call.
+ */
+typedef struct EarthBatch
+{
+    std::vector<GLfloat> verts;
+    std::vector<GLfloat> colors;
+} EarthBatch;
+
 class gravManager
 {
 
@@ -64,6 +82,15 @@ public:
      */
     void draw();
 
+    /*
+     * Per-frame session work that also updates the session tree: moved
+     * session entries, finished session starts, rotation & venue client
+     * results. Called from draw(), or with a render thread (see
+     * RenderThread), from the GUI thread - the scene gets locked only around
+     * the parts that change it.
+     */
+    void updateSessions();
+
     void clearSelected();
     void ungroupAll();
 
@@ -79,16 +106,22 @@ public:
      * Bool val is used when checking the object's group to prevent infinite
      * loops - group checking is done to move groups to top when moving group
      * members to top.
-     * Note these are NOT thread-safe, lockSources() should be called around
-     * them.
+     * Note this is NOT thread-safe, lockSources() should be called around
+     * it.
      */
     void moveToTop( RectangleBase* object, bool checkGrouping = true );
-    void moveToTop( std::vector<RectangleBase*>::iterator i,
-                        bool checkGrouping = true );
 
-    void drawCurvedEarthLine( float lat, float lon,
-                              float destx, float desty, float destz );
-    void drawEarthPoint( float lat, float lon, float size );
+    /*
+     * Add a point on the earth at the object's location, or a line from there
+     * to the object, to a batch. Nothing is drawn until drawEarthBatch.
+     */
+    void addEarthPoint( RectangleBase* object, EarthBatch& batch );
+    void addCurvedEarthLine( RectangleBase* object, EarthBatch& batch );
+    /*
+     * Draw everything in the batch (as GL_POINTS or GL_LINES) with a single
+     * draw call, and empty it. Size is the point size/line width.
+     */
+    void drawEarthBatch( EarthBatch& batch, GLenum mode, float size );
 
     void setBoxSelectDrawing( bool draw );
     int getWindowWidth(); int getWindowHeight();
@@ -118,9 +151,11 @@ public:
      * Getters for accessing sources/objects. (Note these are actual lifetime,
      * non-ephemeral lists, ie this class will keep these around and modify
      * them)
+     * The drawn objects list is read-only - use addToDrawList/removeFromLists/
+     * moveToTop to change it.
      */
     std::vector<VideoSource*>* getSources();
-    std::vector<RectangleBase*>* getDrawnObjects();
+    const std::vector<RectangleBase*>* getDrawnObjects();
     std::vector<RectangleBase*>* getSelectedObjects();
     std::map<std::string,Group*>* getSiteIDGroups();
 
@@ -137,17 +172,49 @@ public:
 
     /*
      * Manage sources in the main list of sources as well as in the lists of
-     * drawn & selected objects.
-     * Latter is an iterator so as not to have to loop through the list of
-     * sources twice - mainly because the delete-by-ssrc in videolistener
-     * needs to find its target that way.
-     * I.e., delete expects that the caller will find the source in the
-     * sources list itself.
+     * drawn & selected objects. These are meant to be called from the
+     * VideoListener callbacks (ie, the network thread): they queue a command
+     * that gets run on the main thread at the start of the next draw, so they
+     * don't need the source lock and never wait for a frame to finish.
+     * Since VPMedia deletes the source's video sink right after the delete
+     * callback returns, removeSource detaches the sink from the source before
+     * queueing the rest of the removal. It returns whether the source was
+     * found.
+     * If called from the main thread, commands are run immediately.
      */
     void addNewSource( VideoSource* s );
-    void deleteSource( std::vector<VideoSource*>::iterator si );
+    bool removeSource( VPMSession* session, uint32_t ssrc );
+    void setSourceSiteID( VPMSession* session, uint32_t ssrc,
+                          std::string siteID );
+    void renameSource( VPMSession* session, uint32_t ssrc );
     void deleteGroup( Group* g );
 
+    /*
+     * Runs all commands queued by the functions above. Called by draw(); only
+     * call this from the thread that draws, with the source lock held.
+     */
+    void processCommands();
+
+    /*
+     * Sources from a session on standby are kept out of the scene - not drawn
+     * or in the tree - until revealSession is called, so a session can be
+     * started ahead of time and have its video decoding before it's shown.
+     * Set standby right after starting the session. These are all main
+     * thread only, and do their own locking.
+     */
+    void setSessionStandby( VPMSession* session, bool standby );
+    /*
+     * Whether any of the session's standby sources has decoded a frame yet.
+     */
+    bool sessionHasVideo( VPMSession* session );
+    /*
+     * Take a session off standby & put its sources in the scene. If
+     * replacing is set, the new sources take the places of that session's
+     * sources, fading in as those fade out (the replaced session should be
+     * stopped once the fade's done). Returns how many sources were shown.
+     */
+    int revealSession( VPMSession* session, VPMSession* replacing );
+
     /*
      * Note these are NOT thread-safe, lockSources() should be called around
      * them.
@@ -186,8 +253,38 @@ public:
     void lockSources();
     void unlockSources();
 
+    /*
+     * Wait & hold time histograms for the source lock.
+     */
+    LockStats* getLockStats();
+
     void setThreads( bool threads );
 
+    /*
+     * With a render thread, the scene is only touched by that thread while
+     * it's drawing a frame (between beginFrame & endFrame), or by the GUI
+     * thread while it holds lockScene. Recursive on the GUI thread, and does
+     * nothing on the render thread itself or if there is no render thread.
+     * Lock order is scene, then sessions, then sources.
+     */
+    void lockScene();
+    void unlockScene();
+    void beginFrame();
+    void endFrame();
+
+    /*
+     * Set before starting a render thread & after it's stopped. The render
+     * thread calls claimRenderThread when it starts.
+     */
+    void setRenderThreaded( bool r );
+    bool isRenderThreaded();
+    void claimRenderThread();
+    /*
+     * Whether this is the thread that draws - the main thread, unless there's
+     * a render thread.
+     */
+    bool isRenderThread();
+
     bool usingRunway();
     bool usingGridAuto();
     bool usingAutoFocusRotate();
@@ -205,31 +302,101 @@ public:
 
 private:
     /*
-     * Delete video sources set to be deleted. This should ONLY be called from
-     * the main thread (ie, in draw()) since that's the whole point of having
-     * this - we need to do VideoSource deletes on the main thread since it does
-     * a GL call to delete its texture.
+     * Run a single queued command - see processCommands.
+     */
+    void runCommand( SceneCommand* cmd );
+    VideoSource* findSource( VPMSession* session, uint32_t ssrc );
+    void doAddSource( VideoSource* s );
+    /*
+     * Add a source to the lists & tree. If place is set, lays it out the
+     * same way as a new source.
+     */
+    void addToScene( VideoSource* s, bool place );
+    bool isStandby( VideoSource* s );
+    void doDeleteSource( VideoSource* s );
+    void doSetSiteID( VideoSource* s, std::string siteID );
+
+    /*
+     * Queue a command from any thread. If this thread is the one drawing, or
+     * the GUI thread with the scene locked, runs the queue right away.
+     */
+    void postCommand( SceneCommand* cmd );
+    bool ownsScene();
+
+    /*
+     * Puts new movable objects into the automatic grid (& takes out old ones),
+     * only moving everything if the grid size has to change.
+     * Not thread-safe, lockSources() should be called around this.
+     */
+    void updateGridAuto();
+
+    /*
+     * Marks which objects in renderObjects are completely hidden under an
+     * opaque video above them (ie, a fullscreened one, or stacked videos),
+     * so they can skip drawing & their texture pushes. Only looks at the
+     * objects' current positions, so things that are moving are always
+     * drawn.
      */
-    void doDelayedDelete();
+    void updateOcclusion();
+    bool coveredBy( RectangleBase* obj,
+                    const std::vector<VideoSource*>& occluders );
 
     std::vector<VideoSource*>* sources;
-    std::vector<RectangleBase*>* drawnObjects;
+    DrawOrder* drawnObjects;
     std::vector<RectangleBase*>* selectedObjects;
     std::map<std::string,Group*>* siteIDGroups;
 
-    std::vector<RectangleBase*>* objectsToDelete;
-    std::vector<RectangleBase*>* objectsToAddToTree;
-    std::vector<RectangleBase*>* objectsToRemoveFromTree;
+    // for finding sources by their session & ssrc without going through the
+    // whole list
+    typedef std::pair<VPMSession*, uint32_t> SourceKey;
+    std::map<SourceKey, VideoSource*> sourceIndex;
+
+    // see setSessionStandby - standby sources are in the index but not the
+    // main list. main thread only
+    std::set<VPMSession*> standbySessions;
+    std::vector<VideoSource*> standbySources;
+
+    // changes coming in from the network thread, to be run on the main
+    // thread (since that's where WX & GL calls need to be)
+    SceneCommandQueue* commands;
+
+    // every source whose video sink VPMedia hasn't deleted yet, including
+    // ones still queued to be added - removeSource detaches the sink through
+    // this straight away. only touched by the VideoListener callbacks, under
+    // sinkMutex (not the source lock, so they never wait on a frame)
+    std::map<SourceKey, VideoSource*> sinkSources;
+    mutex* sinkMutex;
+
+    // what's being drawn this frame - a copy of drawnObjects/selectedObjects
+    // taken at the start of draw(), so the actual drawing can happen without
+    // holding the source lock
+    std::vector<RectangleBase*> renderObjects;
+    std::vector<RectangleBase*> renderSelected;
+    // earth location markers for this frame
+    EarthBatch earthPoints;
+    EarthBatch selectedEarthPoints;
+    EarthBatch earthLines;
 
     // temp lists for doing auto/audio focus
     std::vector<RectangleBase*> outerObjs;
     std::vector<RectangleBase*> innerObjs;
 
     LayoutManager* layouts;
+    IncrementalGridLayout* gridLayout;
+    // for layouts triggered from draw() or network callbacks, so they don't
+    // stall either
+    LayoutWorker* layoutWorker;
 
     Runway* runway;
 
     Camera* cam;
+    // how many objects were outside the view on the last frame, so we only
+    // log when it changes
+    int lastCulledCount;
+    int lastOccludedCount;
+    // the occlusion pass is n*this at worst - there's rarely more than one
+    // or two big enough to cover anything anyway
+    static const unsigned int maxOccluders = 8;
 
     // these following block of pointers are NOT owned by this class
 
@@ -254,7 +421,10 @@ private:
     float textOffset;
 
     AudioManager* audio;
-    bool audioFocusTrigger;
+    // speaker change count from the AudioManager when we last checked, and
+    // who was put in focus then (sorted by pointer, just for comparing)
+    unsigned int lastSpeakerChange;
+    std::vector<RectangleBase*> focusedSpeakers;
     // "audioEnabled" only means that the AudioManager object is available, not
     // that there actually is any audio being used in the session.
     // audioAvailable() accomplishes this by checking number of sources in
@@ -278,6 +448,7 @@ private:
     int drawCounter;
     int autoCounter;
     int intersectCounter;
+    int sessionCounter;
     bool enableSiteIDGroups;
 
     Point origCamPoint;
@@ -285,6 +456,18 @@ private:
     bool usingThreads;
     mutex* sourceMutex; // this is owned by us
     int lockCount;
+    long lockStartUS; // when the current holder got the lock
+    LockStats* lockStats;
+
+    bool renderThreaded;
+    mutex* sceneMutex;
+    // (only touched by the GUI thread)
+    int sceneLockDepth;
+    // how many threads are waiting in lockScene, so endFrame can let them in
+    volatile int sceneWaiters;
+    // sources removed from the GUI thread, waiting for the render thread to
+    // delete them (since that does GL calls)
+    std::vector<VideoSource*> retiredSources;
 
     bool useRunway;
     bool gridAuto;
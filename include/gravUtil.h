@@ -46,9 +46,10 @@ public:
 
     /*
      * Given a filename, search for it in the path list and return the full
-     * path. If not found, returns empty string.
+     * path. If not found, returns empty string (and logs an error, unless
+     * it's not required).
      */
-    std::string findFile( std::string file );
+    std::string findFile( std::string file, bool required = true );
     /*
      * Add a full pathname to the beginning of the path list.
      */
@@ -0,0 +1,174 @@
+/*
+ * @file AudioCodecMeter.cpp
+ *
+ * Implementation of level measurement for compressed audio packets.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AudioCodecMeter.h"
+#include "AudioLevelMeter.h"
+
+#include <cmath>
+
+int16_t AudioCodecMeter::ulawTable[ 256 ];
+int16_t AudioCodecMeter::alawTable[ 256 ];
+// done at static init time so the decoding thread never races on the tables
+bool AudioCodecMeter::tablesInitialized = ( initTables(), true );
+
+AudioCodecMeter::Codec AudioCodecMeter::codecFromName( std::string name )
+{
+    if ( name.compare( "PCMU" ) == 0 )
+        return PCMU;
+    else if ( name.compare( "PCMA" ) == 0 )
+        return PCMA;
+    else if ( name.compare( "GSM" ) == 0 )
+        return GSM;
+    return UNKNOWN_CODEC;
+}
+
+const char* AudioCodecMeter::getCodecName( Codec codec )
+{
+    switch ( codec )
+    {
+    case PCMU:
+        return "PCMU";
+    case PCMA:
+        return "PCMA";
+    case GSM:
+        return "GSM";
+    default:
+        return "unknown";
+    }
+}
+
+float AudioCodecMeter::measure( Codec codec, const uint8_t* data,
+                                uint32_t length )
+{
+    switch ( codec )
+    {
+    case PCMU:
+        return measureG711( ulawTable, data, length );
+    case PCMA:
+        return measureG711( alawTable, data, length );
+    case GSM:
+        return measureGSM( data, length );
+    default:
+        return -1.0f;
+    }
+}
+
+int16_t AudioCodecMeter::ulawToLinear( uint8_t u )
+{
+    // G.711 mu-law expansion (bias 0x84)
+    u = ~u;
+    int t = ( ( u & 0x0F ) << 3 ) + 0x84;
+    t <<= ( u & 0x70 ) >> 4;
+    return (int16_t)( ( u & 0x80 ) ? ( 0x84 - t ) : ( t - 0x84 ) );
+}
+
+int16_t AudioCodecMeter::alawToLinear( uint8_t a )
+{
+    // G.711 A-law expansion (even bits inverted)
+    a ^= 0x55;
+    int t = ( a & 0x0F ) << 4;
+    int seg = ( a & 0x70 ) >> 4;
+    if ( seg == 0 )
+        t += 8;
+    else
+    {
+        t += 0x108;
+        t <<= seg - 1;
+    }
+    return (int16_t)( ( a & 0x80 ) ? t : -t );
+}
+
+void AudioCodecMeter::initTables()
+{
+    for ( int i = 0; i < 256; i++ )
+    {
+        ulawTable[i] = ulawToLinear( (uint8_t)i );
+        alawTable[i] = alawToLinear( (uint8_t)i );
+    }
+}
+
+float AudioCodecMeter::measureG711( const int16_t* table, const uint8_t* data,
+                                    uint32_t length )
+{
+    if ( length == 0 )
+        return -1.0f;
+
+    // expand a chunk at a time & run the same kernel as linear16 audio
+    int16_t samples[ 256 ];
+    uint64_t sum = 0;
+    for ( uint32_t start = 0; start < length; start += 256 )
+    {
+        uint32_t num = length - start < 256 ? length - start : 256;
+        for ( uint32_t i = 0; i < num; i++ )
+            samples[i] = table[ data[ start + i ] ];
+
+        uint64_t chunkSum;
+        int peak;
+        AudioLevelMeter::measure( samples, num, chunkSum, peak );
+        sum += chunkSum;
+    }
+    return (float)( sqrt( (double)sum / (double)length ) / 32768.0 );
+}
+
+float AudioCodecMeter::measureGSM( const uint8_t* data, uint32_t length )
+{
+    // RTP GSM 06.10 (RFC 3551) is 33 byte frames, each starting with a 0xD
+    // signature nibble, then 36 bits of LAR coefficients, then 4 subframes of
+    // 56 bits: Nc(7) bc(2) Mc(2) xmaxc(6) xMc(13*3)
+    const uint32_t frameSize = 33;
+    if ( length < frameSize )
+        return -1.0f;
+
+    double sum = 0.0;
+    int count = 0;
+    for ( uint32_t f = 0; f + frameSize <= length; f += frameSize )
+    {
+        const uint8_t* frame = data + f;
+        if ( ( frame[0] >> 4 ) != 0xD )
+            return -1.0f;
+
+        for ( int sub = 0; sub < 4; sub++ )
+        {
+            int bit = 40 + ( sub * 56 ) + 11;
+            // the 6 bits can straddle a byte boundary, so read 2 bytes
+            int word = ( frame[ bit / 8 ] << 8 ) | frame[ ( bit / 8 ) + 1 ];
+            int xmaxc = ( word >> ( 10 - ( bit % 8 ) ) ) & 0x3F;
+
+            // undo the APCM block max quantization: values under 16 are
+            // xmax >> 5, above that there's a 3 bit exponent & 3 bit mantissa
+            // (with an implied leading 1)
+            int exp = xmaxc < 16 ? 0 : ( xmaxc >> 3 ) - 1;
+            int mant = xmaxc - ( exp << 3 );
+            double xmax = ( (double)mant + 0.5 ) * (double)( 1 << ( exp + 5 ) );
+
+            // xmax is the peak of the excitation, and the RPE pulses are
+            // spread fairly evenly under it, so about half that is a fair
+            // stand-in for the RMS
+            double rms = xmax * 0.5;
+            sum += rms * rms;
+            count++;
+        }
+    }
+    return (float)( sqrt( sum / (double)count ) / 32768.0 );
+}
@@ -0,0 +1,255 @@
+/*
+ * @file AudioLevelMeter.cpp
+ *
+ * Implementation of the block-based audio level meter.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AudioLevelMeter.h"
+
+#include <cmath>
+
+#ifdef GRAV_METER_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef GRAV_METER_AVX2
+#include <immintrin.h>
+#endif
+
+// picked once at static init, so the network thread never races on it
+AudioLevelMeter::MeasureFunc AudioLevelMeter::kernel =
+    AudioLevelMeter::pickKernel();
+
+AudioLevelMeter::AudioLevelMeter()
+{
+    currentLevel = 0.0f;
+    currentPeak = 0.0f;
+    average = 0.0f;
+    averageReset = 0;
+    averageSum = 0.0;
+    averageCount = 0;
+}
+
+void AudioLevelMeter::processAudio( const int16_t* samples,
+                                    uint32_t numSamples, uint32_t numChannels,
+                                    uint32_t sampleRate )
+{
+    if ( numSamples == 0 )
+        return;
+
+    uint64_t sumSquares;
+    int p;
+    kernel( samples, numSamples, sumSquares, p );
+
+    float blockLevel = (float)( sqrt( (double)sumSquares /
+                                      (double)numSamples ) / 32768.0 );
+    currentLevel = blockLevel;
+    currentPeak = (float)p / 32768.0f;
+
+    if ( __sync_lock_test_and_set( &averageReset, 0 ) )
+    {
+        averageSum = 0.0;
+        averageCount = 0;
+    }
+    averageSum += blockLevel;
+    averageCount++;
+    average = (float)( averageSum / (double)averageCount );
+}
+
+float AudioLevelMeter::level()
+{
+    return currentLevel;
+}
+
+float AudioLevelMeter::levelAverage()
+{
+    return average;
+}
+
+float AudioLevelMeter::peak()
+{
+    return currentPeak;
+}
+
+void AudioLevelMeter::resetAverage()
+{
+    averageReset = 1;
+}
+
+void AudioLevelMeter::measure( const int16_t* samples, uint32_t num,
+                               uint64_t& sumSquares, int& peak )
+{
+    kernel( samples, num, sumSquares, peak );
+}
+
+void AudioLevelMeter::measureScalar( const int16_t* samples, uint32_t num,
+                                     uint64_t& sumSquares, int& peak )
+{
+    uint64_t sum = 0;
+    int p = 0;
+    for ( uint32_t i = 0; i < num; i++ )
+    {
+        int s = samples[i];
+        sum += (uint64_t)( s * s );
+        int a = s < 0 ? -s : s;
+        if ( a > p )
+            p = a;
+    }
+    sumSquares = sum;
+    peak = p;
+}
+
+#ifdef GRAV_METER_SSE2
+void AudioLevelMeter::measureSSE2( const int16_t* samples, uint32_t num,
+                                   uint64_t& sumSquares, int& peak )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    __m128i vmax = _mm_set1_epi16( -32768 );
+    __m128i vmin = _mm_set1_epi16( 32767 );
+
+    uint32_t i = 0;
+    for ( ; i + 8 <= num; i += 8 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i*)( samples + i ) );
+        // pairs of squares added together - as unsigned this can't overflow
+        // (2 * 32768^2 = 2^31), so zero extend to 64 bits before summing
+        __m128i sq = _mm_madd_epi16( v, v );
+        sum = _mm_add_epi64( sum, _mm_unpacklo_epi32( sq, zero ) );
+        sum = _mm_add_epi64( sum, _mm_unpackhi_epi32( sq, zero ) );
+        vmax = _mm_max_epi16( vmax, v );
+        vmin = _mm_min_epi16( vmin, v );
+    }
+
+    uint64_t sums[2];
+    int16_t maxes[8], mins[8];
+    _mm_storeu_si128( (__m128i*)sums, sum );
+    _mm_storeu_si128( (__m128i*)maxes, vmax );
+    _mm_storeu_si128( (__m128i*)mins, vmin );
+
+    uint64_t total = sums[0] + sums[1];
+    int p = 0;
+    for ( int j = 0; j < 8; j++ )
+    {
+        if ( maxes[j] > p )
+            p = maxes[j];
+        if ( -mins[j] > p )
+            p = -mins[j];
+    }
+
+    uint64_t tailSum;
+    int tailPeak;
+    measureScalar( samples + i, num - i, tailSum, tailPeak );
+    sumSquares = total + tailSum;
+    peak = tailPeak > p ? tailPeak : p;
+}
+#endif
+
+#ifdef GRAV_METER_AVX2
+__attribute__(( target( "avx2" ) ))
+void AudioLevelMeter::measureAVX2( const int16_t* samples, uint32_t num,
+                                   uint64_t& sumSquares, int& peak )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum = zero;
+    __m256i vmax = _mm256_set1_epi16( -32768 );
+    __m256i vmin = _mm256_set1_epi16( 32767 );
+
+    uint32_t i = 0;
+    for ( ; i + 16 <= num; i += 16 )
+    {
+        __m256i v = _mm256_loadu_si256( (const __m256i*)( samples + i ) );
+        // same as the SSE2 version, the unpacks just work per 128 bit lane
+        // which doesn't matter for a sum
+        __m256i sq = _mm256_madd_epi16( v, v );
+        sum = _mm256_add_epi64( sum, _mm256_unpacklo_epi32( sq, zero ) );
+        sum = _mm256_add_epi64( sum, _mm256_unpackhi_epi32( sq, zero ) );
+        vmax = _mm256_max_epi16( vmax, v );
+        vmin = _mm256_min_epi16( vmin, v );
+    }
+
+    uint64_t sums[4];
+    int16_t maxes[16], mins[16];
+    _mm256_storeu_si256( (__m256i*)sums, sum );
+    _mm256_storeu_si256( (__m256i*)maxes, vmax );
+    _mm256_storeu_si256( (__m256i*)mins, vmin );
+
+    uint64_t total = sums[0] + sums[1] + sums[2] + sums[3];
+    int p = 0;
+    for ( int j = 0; j < 16; j++ )
+    {
+        if ( maxes[j] > p )
+            p = maxes[j];
+        if ( -mins[j] > p )
+            p = -mins[j];
+    }
+
+    uint64_t tailSum;
+    int tailPeak;
+    measureScalar( samples + i, num - i, tailSum, tailPeak );
+    sumSquares = total + tailSum;
+    peak = tailPeak > p ? tailPeak : p;
+}
+#endif
+
+bool AudioLevelMeter::haveSSE2()
+{
+#ifdef GRAV_METER_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AudioLevelMeter::haveAVX2()
+{
+#ifdef GRAV_METER_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#else
+    return false;
+#endif
+}
+
+const char* AudioLevelMeter::getKernelName()
+{
+#ifdef GRAV_METER_AVX2
+    if ( kernel == &measureAVX2 )
+        return "AVX2";
+#endif
+#ifdef GRAV_METER_SSE2
+    if ( kernel == &measureSSE2 )
+        return "SSE2";
+#endif
+    return "scalar";
+}
+
+AudioLevelMeter::MeasureFunc AudioLevelMeter::pickKernel()
+{
+#ifdef GRAV_METER_AVX2
+    if ( haveAVX2() )
+        return &measureAVX2;
+#endif
+#ifdef GRAV_METER_SSE2
+    return &measureSSE2;
+#else
+    return &measureScalar;
+#endif
+}
@@ -25,56 +25,90 @@
  */
 
 #include "AudioManager.h"
+#include "AudioLevelMeter.h"
+#include "AudioMeterDecoder.h"
+#include "MeterDecodeWorker.h"
 #include "gravUtil.h"
 
 #include <VPMedia/VPMPayloadDecoder.h>
 #include <VPMedia/audio/linear/VPMLinear16Decoder.h>
-#include <VPMedia/audio/VPMAudioMeter.h>
 #include <VPMedia/VPMSession.h>
 #include <cstdio>
 
+#include <sys/time.h>
+
+static AudioLevelGroup* newLevelGroup()
+{
+    AudioLevelGroup* g = new AudioLevelGroup;
+    g->level = -2.0f;
+    g->average = -2.0f;
+    g->numSources = 0;
+    g->resetAverage = 0;
+    g->speaking = 0;
+    g->passSum = 0.0f;
+    g->passCount = 0;
+    g->averageSum = 0.0f;
+    g->averageCount = 0;
+    g->cnames = false;
+    g->refs = 0;
+    g->emptySinceMS = 0;
+    return g;
+}
+
 AudioManager::AudioManager()
 {
+    sourceMutex = mutex_create();
+    groupMutex = mutex_create();
+    sourceCount = 0;
+    speakerChanges = 0;
+    meterWorker = new MeterDecodeWorker();
 
+    allGroup = newLevelGroup();
+    groups.push_back( allGroup );
 }
 
 AudioManager::~AudioManager()
 {
+    std::map<SourceKey, AudioSource*>::iterator si;
+    for ( si = sources.begin(); si != sources.end(); ++si )
+    {
+        delete si->second->meter;
+        delete si->second;
+    }
+    // (this deletes any meter channels as well)
+    delete meterWorker;
+
+    for ( unsigned int i = 0; i < groups.size(); i++ )
+        delete groups[i];
+    for ( unsigned int i = 0; i < retiredGroups.size(); i++ )
+        delete retiredGroups[i].second;
 
+    mutex_free( sourceMutex );
+    mutex_free( groupMutex );
 }
 
 float AudioManager::getLevel( std::string name, bool avg, bool cnames )
 {
     // Since there might be multiple sources with the same label (ie, one
-    // site sending multiple audio streams) we'll average the values of the
-    // meters that match the given name.
-    float temp = 0.0f;
-    int count = 0;
+    // site sending multiple audio streams) we use the group for the name,
+    // which has the average of the meters that match it.
+    AudioLevelGroup* g;
+    if ( name.compare( "" ) == 0 )
+        g = allGroup;
+    else
+        g = findGroup( name, cnames, false );
+
+    // default case, name not found
+    if ( g == NULL || g->numSources == 0 )
+        return -2.0f;
 
-    for ( unsigned int i = 0; i < sources.size(); i++ )
+    if ( avg )
     {
-        if ( ( !cnames && sources[i]->siteID.compare( name ) == 0 ) ||
-             ( cnames && sources[i]->cName.compare( name ) == 0 ) ||
-             name.compare( "" ) == 0 )
-        {
-            if ( avg )
-            {
-                temp += sources[i]->meter->levelAverage();
-                sources[i]->meter->resetAverage();
-            }
-            else
-                temp += sources[i]->meter->level();
-            count++;
-        }
-        // would fall to else clause if name was not found
+        float level = g->average;
+        g->resetAverage = 1;
+        return level;
     }
-
-    if ( count == 1 )
-        return temp;
-    else if ( count > 1 )
-        return temp/(float)count;
-    // default case
-    return -2.0f;
+    return g->level;
 }
 
 float AudioManager::getLevelAvg( std::string name )
@@ -84,32 +118,210 @@ float AudioManager::getLevelAvg( std::string name )
 
 void AudioManager::printLevels()
 {
-    for ( unsigned int i = 0; i < sources.size(); i++ )
+    mutex_lock( sourceMutex );
+    std::map<SourceKey, AudioSource*>::iterator si;
+    for ( si = sources.begin(); si != sources.end(); ++si )
     {
         gravUtil::logVerbose( "AudioManager::printLevels: "
-                "source: 0x%08x/%s: %f\n", sources[i]->ssrc,
-                sources[i]->siteID.c_str(), sources[i]->meter->level() );
+                "source: 0x%08x/%s: %f\n", si->second->ssrc,
+                si->second->siteID.c_str(), getSourceLevel( si->second ) );
     }
+    mutex_unlock( sourceMutex );
 }
 
 unsigned int AudioManager::getSourceCount()
 {
-    return sources.size();
+    return sourceCount;
+}
+
+bool AudioManager::isSpeaking( std::string name, bool cnames )
+{
+    AudioLevelGroup* g = findGroup( name, cnames, false );
+    return g != NULL && g->speaking;
+}
+
+unsigned int AudioManager::getSpeakerChangeCount()
+{
+    return speakerChanges;
+}
+
+AudioSource* AudioManager::findSource( VPMSession* session, uint32_t ssrc )
+{
+    std::map<SourceKey, AudioSource*>::iterator i =
+            sources.find( SourceKey( session, ssrc ) );
+    return i != sources.end() ? i->second : NULL;
+}
+
+float AudioManager::getSourceLevel( AudioSource* a )
+{
+    if ( a->meter != NULL )
+        return a->meter->level();
+    return a->channel->level;
+}
+
+AudioLevelGroup* AudioManager::findGroup( std::string name, bool cnames,
+                                          bool create )
+{
+    std::map<std::string, AudioLevelGroup*>& groupMap =
+            cnames ? cNameGroups : siteGroups;
+
+    // the creating thread is the only one that modifies the maps, so it
+    // doesn't need the lock just to look
+    if ( !create )
+        mutex_lock( groupMutex );
+    std::map<std::string, AudioLevelGroup*>::iterator i =
+            groupMap.find( name );
+    AudioLevelGroup* g = ( i != groupMap.end() ) ? i->second : NULL;
+    if ( !create )
+        mutex_unlock( groupMutex );
+
+    if ( g == NULL && create )
+    {
+        g = newLevelGroup();
+        g->name = name;
+        g->cnames = cnames;
+        mutex_lock( groupMutex );
+        groupMap[ name ] = g;
+        mutex_unlock( groupMutex );
+        // (only read by publishLevels, on this same thread)
+        groups.push_back( g );
+    }
+    return g;
+}
+
+void AudioManager::changeGroup( AudioLevelGroup*& current,
+                                AudioLevelGroup* next )
+{
+    if ( current != NULL )
+        current->refs--;
+    current = next;
+    if ( current != NULL )
+        current->refs++;
+}
+
+void AudioManager::retireGroups( long nowMS )
+{
+    // anything retired long enough ago can't have a reader left, since they
+    // only hold on to a group for the length of a getLevel call
+    std::vector<std::pair<long, AudioLevelGroup*> >::iterator r =
+            retiredGroups.begin();
+    while ( r != retiredGroups.end() )
+    {
+        if ( nowMS - r->first > retireGraceMS )
+        {
+            delete r->second;
+            r = retiredGroups.erase( r );
+        }
+        else
+            ++r;
+    }
+
+    std::vector<AudioLevelGroup*>::iterator i = groups.begin();
+    while ( i != groups.end() )
+    {
+        AudioLevelGroup* g = *i;
+        if ( g == allGroup || g->refs > 0 )
+        {
+            g->emptySinceMS = 0;
+            ++i;
+            continue;
+        }
+
+        if ( g->emptySinceMS == 0 )
+            g->emptySinceMS = nowMS;
+        if ( nowMS - g->emptySinceMS < retireAfterMS )
+        {
+            ++i;
+            continue;
+        }
+
+        // new lookups won't find it after this - if the name comes back,
+        // it'll just get a new group
+        mutex_lock( groupMutex );
+        ( g->cnames ? cNameGroups : siteGroups ).erase( g->name );
+        mutex_unlock( groupMutex );
+        retiredGroups.push_back( std::make_pair( nowMS, g ) );
+        i = groups.erase( i );
+        gravUtil::logVerbose( "AudioManager::retireGroups: retired %s %s\n",
+                              g->cnames ? "cname" : "siteID",
+                              g->name.c_str() );
+    }
 }
 
-void AudioManager::updateNames()
+void AudioManager::publishLevels()
 {
-    for ( unsigned int i = 0; i < sources.size(); i++ )
+    mutex_lock( sourceMutex );
+
+    for ( unsigned int i = 0; i < groups.size(); i++ )
     {
-        char buffer[256];
-        uint32_t bufferLen = sizeof( buffer );
+        groups[i]->passSum = 0.0f;
+        groups[i]->passCount = 0;
+    }
 
-        if ( sources[i]->session->getRemoteSDES( sources[i]->ssrc,
-                        VPMSession::VPMSESSION_SDES_CNAME, buffer, bufferLen ) )
+    std::map<SourceKey, AudioSource*>::iterator si;
+    for ( si = sources.begin(); si != sources.end(); ++si )
+    {
+        AudioSource* a = si->second;
+        float level = getSourceLevel( a );
+
+        allGroup->passSum += level;
+        allGroup->passCount++;
+        if ( a->siteGroup != NULL )
         {
-            sources[i]->cName = std::string( buffer );
+            a->siteGroup->passSum += level;
+            a->siteGroup->passCount++;
+        }
+        if ( a->cNameGroup != NULL )
+        {
+            a->cNameGroup->passSum += level;
+            a->cNameGroup->passCount++;
+        }
+    }
+
+    mutex_unlock( sourceMutex );
+
+    struct timeval now;
+    gettimeofday( &now, NULL );
+    long nowMS = now.tv_sec * 1000L + now.tv_usec / 1000L;
+
+    for ( unsigned int i = 0; i < groups.size(); i++ )
+    {
+        AudioLevelGroup* g = groups[i];
+
+        if ( __sync_lock_test_and_set( &g->resetAverage, 0 ) )
+        {
+            g->averageSum = 0.0f;
+            g->averageCount = 0;
+        }
+
+        if ( g->passCount > 0 )
+        {
+            float level = g->passSum / (float)g->passCount;
+            g->averageSum += level;
+            g->averageCount++;
+            g->level = level;
+            g->average = g->averageSum / (float)g->averageCount;
+
+            if ( g->vad.update( level, nowMS ) )
+            {
+                g->speaking = g->vad.isSpeaking();
+                __sync_fetch_and_add( &speakerChanges, 1 );
+            }
+        }
+        else
+        {
+            // everyone in the group left, so nobody's talking anymore
+            if ( g->speaking )
+            {
+                g->speaking = 0;
+                __sync_fetch_and_add( &speakerChanges, 1 );
+            }
+            g->vad.reset();
         }
+        g->numSources = g->passCount;
     }
+
+    retireGroups( nowMS );
 }
 
 void AudioManager::vpmsession_source_created( VPMSession &session,
@@ -121,23 +333,48 @@ void AudioManager::vpmsession_source_created( VPMSession &session,
     gravUtil::logVerbose( "AudioManager::vpmsession_source_created: "
             "adding source ssrc: 0x%08x\n", ssrc );
     VPMLinear16Decoder* dec = dynamic_cast<VPMLinear16Decoder*>(decoder);
-    if ( dec )
+    AudioMeterDecoder* meterDec = dynamic_cast<AudioMeterDecoder*>(decoder);
+    if ( !dec && !meterDec )
     {
-        AudioSource* a = new AudioSource;
-        VPMAudioMeter* m = new VPMAudioMeter();
-        a->ssrc = ssrc;
-        a->meter = m;
-        a->session = &session;
+        gravUtil::logWarning( "AudioManager::vpmsession_source_created: "
+                "no meter for payload type %u\n", pt );
+        return;
+    }
 
-        dec->connectAudioProcessor( m );
+    AudioSource* a = new AudioSource;
+    a->ssrc = ssrc;
+    a->session = &session;
+    a->meter = NULL;
+    a->channel = NULL;
+    a->meterDecoder = NULL;
+    a->siteGroup = NULL;
+    a->cNameGroup = NULL;
 
-        sources.push_back( a );
-        gravUtil::logVerbose( "AudioManager::vpmsession_source_created: "
-                "source added\n" );
+    if ( dec )
+    {
+        a->meter = new AudioLevelMeter();
+        dec->connectAudioProcessor( a->meter );
     }
     else
-        gravUtil::logWarning( "AudioManager::vpmsession_source_created: "
-                "failed to cast to linear16 decoder\n" );
+    {
+        // packets from here on get measured on the worker, not this thread
+        meterWorker->start();
+        a->channel = meterWorker->createChannel( meterDec->getCodec() );
+        a->meterDecoder = meterDec;
+        meterDec->connectMeter( a->channel );
+        gravUtil::logVerbose( "AudioManager::vpmsession_source_created: "
+                "metering %s source\n", meterDec->getDesc() );
+    }
+
+    mutex_lock( sourceMutex );
+    sources[ SourceKey( &session, ssrc ) ] = a;
+    sourceCount = sources.size();
+    mutex_unlock( sourceMutex );
+    gravUtil::logVerbose( "AudioManager::vpmsession_source_created: "
+            "source added\n" );
+
+    // we might already have its cname
+    vpmsession_source_description( session, ssrc );
 }
 
 void AudioManager::vpmsession_source_deleted( VPMSession &session,
@@ -146,23 +383,53 @@ void AudioManager::vpmsession_source_deleted( VPMSession &session,
 {
     gravUtil::logVerbose( "AudioManager::vpmsession_source_deleted: "
             "deleting source ssrc: 0x%08x\n", ssrc );
-    std::vector<AudioSource*>::iterator it;
-    for ( it = sources.begin(); it != sources.end(); ++it )
+
+    mutex_lock( sourceMutex );
+    std::map<SourceKey, AudioSource*>::iterator it =
+            sources.find( SourceKey( &session, ssrc ) );
+    if ( it == sources.end() )
     {
-        if ( (*it)->ssrc == ssrc )
-        {
-            delete (*it)->meter;
-            delete (*it);
-            sources.erase( it );
-            return;
-        }
+        mutex_unlock( sourceMutex );
+        return;
+    }
+    AudioSource* a = it->second;
+    sources.erase( it );
+    sourceCount = sources.size();
+    mutex_unlock( sourceMutex );
+
+    // publishLevels can't be looking at it anymore since it's out of the list
+    // (and it runs on this thread, so the group counts are safe to touch)
+    changeGroup( a->siteGroup, NULL );
+    changeGroup( a->cNameGroup, NULL );
+    delete a->meter;
+    if ( a->channel != NULL )
+    {
+        // the decoder is still around until this returns, so make sure it
+        // can't post anything else for the channel
+        a->meterDecoder->connectMeter( NULL );
+        meterWorker->releaseChannel( a->channel );
     }
+    delete a;
 }
 
 void AudioManager::vpmsession_source_description( VPMSession &session,
                                               uint32_t ssrc )
 {
+    char buffer[256];
+    uint32_t bufferLen = sizeof( buffer );
+    if ( !session.getRemoteSDES( ssrc, VPMSession::VPMSESSION_SDES_CNAME,
+                                 buffer, bufferLen ) )
+        return;
+    std::string cName( buffer );
 
+    mutex_lock( sourceMutex );
+    AudioSource* a = findSource( &session, ssrc );
+    if ( a != NULL && cName.compare( a->cName ) != 0 )
+    {
+        a->cName = cName;
+        changeGroup( a->cNameGroup, findGroup( cName, true, true ) );
+    }
+    mutex_unlock( sourceMutex );
 }
 
 void AudioManager::vpmsession_source_app(VPMSession &session,
@@ -181,12 +448,13 @@ void AudioManager::vpmsession_source_app(VPMSession &session,
 
     if ( appS.compare( "site" ) == 0 )
     {
-        for ( unsigned int i = 0; i < sources.size(); i++ )
+        mutex_lock( sourceMutex );
+        AudioSource* a = findSource( &session, ssrc );
+        if ( a != NULL && a->siteID.compare( dataS ) != 0 )
         {
-            if ( sources[i]->ssrc == ssrc )
-            {
-                sources[i]->siteID = dataS;
-            }
+            a->siteID = dataS;
+            changeGroup( a->siteGroup, findGroup( dataS, false, true ) );
         }
+        mutex_unlock( sourceMutex );
     }
 }
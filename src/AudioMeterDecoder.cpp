@@ -0,0 +1,81 @@
+/*
+ * @file AudioMeterDecoder.cpp
+ *
+ * Implementation of the meter-only audio payload decoder.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AudioMeterDecoder.h"
+
+#include <VPMedia/VPMPayloadDecoderFactory.h>
+
+AudioMeterDecoder::AudioMeterDecoder( AudioCodecMeter::Codec c ) :
+    codec( c ), meter( NULL )
+{ }
+
+void AudioMeterDecoder::connectMeter( MeterChannel* channel )
+{
+    meter = channel;
+}
+
+AudioCodecMeter::Codec AudioMeterDecoder::getCodec()
+{
+    return codec;
+}
+
+bool AudioMeterDecoder::initialise()
+{
+    return true;
+}
+
+void AudioMeterDecoder::decodePacket( const uint8_t* payload, uint32_t length,
+                                      uint32_t timestamp, bool marker )
+{
+    // this is on the network thread, so just queue it up
+    if ( meter != NULL )
+        meter->worker->post( meter, payload, length );
+}
+
+const char* AudioMeterDecoder::getDesc()
+{
+    return AudioCodecMeter::getCodecName( codec );
+}
+
+void AudioMeterDecoder::registerDecoders( VPMPayloadDecoderFactory* factory )
+{
+    factory->registerDecoder( "PCMU", &AudioMeterDecoder::createPCMU );
+    factory->registerDecoder( "PCMA", &AudioMeterDecoder::createPCMA );
+    factory->registerDecoder( "GSM", &AudioMeterDecoder::createGSM );
+}
+
+VPMPayloadDecoder* AudioMeterDecoder::createPCMU()
+{
+    return new AudioMeterDecoder( AudioCodecMeter::PCMU );
+}
+
+VPMPayloadDecoder* AudioMeterDecoder::createPCMA()
+{
+    return new AudioMeterDecoder( AudioCodecMeter::PCMA );
+}
+
+VPMPayloadDecoder* AudioMeterDecoder::createGSM()
+{
+    return new AudioMeterDecoder( AudioCodecMeter::GSM );
+}
@@ -45,6 +45,12 @@ void Camera::doGLLookat()
     gluLookAt( center.getX(), center.getY(), center.getZ(),
                 lookat.getX(), lookat.getY(), lookat.getZ(),
                 up.getX(), up.getY(), up.getZ() );
+    frustum.update();
+}
+
+Frustum* Camera::getFrustum()
+{
+    return &frustum;
 }
 
 Point Camera::getCenter()
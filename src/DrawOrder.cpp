@@ -0,0 +1,94 @@
+/*
+ * @file DrawOrder.cpp
+ *
+ * Implementation of the drawn object list.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DrawOrder.h"
+
+DrawOrder::DrawOrder() :
+    nextKey( 0 ), listDirty( false )
+{ }
+
+bool DrawOrder::add( RectangleBase* object )
+{
+    if ( keyOf.find( object ) != keyOf.end() )
+        return false;
+
+    objects[ nextKey ] = object;
+    keyOf[ object ] = nextKey;
+    nextKey++;
+    listDirty = true;
+    return true;
+}
+
+bool DrawOrder::remove( RectangleBase* object )
+{
+    std::map<RectangleBase*, OrderKey>::iterator k = keyOf.find( object );
+    if ( k == keyOf.end() )
+        return false;
+
+    objects.erase( k->second );
+    keyOf.erase( k );
+    listDirty = true;
+    return true;
+}
+
+bool DrawOrder::contains( RectangleBase* object ) const
+{
+    return keyOf.find( object ) != keyOf.end();
+}
+
+bool DrawOrder::moveToTop( RectangleBase* object )
+{
+    std::map<RectangleBase*, OrderKey>::iterator k = keyOf.find( object );
+    if ( k == keyOf.end() )
+        return false;
+
+    // already on top, nothing to do
+    if ( k->second == nextKey - 1 )
+        return true;
+
+    objects.erase( k->second );
+    k->second = nextKey;
+    objects[ nextKey ] = object;
+    nextKey++;
+    listDirty = true;
+    return true;
+}
+
+unsigned int DrawOrder::size() const
+{
+    return objects.size();
+}
+
+const std::vector<RectangleBase*>& DrawOrder::getList()
+{
+    if ( listDirty )
+    {
+        list.clear();
+        std::map<OrderKey, RectangleBase*>::const_iterator i;
+        for ( i = objects.begin(); i != objects.end(); ++i )
+            list.push_back( i->second );
+        listDirty = false;
+    }
+    return list;
+}
@@ -24,11 +24,17 @@
  */
 
 #include "Earth.h"
+#include "SphereMesh.h"
+#include "EarthTiles.h"
+#include "Point.h"
 
 #include <cmath>
+#include <algorithm>
 
 const float PI = 3.1415926535;
 
+const int Earth::meshSlices[ Earth::numMeshLevels ] = { 24, 48, 96, 192 };
+
 Earth::Earth()
 {
     x = 0.0f; y = 0.0f, z = -25.0f;
@@ -37,52 +43,94 @@ Earth::Earth()
     destXRot = xRot; destYRot = yRot; destZRot = zRot;
     moveAmt = 1.0f;
 
-    Texture t = GLUtil::getInstance()->getTexture( "earth" );
-    earthTex = t.ID;
-    texWidth = t.width;
-    texHeight = t.height;
+    earthTex = 0;
+    texWidth = 0;
+    texHeight = 0;
 
     animated = true;
     rotating = false;
 
-    sphereQuad = gluNewQuadric();
-    gluQuadricTexture( sphereQuad, GL_TRUE );
+    for ( int i = 0; i < numMeshLevels; i++ )
+        meshes.push_back( new SphereMesh( radius, 0.0f, 0.0f, 1.0f, 1.0f,
+                                          meshSlices[i], meshSlices[i] / 2 ) );
+    tiles = EarthTiles::find( radius );
 
-    // create the display list for rendering the sphere
-    sphereIndex = glGenLists( 1 );
-    glNewList( sphereIndex, GL_COMPILE );
-    glEnable( GL_TEXTURE_2D );
-    glBindTexture( GL_TEXTURE_2D, earthTex );
+    anisotropic = GLEW_EXT_texture_filter_anisotropic;
+    maxAnisotropy = 1.0f;
+    if ( anisotropic )
+        glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy );
 
-    glEnable( GL_CULL_FACE );
-    glCullFace( GL_BACK );
+    updateTexture();
 
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    matrix = new GLdouble[16];
+    updateTransform();
+}
 
-    gluSphere( sphereQuad, radius, 40, 40 );
+void Earth::updateTexture()
+{
+    Texture t = GLUtil::getInstance()->getTexture( "earth" );
+    if ( t.ID == earthTex )
+        return;
 
-    glDisable( GL_CULL_FACE );
-    glDisable( GL_TEXTURE_2D );
-    glEndList();
+    earthTex = t.ID;
+    texWidth = t.width;
+    texHeight = t.height;
 
-    matrix = new GLdouble[16];
+    glBindTexture( GL_TEXTURE_2D, earthTex );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    // the texture gets mipmaps if GL supports it (see grav.cpp); otherwise
+    // a mipmap filter would make it incomplete & draw white
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                     GLEW_VERSION_1_4 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
+    if ( anisotropic )
+        glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                         std::min( 4.0f, maxAnisotropy ) );
 }
 
 Earth::~Earth()
 {
     glDeleteTextures( 1, &earthTex );
-    gluDeleteQuadric( sphereQuad );
+    for ( unsigned int i = 0; i < meshes.size(); i++ )
+        delete meshes[i];
+    delete tiles;
     delete[] matrix;
-    glDeleteLists( sphereIndex, 1 );
 }
 
-void Earth::draw()
+void Earth::draw( Point camPos, int viewWidth, int viewHeight )
 {
     animateValues();
 
+    // roughly how many pixels the radius covers - the projection is set up
+    // so half the shorter side of the view is 1 unit at distance 1 (see
+    // GLCanvas)
+    float dx = camPos.getX() - x;
+    float dy = camPos.getY() - y;
+    float dz = camPos.getZ() - z;
+    float dist = std::max( radius, (float)sqrt( dx*dx + dy*dy + dz*dz ) );
+    float pixelRadius = radius * (float)std::min( viewWidth, viewHeight ) /
+                            2.0f / dist;
+    float circumference = 2.0f * PI * pixelRadius;
+
+    // go up in detail until each slice is under ~8 pixels of the outline
+    int meshLevel = 0;
+    while ( meshLevel < numMeshLevels - 1 &&
+            meshSlices[ meshLevel ] < circumference / 8.0f )
+        meshLevel++;
+
+    // only bother with the tiles once the base texture would be magnified
+    int tileLevel = -1;
+    if ( tiles != NULL && circumference > (float)texWidth )
+    {
+        tileLevel = (int)ceil( log( circumference / tiles->getTileSize() ) /
+                               log( 2.0 ) ) - 1;
+        tileLevel = std::max( 0, std::min( tileLevel, tiles->getMaxLevel() ) );
+        // the base texture may be as good as the deepest level we have
+        if ( ( 2 << tileLevel ) * tiles->getTileSize() <= texWidth )
+            tileLevel = -1;
+    }
+
     glPushMatrix();
 
     glTranslatef( x, y, z );
@@ -125,11 +173,31 @@ void Earth::draw()
 
     glColor4f( 1.0f, 1.0f, 1.0f, 1.0f );
 
-    // render the sphere using its display list
-    glCallList( sphereIndex );
+    glEnable( GL_TEXTURE_2D );
+    glEnable( GL_CULL_FACE );
+    glCullFace( GL_BACK );
+
+    if ( tileLevel >= 0 )
+    {
+        float lx, ly, lz;
+        toLocal( camPos.getX(), camPos.getY(), camPos.getZ(), lx, ly, lz );
+        tiles->draw( tileLevel, lx, ly, lz, earthTex );
+    }
+    else
+    {
+        glBindTexture( GL_TEXTURE_2D, earthTex );
+        meshes[ meshLevel ]->draw();
+    }
+
+    glDisable( GL_CULL_FACE );
+    glDisable( GL_TEXTURE_2D );
 
     glPopMatrix();
 
+    // still call this when not drawing tiles, so ones out of use get freed
+    if ( tiles != NULL )
+        tiles->endFrame();
+
     /*testLat++;
     x += moveAmt;
     if ( x > 25.0f || x < -25.0f )
@@ -139,70 +207,96 @@ void Earth::draw()
 void Earth::convertLatLong( float lat, float lon, float &ex, float &ey,
                             float &ez)
 {
-    // grab the modelview matrix so we can calculate the result of the
-    // rotation manually
-    //GLdouble matrix[16];
-    //glPushMatrix();
-    //GLUtil::printMatrices();
-
-
-    /*glTranslatef( x, y, z );
-    glRotatef( xRot, 1.0f, 0.0f, 0.0f );
-    glRotatef( yRot, 0.0f, 0.0f, 1.0f );
-    glRotatef( zRot, 0.0f, 1.0f, 0.0f );
-    glGetDoublev( GL_MODELVIEW_MATRIX, matrix );*/
-
-    //glPopMatrix();
-    //GLUtil::updateMatrices();
-    //GLUtil::printMatrices();
-    //for ( int i = 0; i < 16; i++ )
-    //    matrix[i] = GLUtil::modelview[i];
-
-    glPushMatrix();
-    glLoadIdentity();
-    glTranslatef( x, y, z );
-    glRotatef( xRot, 1.0f, 0.0f, 0.0f );
-    glRotatef( yRot, 0.0f, 0.0f, 1.0f );
-    glRotatef( zRot, 0.0f, 1.0f, 0.0f );
-    glGetDoublev( GL_MODELVIEW_MATRIX, matrix );
-    glPopMatrix();
-
-    float rlat = lat;//-90.0f); //-xRot
-    float rlon = lon; //+zRot
-    //float rlat = lat-xRot-90.0f;
-    //float rlon = lon+zRot;
-
-    rlat = rlat*PI/180.0f;
-    rlon = rlon*PI/180.0f;
-
-    float ext = radius * (cos(rlat) * sin(rlon));
-    float eyt = radius * (sin(rlat));
-    float ezt = radius * (cos(rlat) * cos(rlon));
-    //gravUtil::logVerbose( "ex,ey,ez: %f,%f,%f\n", ex, ey, ez );
+    float ux, uy, uz;
+    latLongToUnit( lat, lon, ux, uy, uz );
+    convertUnit( ux, uy, uz, ex, ey, ez );
+}
 
-    /*glBegin( GL_LINE );
-    glVertex3f( 0.0f, 0.0f, 0.0f );
-    glVertex3f( ex, ey, ez );
-    glEnd();*/
+void Earth::convertUnit( float ux, float uy, float uz, float &ex, float &ey,
+                         float &ez )
+{
+    float ext = radius * ux;
+    float eyt = radius * uy;
+    float ezt = radius * uz;
 
     // column major
     ex = (ext*matrix[0]) + (eyt*matrix[4]) + (ezt*matrix[8]) + matrix[12];
     ey = (ext*matrix[1]) + (eyt*matrix[5]) + (ezt*matrix[9]) + matrix[13];
     ez = (ext*matrix[2]) + (eyt*matrix[6]) + (ezt*matrix[10]) + matrix[14];
-    //gravUtil::logVerbose( "x,y,z: %f,%f,%f\n", ex, ey, ez );
+}
+
+void Earth::latLongToUnit( float lat, float lon, float &ux, float &uy,
+                           float &uz )
+{
+    float rlat = lat*PI/180.0f;
+    float rlon = lon*PI/180.0f;
 
-    // row major
-    /*ex = (ex*matrix[0]) + (ey*matrix[1]) + (ez*matrix[2]);// + matrix[3];
-    ey = (ex*matrix[4]) + (ey*matrix[5]) + (ez*matrix[5]);// + matrix[7];
-    ez = (ex*matrix[8]) + (ey*matrix[9]) + (ez*matrix[10]);// + matrix[11];*/
+    ux = cos(rlat) * sin(rlon);
+    uy = sin(rlat);
+    uz = cos(rlat) * cos(rlon);
+}
 
-    //gravUtil::logVerbose( "matrix/modelview: %f, %f\n", matrix[1], GLUtil::modelview[1] );
+void Earth::updateTransform()
+{
+    // same as translate(x,y,z) * rotate(xRot, x axis) * rotate(yRot, z axis) *
+    // rotate(zRot, y axis) in GL, just without having to round trip through
+    // the GL matrix stack to get it
+    double ax = xRot * PI / 180.0;
+    double ay = yRot * PI / 180.0;
+    double az = zRot * PI / 180.0;
+    double cx = cos( ax ), sx = sin( ax );
+    double cy = cos( ay ), sy = sin( ay );
+    double cz = cos( az ), sz = sin( az );
+
+    // Rx * Rz
+    double a[3][3] = {
+        { cy,       -sy,       0.0 },
+        { cx * sy,  cx * cy,   -sx },
+        { sx * sy,  sx * cy,   cx  } };
+    // ... * Ry
+    double r[3][3];
+    for ( int row = 0; row < 3; row++ )
+    {
+        r[row][0] = a[row][0] * cz - a[row][2] * sz;
+        r[row][1] = a[row][1];
+        r[row][2] = a[row][0] * sz + a[row][2] * cz;
+    }
 
-    //ex = (ex*GLUtil::modelview[0]) + (ey*GLUtil::modelview[4]) + (ez*GLUtil::modelview[8]) + GLUtil::modelview[12];
-    //ey = (ex*GLUtil::modelview[1]) + (ey*GLUtil::modelview[5]) + (ez*GLUtil::modelview[9]) + GLUtil::modelview[13];
-    //ez = (ex*GLUtil::modelview[2]) + (ey*GLUtil::modelview[3]) + (ez*GLUtil::modelview[10]) + GLUtil::modelview[14];
+    for ( int col = 0; col < 3; col++ )
+    {
+        for ( int row = 0; row < 3; row++ )
+            matrix[ col * 4 + row ] = r[row][col];
+        matrix[ col * 4 + 3 ] = 0.0;
+    }
+    matrix[12] = x;
+    matrix[13] = y;
+    matrix[14] = z;
+    matrix[15] = 1.0;
+}
 
-    //glPopMatrix();
+void Earth::toLocal( float wx, float wy, float wz, float &lx, float &ly,
+                     float &lz )
+{
+    // the draw transform is translate(x,y,z) * rotate(xRot-90, x axis) *
+    // rotate(yRot, y axis) * rotate(zRot, z axis), so undo the translation &
+    // multiply by the transpose of the rotation
+    double ax = ( xRot - 90.0 ) * PI / 180.0;
+    double ay = yRot * PI / 180.0;
+    double az = zRot * PI / 180.0;
+    double cx = cos( ax ), sx = sin( ax );
+    double cy = cos( ay ), sy = sin( ay );
+    double cz = cos( az ), sz = sin( az );
+
+    // Rx * Ry * Rz
+    double r[3][3] = {
+        { cy * cz,                   -cy * sz,                  sy       },
+        { sx * sy * cz + cx * sz,    -sx * sy * sz + cx * cz,   -sx * cy },
+        { -cx * sy * cz + sx * sz,   cx * sy * sz + sx * cz,    cx * cy  } };
+
+    double v[3] = { wx - x, wy - y, wz - z };
+    lx = (float)( r[0][0] * v[0] + r[1][0] * v[1] + r[2][0] * v[2] );
+    ly = (float)( r[0][1] * v[0] + r[1][1] * v[1] + r[2][1] * v[2] );
+    lz = (float)( r[0][2] * v[0] + r[1][2] * v[1] + r[2][2] * v[2] );
 }
 
 void Earth::rotate( float x, float y, float z )
@@ -216,6 +310,7 @@ void Earth::rotate( float x, float y, float z )
         xRot += x;
         yRot += y;
         zRot += z;
+        updateTransform();
     }
     else
         rotating = true;
@@ -259,5 +354,6 @@ void Earth::animateValues()
             zRot = destZRot;
             rotating = false;
         }
+        updateTransform();
     }
 }
@@ -0,0 +1,401 @@
+/*
+ * @file EarthTiles.cpp
+ *
+ * Implementation of the lazily loaded earth tile pyramid.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EarthTiles.h"
+#include "SphereMesh.h"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+// levels past this would need more than 16 bits per tile coordinate in the
+// key, and are far past any imagery we'd have anyway
+static const int maxPyramidLevels = 12;
+
+typedef struct EarthTile
+{
+    int level, x, y;
+    SphereMesh* mesh;
+    GLuint tex;
+    // requested from the loader, not picked up yet
+    bool loading;
+    bool loadFailed;
+    unsigned long lastUsed;
+} EarthTile;
+
+static unsigned long tileKey( int level, int x, int y )
+{
+    return ( (unsigned long)level << 28 ) | ( (unsigned long)y << 14 ) |
+            (unsigned long)x;
+}
+
+/*
+ * Reads the width out of a PNG header, without decoding the image. Returns 0
+ * if it's not a PNG.
+ */
+static int readPNGWidth( std::string filename )
+{
+    FILE* f = fopen( filename.c_str(), "rb" );
+    if ( f == NULL )
+        return 0;
+
+    // 8 byte signature, then the IHDR chunk: length, "IHDR", width, height
+    unsigned char header[24];
+    size_t read = fread( header, 1, sizeof( header ), f );
+    fclose( f );
+    if ( read != sizeof( header ) || header[1] != 'P' || header[2] != 'N' ||
+            header[3] != 'G' )
+        return 0;
+
+    return ( header[16] << 24 ) | ( header[17] << 16 ) | ( header[18] << 8 ) |
+            header[19];
+}
+
+EarthTiles* EarthTiles::find( float radius )
+{
+    std::string first = gravUtil::getInstance()->findFile(
+                                        "earth_tiles/0/0_0.png", false );
+    if ( first.compare( "" ) == 0 )
+        return NULL;
+
+    std::string dir = first.substr( 0, first.size() -
+                                    std::string( "0/0_0.png" ).size() );
+
+    // count the levels that are there
+    int levels = 0;
+    while ( levels < maxPyramidLevels )
+    {
+        char name[32];
+        snprintf( name, sizeof( name ), "%i/0_0.png", levels );
+        FILE* f = fopen( ( dir + name ).c_str(), "rb" );
+        if ( f == NULL )
+            break;
+        fclose( f );
+        levels++;
+    }
+
+    EarthTiles* tiles = new EarthTiles( dir, levels, radius );
+    if ( tiles->getTileSize() == 0 )
+    {
+        gravUtil::logWarning( "EarthTiles: %s0/0_0.png isn't a PNG\n",
+                              dir.c_str() );
+        delete tiles;
+        return NULL;
+    }
+
+    gravUtil::logVerbose( "EarthTiles: found %i levels of %ipx tiles in %s\n",
+                          levels, tiles->getTileSize(), dir.c_str() );
+    return tiles;
+}
+
+EarthTiles::EarthTiles( std::string dir, int levels, float r ) :
+    directory( dir ), maxLevel( levels - 1 ), radius( r )
+{
+    tileSize = readPNGWidth( getTileFile( 0, 0, 0 ) );
+    residentCount = 0;
+    loadingCount = 0;
+    frame = 0;
+    drawnCount = 0;
+}
+
+EarthTiles::~EarthTiles()
+{
+    std::map<unsigned long, EarthTile*>::iterator i;
+    for ( i = tiles.begin(); i != tiles.end(); ++i )
+    {
+        freeTile( i->second );
+        delete i->second;
+    }
+}
+
+int EarthTiles::getMaxLevel()
+{
+    return maxLevel;
+}
+
+int EarthTiles::getTileSize()
+{
+    return tileSize;
+}
+
+void EarthTiles::draw( int level, float camX, float camY, float camZ,
+                       GLuint baseTex )
+{
+    level = std::max( 0, std::min( level, maxLevel ) );
+    int cols = 1 << ( level + 1 );
+    int rows = 1 << level;
+    float du = 1.0f / (float)cols;
+    float dv = 1.0f / (float)rows;
+
+    // a point on the sphere is visible if it's within this angle of the
+    // direction to the camera
+    float camDist = sqrt( camX*camX + camY*camY + camZ*camZ );
+    float horizon = camDist > radius ? acos( radius / camDist ) : 0.0f;
+    float camDirX = camX / camDist;
+    float camDirY = camY / camDist;
+    float camDirZ = camZ / camDist;
+
+    drawnCount = 0;
+    for ( int y = 0; y < rows; y++ )
+    {
+        // angular size of the tiles in this row: half the diagonal, which is
+        // longest at the edge closest to the equator
+        double rhoTop = y * dv * M_PI;
+        double rhoBottom = ( y + 1 ) * dv * M_PI;
+        double rhoCenter = ( rhoTop + rhoBottom ) / 2.0;
+        double widest = std::max( sin( rhoTop ), sin( rhoBottom ) );
+        if ( rhoTop < M_PI / 2.0 && rhoBottom > M_PI / 2.0 )
+            widest = 1.0;
+        double halfHeight = dv * M_PI / 2.0;
+        double halfWidth = du * M_PI * widest;
+        float tileRadius = sqrt( halfHeight * halfHeight +
+                                 halfWidth * halfWidth );
+
+        for ( int x = 0; x < cols; x++ )
+        {
+            // same parameterization as SphereMesh
+            double theta = ( 1.0 - ( x + 0.5 ) * du ) * 2.0 * M_PI;
+            float dirX = sin( rhoCenter ) * sin( theta );
+            float dirY = sin( rhoCenter ) * cos( theta );
+            float dirZ = cos( rhoCenter );
+            float dot = dirX*camDirX + dirY*camDirY + dirZ*camDirZ;
+            float angle = acos( std::max( -1.0f, std::min( 1.0f, dot ) ) );
+            if ( angle - tileRadius > horizon )
+                continue;
+
+            EarthTile* tile = getTile( level, x, y );
+            tile->lastUsed = frame;
+            drawnCount++;
+
+            if ( tile->tex != 0 )
+            {
+                glBindTexture( GL_TEXTURE_2D, tile->tex );
+                tile->mesh->draw();
+                continue;
+            }
+
+            // not loaded (yet), so use the matching part of the whole map
+            glBindTexture( GL_TEXTURE_2D, baseTex );
+            glMatrixMode( GL_TEXTURE );
+            glLoadIdentity();
+            glTranslatef( x * du, 1.0f - ( ( y + 1 ) * dv ), 0.0f );
+            glScalef( du, dv, 1.0f );
+            glMatrixMode( GL_MODELVIEW );
+            tile->mesh->draw();
+            glMatrixMode( GL_TEXTURE );
+            glLoadIdentity();
+            glMatrixMode( GL_MODELVIEW );
+
+            if ( !tile->loadFailed && !tile->loading )
+                wanted.push_back( std::make_pair( angle, tile ) );
+        }
+    }
+}
+
+void EarthTiles::endFrame()
+{
+    collectLoaded();
+
+    // closest to the middle of the view first - tiles still loading count
+    // towards the limit, since they'll be resident soon
+    std::sort( wanted.begin(), wanted.end() );
+    for ( unsigned int i = 0; i < wanted.size() && i < maxLoadsPerFrame; i++ )
+    {
+        if ( loadingCount >= maxLoadingTiles )
+            break;
+        if ( residentCount + loadingCount >= maxResidentTiles )
+            evictOldest();
+        if ( residentCount + loadingCount >= maxResidentTiles )
+            break;
+        loadTile( wanted[i].second );
+    }
+    wanted.clear();
+
+    // free anything that hasn't been looked at in a while - the meshes too,
+    // since they're just as easy to make again
+    std::map<unsigned long, EarthTile*>::iterator i = tiles.begin();
+    while ( i != tiles.end() )
+    {
+        // ones still loading are kept until they arrive, so the texture
+        // doesn't get lost
+        if ( frame - i->second->lastUsed > evictAfterFrames &&
+                !i->second->loading )
+        {
+            freeTile( i->second );
+            delete i->second;
+            tiles.erase( i++ );
+        }
+        else
+            ++i;
+    }
+
+    frame++;
+}
+
+unsigned int EarthTiles::getResidentCount()
+{
+    return residentCount;
+}
+
+unsigned int EarthTiles::getDrawnCount()
+{
+    return drawnCount;
+}
+
+std::string EarthTiles::getTileFile( int level, int x, int y )
+{
+    char name[64];
+    snprintf( name, sizeof( name ), "%i/%i_%i.png", level, x, y );
+    return directory + name;
+}
+
+std::string EarthTiles::getTileName( int level, int x, int y )
+{
+    char name[64];
+    snprintf( name, sizeof( name ), "earth_tiles/%i/%i_%i.png", level, x, y );
+    return std::string( name );
+}
+
+EarthTile* EarthTiles::getTile( int level, int x, int y )
+{
+    unsigned long key = tileKey( level, x, y );
+    std::map<unsigned long, EarthTile*>::iterator i = tiles.find( key );
+    if ( i != tiles.end() )
+        return i->second;
+
+    int cols = 1 << ( level + 1 );
+    int rows = 1 << level;
+    float du = 1.0f / (float)cols;
+    float dv = 1.0f / (float)rows;
+
+    // keep the total tessellation roughly even - big tiles at the low levels
+    // get more quads than the small ones further down
+    int quads = std::max( 4, 32 >> level );
+
+    EarthTile* tile = new EarthTile;
+    tile->level = level;
+    tile->x = x;
+    tile->y = y;
+    tile->mesh = new SphereMesh( radius, x * du, y * dv, du, dv, quads,
+                                 quads );
+    tile->tex = 0;
+    tile->loading = false;
+    tile->loadFailed = false;
+    tile->lastUsed = frame;
+    tiles[ key ] = tile;
+    return tile;
+}
+
+bool EarthTiles::loadTile( EarthTile* tile )
+{
+    // decoded on the loader's threads, uploaded by GLUtil::updateTextures,
+    // and picked up in collectLoaded
+    std::string name = getTileName( tile->level, tile->x, tile->y );
+    if ( !GLUtil::getInstance()->addTextureAsync( name, name, true ) )
+    {
+        // don't keep trying every frame
+        tile->loadFailed = true;
+        return false;
+    }
+
+    tile->loading = true;
+    loadingCount++;
+    return true;
+}
+
+void EarthTiles::collectLoaded()
+{
+    if ( loadingCount == 0 )
+        return;
+
+    GLUtil* glUtil = GLUtil::getInstance();
+    std::map<unsigned long, EarthTile*>::iterator i;
+    for ( i = tiles.begin(); i != tiles.end(); ++i )
+    {
+        EarthTile* tile = i->second;
+        Texture t;
+        if ( !tile->loading || !glUtil->takeTexture(
+                getTileName( tile->level, tile->x, tile->y ), t ) )
+            continue;
+
+        tile->loading = false;
+        loadingCount--;
+        if ( t.ID == 0 )
+        {
+            tile->loadFailed = true;
+            continue;
+        }
+
+        tile->tex = t.ID;
+        setTileParameters( tile );
+    }
+}
+
+void EarthTiles::setTileParameters( EarthTile* tile )
+{
+    glBindTexture( GL_TEXTURE_2D, tile->tex );
+    // clamp so neighbouring tiles don't bleed into each other at the edges
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    // mip levels only get generated with GL 1.4 (see PNGLoader::uploadImage)
+    // - without them a mipmapped filter leaves the texture incomplete
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                     GLEW_VERSION_1_4 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
+    residentCount++;
+}
+
+void EarthTiles::freeTile( EarthTile* tile )
+{
+    if ( tile->tex != 0 )
+    {
+        glDeleteTextures( 1, &tile->tex );
+        tile->tex = 0;
+        residentCount--;
+    }
+    delete tile->mesh;
+    tile->mesh = NULL;
+}
+
+void EarthTiles::evictOldest()
+{
+    // only consider ones not drawn this frame, otherwise we'd just be
+    // swapping out something still on screen
+    EarthTile* oldest = NULL;
+    std::map<unsigned long, EarthTile*>::iterator i;
+    for ( i = tiles.begin(); i != tiles.end(); ++i )
+    {
+        EarthTile* t = i->second;
+        if ( t->tex != 0 && t->lastUsed != frame &&
+                ( oldest == NULL || t->lastUsed < oldest->lastUsed ) )
+            oldest = t;
+    }
+
+    if ( oldest != NULL )
+    {
+        glDeleteTextures( 1, &oldest->tex );
+        oldest->tex = 0;
+        residentCount--;
+    }
+}
@@ -38,6 +38,8 @@ int Frame::toggleRunwayID = wxNewId();
 int Frame::toggleVCCID = wxNewId();
 int Frame::toggleSideFrameID = wxNewId();
 int Frame::toggleAutomaticID = wxNewId();
+int Frame::objectMenuID = wxNewId();
+int Frame::toggleFullscreenID = wxNewId();
 
 BEGIN_EVENT_TABLE(Frame, wxFrame)
 EVT_CLOSE(Frame::OnCloseWindow)
@@ -50,6 +52,8 @@ EVT_MENU(toggleRunwayID, Frame::toggleRunwayEvent)
 EVT_MENU(toggleVCCID, Frame::toggleVCCEvent)
 EVT_MENU(toggleSideFrameID, Frame::toggleSideFrameEvent)
 EVT_MENU(toggleAutomaticID, Frame::toggleAutomaticEvent)
+EVT_MENU(objectMenuID, Frame::objectMenuEvent)
+EVT_MENU(toggleFullscreenID, Frame::toggleFullscreenEvent)
 EVT_MENU_OPEN(Frame::OnMenuOpen)
 END_EVENT_TABLE()
 
@@ -80,12 +84,14 @@ void Frame::setInputHandler( InputHandler* i )
 
 void Frame::spawnPropertyWindow( wxCommandEvent& evt )
 {
+    grav->lockScene();
     for ( unsigned int i = 0; i < grav->getSelectedObjects()->size(); i++ )
     {
         VideoInfoDialog* dialog = new VideoInfoDialog( this,
                 (*grav->getSelectedObjects())[i] );
         dialog->Show();
     }
+    grav->unlockScene();
 }
 
 void Frame::OnCloseWindow( wxCloseEvent& evt )
@@ -183,6 +189,7 @@ void Frame::OnMenuOpen( wxMenuEvent& evt )
     wxMenu* menu = evt.GetMenu();
     wxMenuItemList list = menu->GetMenuItems();
     wxMenuItemList::iterator i;
+    grav->lockScene();
     for ( i = list.begin(); i != list.end(); ++i )
     {
         if ( (*i)->GetId() == toggleRunwayID )
@@ -211,6 +218,7 @@ void Frame::OnMenuOpen( wxMenuEvent& evt )
             (*i)->Check( grav->usingAutoFocusRotate() );
         }
     }
+    grav->unlockScene();
 }
 
 void Frame::setupMenuBar()
@@ -259,6 +267,7 @@ void Frame::cleanupAndDestroy()
         if ( canvas )
         {
             canvas->stopTimer();
+            canvas->stopRenderThread();
         }
     }
 
@@ -284,13 +293,17 @@ SideFrame* Frame::findChildSideFrame()
 
 void Frame::toggleRunwayEvent( wxCommandEvent& evt )
 {
+    grav->lockScene();
     grav->setRunwayUsage( !grav->usingRunway() );
     grav->clearSelected();
+    grav->unlockScene();
 }
 
 void Frame::toggleVCCEvent( wxCommandEvent& evt )
 {
+    grav->lockScene();
     grav->toggleShowVenueClientController();
+    grav->unlockScene();
 }
 
 void Frame::toggleSideFrameEvent( wxCommandEvent& evt )
@@ -304,6 +317,20 @@ void Frame::toggleSideFrameEvent( wxCommandEvent& evt )
 
 void Frame::toggleAutomaticEvent( wxCommandEvent& evt )
 {
+    grav->lockScene();
     grav->setAutoFocusRotate( !grav->usingAutoFocusRotate() );
     grav->resetAutoCounter();
+    grav->unlockScene();
+}
+
+void Frame::objectMenuEvent( wxCommandEvent& evt )
+{
+    wxMenu rightClickMenu;
+    rightClickMenu.Append( InputHandler::propertyID, _("Properties") );
+    PopupMenu( &rightClickMenu, wxPoint( evt.GetInt(), evt.GetExtraLong() ) );
+}
+
+void Frame::toggleFullscreenEvent( wxCommandEvent& evt )
+{
+    ShowFullScreen( !IsFullScreen() );
 }
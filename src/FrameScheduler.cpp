@@ -0,0 +1,188 @@
+/*
+ * @file FrameScheduler.cpp
+ *
+ * Implementation of the render loop's frame timing.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FrameScheduler.h"
+#include "gravUtil.h"
+
+#include <wx/utils.h>
+
+#include <time.h>
+#include <cstdlib>
+
+volatile int64_t FrameScheduler::pendingDecodeUS = 0;
+
+FrameScheduler::FrameScheduler()
+{
+    intervalUS = 0;
+    nextDeadlineUS = 0;
+
+    lastSwapUS = 0;
+    lastIntervalUS = 0;
+    firstDecodeUS = 0;
+
+    periodStartUS = getTimeUS();
+    frameCount = 0;
+    jitterSumUS = 0;
+    jitterCount = 0;
+    maxIntervalUS = 0;
+    lateCount = 0;
+    latencySumUS = 0;
+    latencyCount = 0;
+    maxLatencyUS = 0;
+
+    jitterResult = 0;
+    latencyResult = 0;
+}
+
+void FrameScheduler::setInterval( long us )
+{
+    intervalUS = us;
+    nextDeadlineUS = getTimeUS();
+}
+
+long FrameScheduler::getInterval()
+{
+    return intervalUS;
+}
+
+bool FrameScheduler::isFrameDue()
+{
+    return intervalUS <= 0 || getTimeUS() >= nextDeadlineUS;
+}
+
+void FrameScheduler::waitForFrame( long maxUS )
+{
+    if ( intervalUS <= 0 )
+        return;
+
+    int64_t remaining = nextDeadlineUS - getTimeUS();
+    if ( remaining <= 0 )
+        return;
+
+    if ( remaining > maxUS )
+        remaining = maxUS;
+    wxMicroSleep( (unsigned long)remaining );
+}
+
+void FrameScheduler::frameSwapped()
+{
+    int64_t now = getTimeUS();
+
+    if ( intervalUS > 0 )
+    {
+        nextDeadlineUS += intervalUS;
+        if ( now - nextDeadlineUS >= intervalUS )
+        {
+            nextDeadlineUS = now + intervalUS;
+            lateCount++;
+        }
+    }
+
+    if ( lastSwapUS != 0 )
+    {
+        long interval = (long)( now - lastSwapUS );
+        if ( lastIntervalUS != 0 )
+        {
+            jitterSumUS += labs( interval - lastIntervalUS );
+            jitterCount++;
+        }
+        if ( interval > maxIntervalUS )
+            maxIntervalUS = interval;
+        lastIntervalUS = interval;
+        frameCount++;
+    }
+    lastSwapUS = now;
+
+    if ( firstDecodeUS != 0 )
+    {
+        long latency = (long)( now - firstDecodeUS );
+        latencySumUS += latency;
+        latencyCount++;
+        if ( latency > maxLatencyUS )
+            maxLatencyUS = latency;
+        firstDecodeUS = 0;
+    }
+
+    if ( now - periodStartUS >= reportIntervalUS )
+        report( now );
+}
+
+void FrameScheduler::videoFrameDecoded( VPMVideoSink* sink, int bufferIndex,
+                                        void* userData )
+{
+    // only the first one counts until it's been shown - later ones from other
+    // sources would only make the latency look better
+    if ( pendingDecodeUS == 0 )
+        __sync_bool_compare_and_swap( &pendingDecodeUS, 0, getTimeUS() );
+}
+
+void FrameScheduler::videoFrameUploaded()
+{
+    int64_t decoded = __sync_lock_test_and_set( &pendingDecodeUS, 0 );
+    // nothing pending means an earlier upload this frame already took it
+    if ( decoded == 0 )
+        decoded = getTimeUS();
+    if ( firstDecodeUS == 0 || decoded < firstDecodeUS )
+        firstDecodeUS = decoded;
+}
+
+long FrameScheduler::getJitterUS()
+{
+    return jitterResult;
+}
+
+long FrameScheduler::getLatencyUS()
+{
+    return latencyResult;
+}
+
+int64_t FrameScheduler::getTimeUS()
+{
+    struct timespec t;
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return (int64_t)t.tv_sec * 1000000 + ( t.tv_nsec / 1000 );
+}
+
+void FrameScheduler::report( int64_t now )
+{
+    jitterResult = jitterCount > 0 ? (long)( jitterSumUS / jitterCount ) : 0;
+    latencyResult = latencyCount > 0 ?
+            (long)( latencySumUS / latencyCount ) : 0;
+
+    float fps = (float)frameCount * 1000000.0f / (float)( now - periodStartUS );
+    gravUtil::logVerbose( "FrameScheduler: %.1f fps (target interval %ldus), "
+            "jitter %ldus, max interval %ldus, %i late; decode->swap "
+            "latency avg %ldus max %ldus\n", fps, intervalUS, jitterResult,
+            maxIntervalUS, lateCount, latencyResult, maxLatencyUS );
+
+    periodStartUS = now;
+    frameCount = 0;
+    jitterSumUS = 0;
+    jitterCount = 0;
+    maxIntervalUS = 0;
+    lateCount = 0;
+    latencySumUS = 0;
+    latencyCount = 0;
+    maxLatencyUS = 0;
+}
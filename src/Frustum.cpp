@@ -0,0 +1,108 @@
+/*
+ * @file Frustum.cpp
+ *
+ * Implementation of the camera view volume.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Frustum.h"
+
+#include <GL/glxew.h>
+#include <cmath>
+
+Frustum::Frustum()
+{
+    valid = false;
+    testedCount = 0;
+    culledCount = 0;
+}
+
+void Frustum::update()
+{
+    GLfloat proj[16];
+    GLfloat modl[16];
+    glGetFloatv( GL_PROJECTION_MATRIX, proj );
+    glGetFloatv( GL_MODELVIEW_MATRIX, modl );
+
+    // clip = projection * modelview (both column-major)
+    float clip[16];
+    for ( int col = 0; col < 4; col++ )
+    {
+        for ( int row = 0; row < 4; row++ )
+        {
+            clip[ col*4 + row ] = proj[ row ] * modl[ col*4 ] +
+                                  proj[ 4 + row ] * modl[ col*4 + 1 ] +
+                                  proj[ 8 + row ] * modl[ col*4 + 2 ] +
+                                  proj[ 12 + row ] * modl[ col*4 + 3 ];
+        }
+    }
+
+    // each plane is the 4th row of the clip matrix plus or minus one of the
+    // others: left/right from the 1st, bottom/top from the 2nd, near/far
+    // from the 3rd
+    for ( int i = 0; i < 6; i++ )
+    {
+        int row = i / 2;
+        float sign = ( i % 2 == 0 ) ? 1.0f : -1.0f;
+        for ( int j = 0; j < 4; j++ )
+            planes[i][j] = clip[ j*4 + 3 ] + ( sign * clip[ j*4 + row ] );
+
+        float length = sqrt( planes[i][0] * planes[i][0] +
+                             planes[i][1] * planes[i][1] +
+                             planes[i][2] * planes[i][2] );
+        if ( length > 0.0f )
+        {
+            for ( int j = 0; j < 4; j++ )
+                planes[i][j] /= length;
+        }
+    }
+
+    valid = true;
+    testedCount = 0;
+    culledCount = 0;
+}
+
+bool Frustum::sphereVisible( float x, float y, float z, float radius )
+{
+    if ( !valid )
+        return true;
+
+    testedCount++;
+    for ( int i = 0; i < 6; i++ )
+    {
+        if ( planes[i][0] * x + planes[i][1] * y + planes[i][2] * z +
+                planes[i][3] < -radius )
+        {
+            culledCount++;
+            return false;
+        }
+    }
+    return true;
+}
+
+int Frustum::getTestedCount()
+{
+    return testedCount;
+}
+
+int Frustum::getCulledCount()
+{
+    return culledCount;
+}
@@ -28,6 +28,7 @@
 #include "GLCanvas.h"
 #include "InputHandler.h"
 #include "Timers.h"
+#include "RenderThread.h"
 #if defined(USE_SAGE)
 #include "sail.h"
 sail *sageInf; // sail object
@@ -61,16 +62,26 @@ GLCanvas::GLCanvas( wxWindow* parent, gravManager* g, int* attributes,
 
     useDebugTimers = false;
     renderTimer = NULL;
+    renderThread = NULL;
 }
 
 GLCanvas::~GLCanvas()
 {
+    stopRenderThread();
     delete glContext;
     stopTimer();
 }
 
 void GLCanvas::handlePaintEvent( wxPaintEvent& evt )
 {
+    // the render thread's next frame will cover it - the DC still has to be
+    // made to mark the area as painted
+    if ( renderThread != NULL )
+    {
+        wxPaintDC dc( this );
+        return;
+    }
+
     draw();
 }
 
@@ -86,7 +97,8 @@ void GLCanvas::draw()
     if( !IsShown() ) return;
 
     SetCurrent( *glContext );
-    wxPaintDC( this );
+    if ( renderThread == NULL )
+        wxPaintDC( this );
 
     if ( grav != NULL )
         grav->draw();
@@ -100,6 +112,7 @@ void GLCanvas::draw()
 #endif
 
     SwapBuffers();
+    scheduler.frameSwapped();
 
     if ( useDebugTimers )
     {
@@ -171,7 +184,11 @@ void GLCanvas::resize( wxSizeEvent& evt )
             evt.GetSize().GetWidth(), evt.GetSize().GetHeight() );
     OnSize( evt );
     Refresh( false );
-    GLreshape( evt.GetSize().GetWidth(), evt.GetSize().GetHeight() );
+    if ( renderThread != NULL )
+        renderThread->postResize( evt.GetSize().GetWidth(),
+                                  evt.GetSize().GetHeight() );
+    else
+        GLreshape( evt.GetSize().GetWidth(), evt.GetSize().GetHeight() );
 }
 
 void GLCanvas::GLreshape( int w, int h )
@@ -221,6 +238,29 @@ void GLCanvas::setTimer( RenderTimer* t )
         renderTimer = t;
 }
 
+void GLCanvas::setRenderThread( RenderThread* r )
+{
+    renderThread = r;
+}
+
+void GLCanvas::stopRenderThread()
+{
+    if ( renderThread != NULL )
+        renderThread->stop();
+}
+
+void GLCanvas::makeCurrent()
+{
+    SetCurrent( *glContext );
+}
+
+void GLCanvas::releaseContext()
+{
+#if defined(__WXGTK__)
+    glXMakeCurrent( (Display*)wxGetDisplay(), None, NULL );
+#endif
+}
+
 long GLCanvas::getDrawTime()
 {
     return lastDrawTimeAvg;
@@ -262,3 +302,8 @@ bool GLCanvas::getDebugTimerUsage()
 {
     return useDebugTimers;
 }
+
+FrameScheduler* GLCanvas::getScheduler()
+{
+    return &scheduler;
+}
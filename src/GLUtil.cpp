@@ -25,6 +25,7 @@
 #include "VideoSource.h"
 #include "GLUtil.h"
 #include "PNGLoader.h"
+#include "ResourceLoader.h"
 
 #include <string>
 
@@ -111,17 +112,14 @@ bool GLUtil::initGL()
         mainFont->FaceSize( 100 );
     }
 
-    // TODO this is platform-specific, see the glxew include in glutil.h
-    if ( GLX_SGI_swap_control )
-    {
-        gravUtil::logVerbose( "GLUtil::initGL(): have glx sgi swap control\n" );
-        glXSwapIntervalSGI( 1 );
-    }
-    else
-        gravUtil::logVerbose( "GLUtil::initGL(): no swap control\n" );
+    initSwapControl();
 
     glEnable( GL_DEPTH_TEST );
 
+    glGetIntegerv( GL_MAX_TEXTURE_SIZE, &maxTextureSize );
+    gravUtil::logVerbose( "GLUtil::initGL(): max texture size is %i\n",
+            maxTextureSize );
+
     return true;
 }
 
@@ -371,14 +369,59 @@ void GLUtil::setBufferFontUsage( bool buf )
     useBufferFont = buf;
 }
 
-bool GLUtil::addTexture( std::string name, std::string fileName )
+void GLUtil::setVSync( bool v )
+{
+    useVSync = v;
+}
+
+bool GLUtil::isVSyncEnabled()
+{
+    return vsyncEnabled;
+}
+
+void GLUtil::initSwapControl()
+{
+    // TODO this is platform-specific, see the glxew include in glutil.h
+    int swapInterval = useVSync ? 1 : 0;
+
+    if ( GLXEW_EXT_swap_control )
+    {
+        glXSwapIntervalEXT( glXGetCurrentDisplay(), glXGetCurrentDrawable(),
+                            swapInterval );
+        vsyncEnabled = useVSync;
+        gravUtil::logVerbose( "GLUtil::initGL(): swap interval set to %i "
+                "(glx ext swap control)\n", swapInterval );
+    }
+    else if ( GLXEW_MESA_swap_control )
+    {
+        glXSwapIntervalMESA( swapInterval );
+        vsyncEnabled = useVSync;
+        gravUtil::logVerbose( "GLUtil::initGL(): swap interval set to %i "
+                "(glx mesa swap control)\n", swapInterval );
+    }
+    else if ( GLXEW_SGI_swap_control )
+    {
+        // the SGI one can't turn it off (0 is an error), so if we don't
+        // want vsync just leave it at the driver's default
+        if ( useVSync )
+            glXSwapIntervalSGI( 1 );
+        vsyncEnabled = useVSync;
+        gravUtil::logVerbose( "GLUtil::initGL(): have glx sgi swap control "
+                "(vsync %s)\n", useVSync ? "on" : "left at default" );
+    }
+    else
+        gravUtil::logVerbose( "GLUtil::initGL(): no swap control\n" );
+}
+
+bool GLUtil::addTexture( std::string name, std::string fileName,
+                         bool mipmap )
 {
     Texture t;
 
     std::string texLoc = gravUtil::getInstance()->findFile( fileName );
     if ( texLoc.compare( "" ) != 0 )
     {
-        t.ID = PNGLoader::loadPNG( texLoc, t.width, t.height );
+        t.ID = PNGLoader::loadPNG( texLoc, t.width, t.height, mipmap );
         if ( t.ID != 0 )
         {
             textures[ name ] = t;
@@ -399,6 +442,30 @@ bool GLUtil::addTexture( std::string name, std::string fileName )
     }
 }
 
+bool GLUtil::addTextureAsync( std::string name, std::string fileName,
+                              bool mipmap )
+{
+    std::string texLoc = gravUtil::getInstance()->findFile( fileName );
+    if ( texLoc.compare( "" ) == 0 )
+    {
+        gravUtil::logWarning( "GLUtil::addTextureAsync: warning: "
+                "texture %s not found", fileName.c_str() );
+        return false;
+    }
+
+    if ( loader == NULL )
+        loader = new ResourceLoader();
+    loader->requestTexture( name, texLoc, mipmap );
+    return true;
+}
+
+int GLUtil::updateTextures()
+{
+    if ( loader == NULL )
+        return 0;
+    return loader->uploadFinished( textures, failedTextures );
+}
+
 Texture GLUtil::getTexture( std::string name )
 {
     std::map<std::string, Texture>::iterator i = textures.find( name );
@@ -418,6 +485,28 @@ Texture GLUtil::getTexture( std::string name )
     }
 }
 
+bool GLUtil::takeTexture( std::string name, Texture& t )
+{
+    t.ID = 0;
+    t.width = 0;
+    t.height = 0;
+
+    std::map<std::string, Texture>::iterator i = textures.find( name );
+    if ( i != textures.end() )
+    {
+        t = i->second;
+        textures.erase( i );
+        return true;
+    }
+
+    return failedTextures.erase( name ) > 0;
+}
+
+int GLUtil::getMaxTextureSize()
+{
+    return maxTextureSize;
+}
+
 void GLUtil::setCanvas( GLCanvas* c )
 {
     canvas = c;
@@ -432,6 +521,10 @@ GLUtil::GLUtil()
 {
     enableShaders = false;
     useBufferFont = false;
+    useVSync = true;
+    vsyncEnabled = false;
+    loader = NULL;
+    maxTextureSize = 0;
 
     frag420 =
     "uniform sampler2D texture;\n"
@@ -482,6 +575,7 @@ GLUtil::GLUtil()
 GLUtil::~GLUtil()
 {
     delete mainFont;
+    delete loader;
 
     std::map<std::string, Texture>::iterator i;
     for ( i = textures.begin(); i != textures.end(); ++i )
@@ -25,7 +25,6 @@
 #include "Group.h"
 #include <VPMedia/random_helper.h>
 #include <cmath>
-#include <sstream>
 
 Group::Group( float _x, float _y ) :
     RectangleBase( _x, _y )
@@ -157,20 +156,14 @@ void Group::rearrange()
     rearrange( objects );
 }
 
-void Group::rearrange( std::vector<RectangleBase*> inObjs )
+void Group::rearrange( const std::vector<RectangleBase*>& inObjs )
 {
     // it doesn't make sense to rearrange 0 objects, plus having objects.size
     // = 0 will cause div by 0 crashes later
     if ( inObjs.size() == 0 ) return;
 
-    std::map<std::string, std::vector<RectangleBase*> > data;
-    data["objects"] = inObjs;
-
-    std::map<std::string, std::string> opts;
-    opts["preserveAspect"] =
-            std::string( preserveChildAspect ? "True" : "False" );
-
-    std::ostringstream ss;
+    LayoutOptions opts;
+    opts.preserveAspect = preserveChildAspect;
 
     switch ( rearrangeStyle )
     {
@@ -208,33 +201,24 @@ void Group::rearrange( std::vector<RectangleBase*> inObjs )
                                             destScaleY * (aspect/newAspect) );
         }
 
-        ss << numCol;
-        opts["numX"] = ss.str();
-        ss.str( "" );
-
-        ss << numRow;
-        opts["numY"] = ss.str();
-        ss.str( "" );
+        opts.numX = numCol;
+        opts.numY = numRow;
 
         break;
     }
 
     case ONEROW:
     {
-        ss << inObjs.size();
-        opts["numX"] = ss.str();
-        ss.str( "" );
-        opts["numY"] = "1";
+        opts.numX = inObjs.size();
+        opts.numY = 1;
         break;
     }
 
     case ONECOLUMN:
     {
-        ss << inObjs.size();
-        opts["numX"] = "1";
-        opts["numY"] = ss.str();
-        ss.str( "" );
-        opts["horiz"] = "False";
+        opts.numX = 1;
+        opts.numY = inObjs.size();
+        opts.horiz = false;
         break;
     }
 
@@ -242,11 +226,9 @@ void Group::rearrange( std::vector<RectangleBase*> inObjs )
         break;
     }
 
-    layouts.arrange( "grid",
-                     getDestLBound(), getDestRBound(),
-                     getDestUBound(), getDestDBound(),
-                     0, 0, 0, 0,
-                     data, opts );
+    layouts.gridArrange( getDestLBound(), getDestRBound(),
+                         getDestUBound(), getDestDBound(),
+                         inObjs, opts );
 }
 
 ArrangeStyle Group::getRearrange()
@@ -0,0 +1,237 @@
+/*
+ * @file IncrementalGridLayout.cpp
+ *
+ * Implementation of the grid layout that keeps cell assignments between
+ * updates.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IncrementalGridLayout.h"
+#include "LayoutManager.h"
+#include "RectangleBase.h"
+#include "gravUtil.h"
+
+#include <cmath>
+#include <set>
+#include <algorithm>
+
+IncrementalGridLayout::IncrementalGridLayout()
+{
+    reset();
+}
+
+void IncrementalGridLayout::reset()
+{
+    cells.clear();
+    cellOf.clear();
+    numX = 0; numY = 0;
+    placedCount = 0; placedFilled = 0;
+    boundL = 0.0f; boundR = 0.0f; boundU = 0.0f; boundD = 0.0f;
+}
+
+void IncrementalGridLayout::chooseDimensions( unsigned int num, int& x,
+                                              int& y )
+{
+    if ( num == 0 )
+    {
+        x = 0; y = 0;
+        return;
+    }
+
+    // add columns when gridArrange would (ie, rather than having more rows
+    // than columns), but only take them away once there'd be two too many -
+    // otherwise going back and forth over a perfect square would mean laying
+    // everything out again every time
+    if ( numX == 0 || num > (unsigned int)( numX * numX ) ||
+            ( numX > 1 && num <= (unsigned int)( ( numX - 1 ) *
+                                                 ( numX - 2 ) ) ) )
+        x = ceil( sqrt( num ) );
+    else
+        x = numX;
+
+    // same for rows - add them as needed, but only drop one once there's a
+    // second empty one
+    int needY = num / x + ( num % x > 0 );
+    if ( x == numX && numY >= needY && numY - needY < 2 )
+        y = numY;
+    else
+        y = needY;
+}
+
+int IncrementalGridLayout::getNumX()
+{
+    return numX;
+}
+
+int IncrementalGridLayout::getNumY()
+{
+    return numY;
+}
+
+void IncrementalGridLayout::remove( RectangleBase* object )
+{
+    std::map<RectangleBase*, unsigned int>::iterator i = cellOf.find( object );
+    if ( i == cellOf.end() )
+        return;
+    cells[ i->second ] = NULL;
+    cellOf.erase( i );
+}
+
+bool IncrementalGridLayout::update( const std::vector<RectangleBase*>& objects,
+                                    float outerL, float outerR,
+                                    float outerU, float outerD )
+{
+    int newX, newY;
+    chooseDimensions( objects.size(), newX, newY );
+
+    // area or dimensions changed: nothing we had is valid anymore
+    if ( newX != numX || newY != numY ||
+            outerL != boundL || outerR != boundR ||
+            outerU != boundU || outerD != boundD )
+    {
+        boundL = outerL; boundR = outerR;
+        boundU = outerU; boundD = outerD;
+        numX = newX; numY = newY;
+        reflow( objects );
+        return true;
+    }
+
+    // same dimensions - clear out cells for objects that are gone...
+    std::set<RectangleBase*> current( objects.begin(), objects.end() );
+    for ( unsigned int c = 0; c < cells.size(); c++ )
+    {
+        if ( cells[c] != NULL && current.find( cells[c] ) == current.end() )
+        {
+            cellOf.erase( cells[c] );
+            cells[c] = NULL;
+        }
+    }
+
+    // ...and put new ones in the first empty cells. since the dimensions
+    // didn't change there's always room for everything
+    std::vector<unsigned int> added;
+    unsigned int nextFree = 0;
+    for ( unsigned int i = 0; i < objects.size(); i++ )
+    {
+        if ( cellOf.find( objects[i] ) != cellOf.end() )
+            continue;
+
+        while ( nextFree < cells.size() && cells[ nextFree ] != NULL )
+            nextFree++;
+        if ( nextFree >= cells.size() )
+        {
+            // shouldn't happen, but if it does just start over
+            gravUtil::logWarning( "IncrementalGridLayout::update: out of "
+                                  "cells, doing full layout\n" );
+            reflow( objects );
+            return true;
+        }
+
+        cells[ nextFree ] = objects[i];
+        cellOf[ objects[i] ] = nextFree;
+        added.push_back( nextFree );
+    }
+
+    unsigned int filled = cells.size();
+    while ( filled > 0 && cells[ filled - 1 ] == NULL )
+        filled--;
+
+    // like gridArrange, a lone object fills the whole area and a partial last
+    // row is spread out over the width - so if either of those changed, the
+    // objects they cover have to move too. everything else stays put
+    unsigned int firstMoved = cells.size();
+    if ( ( cellOf.size() == 1 ) != ( placedCount == 1 ) )
+        firstMoved = 0;
+    else if ( filled != placedFilled )
+    {
+        unsigned int lastRow =
+                ( std::min( filled, placedFilled ) + numX - 1 ) / numX;
+        firstMoved = lastRow > 0 ? ( lastRow - 1 ) * numX : 0;
+    }
+    placedCount = cellOf.size();
+    placedFilled = filled;
+
+    for ( unsigned int c = firstMoved; c < cells.size(); c++ )
+    {
+        if ( cells[c] != NULL )
+            place( cells[c], c );
+    }
+    for ( unsigned int i = 0; i < added.size(); i++ )
+    {
+        if ( added[i] < firstMoved )
+            place( cells[ added[i] ], added[i] );
+    }
+
+    return false;
+}
+
+void IncrementalGridLayout::reflow( const std::vector<RectangleBase*>& objects )
+{
+    // keep the existing order as much as possible - objects that already had
+    // a cell go first in their old order, then new objects in list order
+    std::vector<std::pair<unsigned int, unsigned int> > order;
+    for ( unsigned int i = 0; i < objects.size(); i++ )
+    {
+        std::map<RectangleBase*, unsigned int>::iterator c =
+                cellOf.find( objects[i] );
+        unsigned int key = ( c != cellOf.end() ) ? c->second :
+                                cells.size() + i;
+        order.push_back( std::make_pair( key, i ) );
+    }
+    std::sort( order.begin(), order.end() );
+
+    cells.assign( numX * numY, NULL );
+    cellOf.clear();
+
+    for ( unsigned int c = 0; c < order.size(); c++ )
+    {
+        RectangleBase* obj = objects[ order[c].second ];
+        cells[c] = obj;
+        cellOf[ obj ] = c;
+    }
+    placedCount = order.size();
+    placedFilled = order.size();
+
+    for ( unsigned int c = 0; c < order.size(); c++ )
+        place( cells[c], c );
+
+    gravUtil::logVerbose( "IncrementalGridLayout::reflow: %u objects in "
+                          "%ix%i grid\n", (unsigned int)objects.size(),
+                          numX, numY );
+}
+
+void IncrementalGridLayout::place( RectangleBase* object, unsigned int cell )
+{
+    // same as LayoutManager::gridArrange with the default options, so a full
+    // layout over the same cells puts everything in the same place
+    if ( placedCount == 1 )
+    {
+        object->fillToRect( boundL, boundR, boundU, boundD );
+        return;
+    }
+
+    float cellX, cellY;
+    LayoutManager::gridCellCenter( boundL, boundR, boundU, boundD,
+                                   numX, numY, placedFilled, cell,
+                                   cellX, cellY );
+    LayoutManager::fitToCell( object, ( boundR - boundL ) / numX,
+                              ( boundU - boundD ) / numY, true );
+    object->move( cellX, cellY - object->getDestCenterOffsetY() );
+}
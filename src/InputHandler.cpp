@@ -203,8 +203,8 @@ void InputHandler::wxMouseMove( wxMouseEvent& evt )
     // obviously only when the mouse is moving. if need be, can potentially be
     // put off to gravManager::draw() (ie every X frames)
 
-    // note that calculating screen pos -> world pos needs to do a GL call so
-    // this has to be on the main thread
+    // note that calculating screen pos -> world pos uses the GL matrices so
+    // this has to be on the thread that draws
 
     int x = evt.GetPosition().x;
     // GL screen coords are y-flipped relative to GL screen coords
@@ -258,11 +258,16 @@ void InputHandler::wxMouseLDClick( wxMouseEvent& evt )
 
 void InputHandler::wxMouseRDown( wxMouseEvent& evt )
 {
+    // the menu (and the fullscreen/quit below) are passed over to the frame
+    // since this might be on the render thread rather than the GUI thread -
+    // see RenderThread
     if ( grav->getSelectedObjects()->size() > 0 )
     {
-        wxMenu rightClickMenu;
-        rightClickMenu.Append( propertyID, _("Properties") );
-        mainFrame->PopupMenu( &rightClickMenu, evt.GetPosition() );
+        wxCommandEvent menuEvt( wxEVT_COMMAND_MENU_SELECTED,
+                                Frame::objectMenuID );
+        menuEvt.SetInt( evt.GetPosition().x );
+        menuEvt.SetExtraLong( evt.GetPosition().y );
+        mainFrame->AddPendingEvent( menuEvt );
     }
 }
 
@@ -304,28 +309,23 @@ void InputHandler::handleUpdateGroupNames()
 
 void InputHandler::handlePerimeterArrange()
 {
-    std::map<std::string, std::vector<RectangleBase*> > data;
-    data["objects"] = grav->getMovableObjects();
-    layouts.arrange(
-        "perimeter", grav->getScreenRect(), grav->getEarthRect(), data );
+    layouts.arrange( PERIMETER_LAYOUT, grav->getScreenRect(),
+                     grav->getEarthRect(), grav->getMovableObjects() );
 }
 
 void InputHandler::handleGridArrange()
 {
-    std::map<std::string, std::vector<RectangleBase*> > data;
-    data["objects"] = grav->getMovableObjects();
-    layouts.arrange( "grid", grav->getScreenRect(), RectangleBase(), data );
+    layouts.arrange( GRID_LAYOUT, grav->getScreenRect(), RectangleBase(),
+                     grav->getMovableObjects() );
 }
 
 void InputHandler::handleFocusArrange()
 {
     if ( grav->getSelectedObjects()->size() > 0 )
     {
-        std::map<std::string, std::vector<RectangleBase*> > data;
-        data["outers"] = grav->getUnselectedObjects();
-        data["inners"] = *(grav->getSelectedObjects());
-        layouts.arrange( "aspectFocus", grav->getScreenRect(), RectangleBase(),
-                            data );
+        layouts.arrange( ASPECTFOCUS_LAYOUT, grav->getScreenRect(),
+                         RectangleBase(), grav->getUnselectedObjects(),
+                         *(grav->getSelectedObjects()) );
     }
 }
 
@@ -615,12 +615,15 @@ void InputHandler::handleUpscaleSelected()
 
 void InputHandler::handleToggleFullscreen()
 {
-    mainFrame->ShowFullScreen( !mainFrame->IsFullScreen() );
+    wxCommandEvent evt( wxEVT_COMMAND_MENU_SELECTED,
+                        Frame::toggleFullscreenID );
+    mainFrame->AddPendingEvent( evt );
 }
 
 void InputHandler::handleQuit()
 {
-    mainFrame->Close();
+    wxCommandEvent evt( wxEVT_COMMAND_MENU_SELECTED, wxID_EXIT );
+    mainFrame->AddPendingEvent( evt );
 }
 
 void InputHandler::handleClearSelected()
@@ -885,7 +888,7 @@ bool InputHandler::selectVideos()
 {
     bool videoSelected = false;
 
-    std::vector<RectangleBase*>::reverse_iterator si;
+    std::vector<RectangleBase*>::const_reverse_iterator si;
     // reverse means we'll get the video that's on top first, since videos
     // later in the list will render on top of previous ones
     std::vector<RectangleBase*>::const_iterator sli;
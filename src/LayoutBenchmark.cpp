@@ -0,0 +1,307 @@
+/*
+ * @file LayoutBenchmark.cpp
+ *
+ * Implementation of the LayoutManager timing harness.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LayoutBenchmark.h"
+#include "LayoutManager.h"
+#include "RectangleBase.h"
+#include "gravUtil.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <new>
+#include <algorithm>
+
+#include <sys/time.h>
+
+#ifdef GRAV_DEBUG_MODE
+/*
+ * Allocation counting for the benchmark - only in debug builds, since this
+ * replaces the global operator new for the whole program. The counter is only
+ * touched while a benchmark is actually measuring. No exception specs on new
+ * (C++17 doesn't allow throw(std::bad_alloc)), and delete's nothrow spec has
+ * to be spelled differently depending on the standard.
+ */
+#if __cplusplus >= 201103L
+#define BENCH_NOTHROW noexcept
+#else
+#define BENCH_NOTHROW throw()
+#endif
+
+static volatile bool countAllocations = false;
+static volatile unsigned long allocationCount = 0;
+
+void* operator new( size_t size )
+{
+    if ( countAllocations )
+        __sync_fetch_and_add( &allocationCount, 1 );
+    void* p = malloc( size ? size : 1 );
+    if ( p == NULL )
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[]( size_t size )
+{
+    return operator new( size );
+}
+
+void operator delete( void* p ) BENCH_NOTHROW
+{
+    free( p );
+}
+
+void operator delete[]( void* p ) BENCH_NOTHROW
+{
+    free( p );
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete( void* p, size_t ) BENCH_NOTHROW
+{
+    free( p );
+}
+
+void operator delete[]( void* p, size_t ) BENCH_NOTHROW
+{
+    free( p );
+}
+#endif
+#endif
+
+static const unsigned int benchSizes[] = { 10, 30, 100, 300, 1000 };
+static const unsigned int numBenchSizes =
+        sizeof( benchSizes ) / sizeof( benchSizes[0] );
+
+static const char* benchMethods[] =
+        { "grid", "perimeter", "focus", "aspectFocus" };
+static const unsigned int numBenchMethods =
+        sizeof( benchMethods ) / sizeof( benchMethods[0] );
+
+// how long to keep repeating each method/size pair for, in microseconds
+static const long benchTargetUS = 200000;
+
+static long getTimeUS()
+{
+    struct timeval t;
+    gettimeofday( &t, NULL );
+    return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+LayoutBenchmark::LayoutBenchmark()
+{
+    unsigned int max = benchSizes[ numBenchSizes - 1 ];
+    for ( unsigned int i = 0; i < max; i++ )
+    {
+        RectangleBase* obj = new RectangleBase( 0.0f, 0.0f );
+        obj->setAnimation( false );
+        objects.push_back( obj );
+    }
+}
+
+LayoutBenchmark::~LayoutBenchmark()
+{
+    for ( unsigned int i = 0; i < objects.size(); i++ )
+        delete objects[i];
+}
+
+void LayoutBenchmark::resetObjects( unsigned int num )
+{
+    for ( unsigned int i = 0; i < num; i++ )
+    {
+        // mix of 4:3, 16:9 and square-ish objects, like a real session
+        float aspects[] = { 4.0f / 3.0f, 16.0f / 9.0f, 1.2f };
+        float h = 3.0f + (float)( i % 5 ) * 0.5f;
+        objects[i]->setScale( h * aspects[ i % 3 ], h );
+        objects[i]->setPos( (float)( i % 7 ) - 3.0f, (float)( i % 5 ) - 2.0f );
+    }
+}
+
+void LayoutBenchmark::runMethod( std::string method, unsigned int num )
+{
+    LayoutManager layouts;
+    // same sort of screen/earth rects gravManager uses for a 900x550 window
+    RectangleBase screen( 0.0f, 0.0f );
+    screen.setAnimation( false );
+    screen.setScale( 25.6f, 15.6f );
+    RectangleBase inner( 0.0f, 0.0f );
+    inner.setAnimation( false );
+    inner.setScale( 11.0f, 11.0f );
+
+    std::map<std::string, std::vector<RectangleBase*> > data;
+    std::vector<RectangleBase*> objs( objects.begin(),
+                                      objects.begin() + num );
+    if ( method == "focus" || method == "aspectFocus" )
+    {
+        // roughly what audio focus looks like - a few speakers in the middle
+        unsigned int numInners = std::min( num, num / 10 + 1 );
+        data["inners"] = std::vector<RectangleBase*>( objs.begin(),
+                                            objs.begin() + numInners );
+        data["outers"] = std::vector<RectangleBase*>(
+                                            objs.begin() + numInners,
+                                            objs.end() );
+    }
+    else
+    {
+        data["objects"] = objs;
+    }
+
+    resetObjects( num );
+    layouts.arrange( method, screen, inner, data );
+
+    char line[128];
+    for ( unsigned int i = 0; i < num; i++ )
+    {
+        snprintf( line, sizeof( line ), "%s %u %u: %.4f %.4f %.4f %.4f",
+                  method.c_str(), num, i,
+                  objects[i]->getDestX(), objects[i]->getDestY(),
+                  objects[i]->getDestWidth(), objects[i]->getDestHeight() );
+        snapshot.push_back( std::string( line ) );
+    }
+
+    unsigned long iterations = 0;
+#ifdef GRAV_DEBUG_MODE
+    allocationCount = 0;
+    countAllocations = true;
+#endif
+    long start = getTimeUS();
+    long elapsed = 0;
+    while ( elapsed < benchTargetUS || iterations < 3 )
+    {
+        layouts.arrange( method, screen, inner, data );
+        iterations++;
+        elapsed = getTimeUS() - start;
+    }
+#ifdef GRAV_DEBUG_MODE
+    countAllocations = false;
+    gravUtil::logMessage( "LayoutBenchmark: %-12s %5u objects: "
+                          "%10.2f us/call, %8.1f allocs/call\n",
+                          method.c_str(), num,
+                          (double)elapsed / (double)iterations,
+                          (double)allocationCount / (double)iterations );
+#else
+    gravUtil::logMessage( "LayoutBenchmark: %-12s %5u objects: "
+                          "%10.2f us/call\n", method.c_str(), num,
+                          (double)elapsed / (double)iterations );
+#endif
+}
+
+bool LayoutBenchmark::run( std::string snapshotFile )
+{
+    snapshot.clear();
+
+    for ( unsigned int m = 0; m < numBenchMethods; m++ )
+    {
+        for ( unsigned int s = 0; s < numBenchSizes; s++ )
+        {
+            runMethod( benchMethods[m], benchSizes[s] );
+        }
+    }
+
+    if ( snapshotFile.empty() )
+        return true;
+
+    FILE* existing = fopen( snapshotFile.c_str(), "r" );
+    if ( existing == NULL )
+        return writeSnapshot( snapshotFile );
+
+    fclose( existing );
+    return checkSnapshot( snapshotFile );
+}
+
+bool LayoutBenchmark::writeSnapshot( std::string filename )
+{
+    FILE* f = fopen( filename.c_str(), "w" );
+    if ( f == NULL )
+    {
+        gravUtil::logError( "LayoutBenchmark: couldn't write snapshot %s\n",
+                            filename.c_str() );
+        return false;
+    }
+
+    for ( unsigned int i = 0; i < snapshot.size(); i++ )
+        fprintf( f, "%s\n", snapshot[i].c_str() );
+    fclose( f );
+
+    gravUtil::logMessage( "LayoutBenchmark: wrote %u positions to %s\n",
+                          (unsigned int)snapshot.size(), filename.c_str() );
+    return true;
+}
+
+bool LayoutBenchmark::checkSnapshot( std::string filename )
+{
+    FILE* f = fopen( filename.c_str(), "r" );
+    if ( f == NULL )
+        return false;
+
+    char line[128];
+    unsigned int i = 0;
+    unsigned int mismatches = 0;
+    while ( fgets( line, sizeof( line ), f ) != NULL )
+    {
+        std::string expected( line );
+        if ( !expected.empty() && *expected.rbegin() == '\n' )
+            expected.erase( expected.size() - 1 );
+
+        if ( i >= snapshot.size() )
+        {
+            mismatches++;
+            break;
+        }
+
+        if ( expected != snapshot[i] )
+        {
+            // only print the first few, 1000 of these isn't useful
+            if ( mismatches < 10 )
+            {
+                gravUtil::logWarning( "LayoutBenchmark: expected %s\n",
+                                      expected.c_str() );
+                gravUtil::logWarning( "LayoutBenchmark:      got %s\n",
+                                      snapshot[i].c_str() );
+            }
+            mismatches++;
+        }
+        i++;
+    }
+    fclose( f );
+
+    if ( i != snapshot.size() )
+    {
+        gravUtil::logWarning( "LayoutBenchmark: snapshot has %u positions, "
+                              "benchmark produced %u\n", i,
+                              (unsigned int)snapshot.size() );
+        mismatches++;
+    }
+
+    if ( mismatches > 0 )
+    {
+        gravUtil::logError( "LayoutBenchmark: %u positions differ from "
+                            "snapshot %s\n", mismatches, filename.c_str() );
+        return false;
+    }
+
+    gravUtil::logMessage( "LayoutBenchmark: all %u positions match %s\n",
+                          (unsigned int)snapshot.size(), filename.c_str() );
+    return true;
+}
@@ -25,43 +25,118 @@
  */
 
 #include <cstdio>
+#include <cstdlib>
 #include <cmath>
-#include <sstream>
+#include <algorithm>
 
 #include "LayoutManager.h"
 #include "RectangleBase.h"
 
 #include "gravUtil.h"
 
-// Little utility... should be phased out with a better usage of std::map
-bool str2bool(std::string str) { return str.compare( "True" ) == 0; }
-int str2int(std::string str) { return atoi(str.c_str()); }
-float str2fl(std::string str) { return atof(str.c_str()); }
+// method names for the string interface - fixed, so just a static table
+// rather than a lookup map that'd need to be built
+static const struct
+{
+    const char* name;
+    LayoutMethod method;
+} layoutMethodNames[] =
+{
+    { "grid", GRID_LAYOUT },
+    { "perimeter", PERIMETER_LAYOUT },
+    { "focus", FOCUS_LAYOUT },
+    { "aspectFocus", ASPECTFOCUS_LAYOUT }
+};
+static const unsigned int numLayoutMethods =
+        sizeof( layoutMethodNames ) / sizeof( layoutMethodNames[0] );
+
+LayoutOptions::LayoutOptions()
+    : horiz( true ), edge( false ), resize( true ), preserveAspect( true ),
+      numX( 0 ), numY( 0 ), aspect( 1.5555f ), scale( 0.65f )
+{ }
+
+ObjectSpan::ObjectSpan()
+    : first( NULL ), num( 0 ), step( 1 )
+{ }
+
+ObjectSpan::ObjectSpan( const std::vector<RectangleBase*>& objects )
+    : first( objects.empty() ? NULL : &objects[0] ), num( objects.size() ),
+      step( 1 )
+{ }
 
-std::string bool2str(bool b) { return std::string( b ? "True" : "False" ); }
+ObjectSpan::ObjectSpan( RectangleBase* const* start, unsigned int n, int s )
+    : first( start ), num( n ), step( s )
+{ }
 
-std::string int2str(int i)
+ObjectSpan ObjectSpan::sub( unsigned int start, unsigned int count ) const
 {
-    std::ostringstream ss;
-    ss << i;
-    return ss.str();
+    if ( start >= num || count == 0 )
+        return ObjectSpan();
+    count = std::min( count, num - start );
+    return ObjectSpan( first + (int)start * step, count, step );
 }
 
-std::string fl2str(float f)
+ObjectSpan ObjectSpan::reversed() const
 {
-    std::ostringstream ss;
-    ss << f;
-    return ss.str();
+    if ( num == 0 )
+        return ObjectSpan();
+    return ObjectSpan( first + (int)( num - 1 ) * step, num, -step );
 }
 
 LayoutManager::LayoutManager()
 { }
 
-bool LayoutManager::arrange( std::string method,
+bool LayoutManager::findMethod( const std::string& name, LayoutMethod& method )
+{
+    for ( unsigned int i = 0; i < numLayoutMethods; i++ )
+    {
+        if ( name.compare( layoutMethodNames[i].name ) == 0 )
+        {
+            method = layoutMethodNames[i].method;
+            return true;
+        }
+    }
+    return false;
+}
+
+LayoutOptions LayoutManager::parseOptions(
+        const std::map<std::string, std::string>& options )
+{
+    LayoutOptions opts;
+    std::map<std::string, std::string>::const_iterator i;
+
+    for ( i = options.begin(); i != options.end(); ++i )
+    {
+        const std::string& key = i->first;
+        const char* val = i->second.c_str();
+        bool boolVal = i->second.compare( "True" ) == 0;
+
+        if ( key == "horiz" )
+            opts.horiz = boolVal;
+        else if ( key == "edge" )
+            opts.edge = boolVal;
+        else if ( key == "resize" )
+            opts.resize = boolVal;
+        else if ( key == "preserveAspect" )
+            opts.preserveAspect = boolVal;
+        else if ( key == "numX" )
+            opts.numX = atoi( val );
+        else if ( key == "numY" )
+            opts.numY = atoi( val );
+        else if ( key == "aspect" )
+            opts.aspect = atof( val );
+        else if ( key == "scale" )
+            opts.scale = atof( val );
+    }
+
+    return opts;
+}
+
+bool LayoutManager::arrange( const std::string& method,
         RectangleBase outerRect,
         RectangleBase innerRect,
-        std::map<std::string, std::vector<RectangleBase*> > data,
-        std::map<std::string, std::string> options )
+        const std::map<std::string, std::vector<RectangleBase*> >& data,
+        const std::map<std::string, std::string>& options )
 {
     float outerL = outerRect.getDestLBound();
     float outerR = outerRect.getDestRBound();
@@ -79,61 +154,108 @@ bool LayoutManager::arrange( std::string method,
             data, options);
 }
 
-bool LayoutManager::arrange( std::string method,
+bool LayoutManager::arrange( const std::string& method,
         float outerL, float outerR,
         float outerU, float outerD,
         float innerL, float innerR,
         float innerU, float innerD,
-        std::map<std::string, std::vector<RectangleBase*> > data,
-        std::map<std::string, std::string> options )
+        const std::map<std::string, std::vector<RectangleBase*> >& data,
+        const std::map<std::string, std::string>& options )
 {
-    typedef bool (LayoutManager::*fn_ptr)(
-        float oL, float oR, float oU, float oD,
-        float iL, float iR, float iU, float iD,
-        std::map<std::string, std::vector<RectangleBase*> > dat,
-        std::map<std::string, std::string> opts);
-
-    std::map<std::string, fn_ptr> lookup;
-    lookup["perimeter"]   = &LayoutManager::perimeterArrange;
-    lookup["grid"]        = &LayoutManager::gridArrange;
-    lookup["focus"]       = &LayoutManager::focus;
-    lookup["aspectFocus"] = &LayoutManager::aspectFocus;
-
-    if ( lookup.find(method) == lookup.end() )
+    LayoutMethod m;
+    if ( !findMethod( method, m ) )
     {
         gravUtil::logError( "LayoutManager::arrange: method %s not found\n",
                 method.c_str() );
         return false;
     }
-    return (this->*lookup[method])( outerL, outerR, outerU, outerD,
-                                    innerL, innerR, innerU, innerD,
-                                    data, options );
+
+    std::map<std::string, std::vector<RectangleBase*> >::const_iterator
+        objects, inners;
+    if ( m == GRID_LAYOUT || m == PERIMETER_LAYOUT )
+    {
+        objects = data.find( "objects" );
+        if ( objects == data.end() )
+        {
+            gravUtil::logError( "LayoutManager::arrange (%s) was not passed "
+                    "an 'objects'\n", method.c_str() );
+            return false;
+        }
+
+        return arrange( m, outerL, outerR, outerU, outerD,
+                        innerL, innerR, innerU, innerD,
+                        ObjectSpan( objects->second ), ObjectSpan(),
+                        parseOptions( options ) );
+    }
+
+    objects = data.find( "outers" );
+    inners = data.find( "inners" );
+    if ( objects == data.end() || inners == data.end() )
+    {
+        gravUtil::logError( "LayoutManager::arrange (%s) was not passed "
+                "'outers' and 'inners'\n", method.c_str() );
+        return false;
+    }
+
+    return arrange( m, outerL, outerR, outerU, outerD,
+                    innerL, innerR, innerU, innerD,
+                    ObjectSpan( objects->second ),
+                    ObjectSpan( inners->second ),
+                    parseOptions( options ) );
 }
 
-bool LayoutManager::perimeterArrange( float outerL, float outerR,
+bool LayoutManager::arrange( LayoutMethod method,
+        RectangleBase outerRect,
+        RectangleBase innerRect,
+        ObjectSpan objects, ObjectSpan inners,
+        const LayoutOptions& options )
+{
+    return arrange( method,
+            outerRect.getDestLBound(), outerRect.getDestRBound(),
+            outerRect.getDestUBound(), outerRect.getDestDBound(),
+            innerRect.getDestLBound(), innerRect.getDestRBound(),
+            innerRect.getDestUBound(), innerRect.getDestDBound(),
+            objects, inners, options );
+}
+
+bool LayoutManager::arrange( LayoutMethod method,
+        float outerL, float outerR,
         float outerU, float outerD,
         float innerL, float innerR,
         float innerU, float innerD,
-        std::map<std::string, std::vector<RectangleBase*> > data,
-        std::map<std::string, std::string> opts)
+        ObjectSpan objects, ObjectSpan inners,
+        const LayoutOptions& options )
 {
-    //gravUtil::logVerbose( "LayoutManager::perimeter: outer inners: %f,%f %f,%f\n",
-    //        outerL, outerR, outerU, outerD );
-    if ( data.find("objects") == data.end() )
+    switch ( method )
     {
-        gravUtil::logError( "LayoutManager::perimeterArrange was not passed an "
-                "'objects'\n" );
-        return false;
+    case GRID_LAYOUT:
+        return gridArrange( outerL, outerR, outerU, outerD, objects, options );
+    case PERIMETER_LAYOUT:
+        return perimeterArrange( outerL, outerR, outerU, outerD,
+                                 innerL, innerR, innerU, innerD, objects );
+    case FOCUS_LAYOUT:
+        return focus( outerL, outerR, outerU, outerD,
+                      innerL, innerR, innerU, innerD, objects, inners );
+    case ASPECTFOCUS_LAYOUT:
+        return aspectFocus( outerL, outerR, outerU, outerD, objects, inners,
+                            options );
     }
-    std::vector<RectangleBase*> objects = data["objects"];
 
+    gravUtil::logError( "LayoutManager::arrange: invalid method %i\n",
+            (int)method );
+    return false;
+}
+
+bool LayoutManager::perimeterArrange( float outerL, float outerR,
+        float outerU, float outerD,
+        float innerL, float innerR,
+        float innerU, float innerD,
+        ObjectSpan objects )
+{
     float topRatio = (innerR-innerL) / ((outerU-outerD)+(innerR-innerL));
     float sideRatio = (outerU-outerD) / ((outerU-outerD)+(innerR-innerL));
     int topNum, sideNum, bottomNum;
 
-    std::map<std::string, std::string> gridOpts =
-            std::map<std::string, std::string>();
-
     if ( objects.size() == 1 )
     {
         topNum = 1; sideNum = 0; bottomNum = 0;
@@ -145,133 +267,75 @@ bool LayoutManager::perimeterArrange( float outerL, float outerR,
         bottomNum = std::max( (int)objects.size() - topNum - (sideNum*2), 0 );
     }
 
-    //gravUtil::logVerbose( "LayoutManager::perimeter: ratios of area: %f %f, %i %i\n",
-    //        topRatio, sideRatio, topNum, sideNum );
-
-    // create lists of objects on top,right,down,left areas and send them
-    // to be arranged
-    std::vector<RectangleBase*> topObjs, rightObjs, bottomObjs, leftObjs;
-    int end = topNum;
+    // arrange the top, right, bottom & left parts of the list as grids - note
+    // bottom & left go in reverse so the order continues around the perimeter
+    bool ret = true;
+    LayoutOptions gridOpts;
+    gridOpts.resize = true;
 
     if ( topNum > 0 )
     {
-        //gravUtil::logVerbose( "arranging objects %d to %d to top\n", 0, end-1 );
-        for ( int i = 0; i < end; i++ )
-            topObjs.push_back( objects[i] );
-
-        data["objects"] = topObjs;
-        gridOpts["horiz"] = "True";
-        gridOpts["edge"] = "False";
-        gridOpts["resize"] = "True";
-        gridOpts["numX"] = int2str( topNum );
-        gridOpts["numY"] = "1";
+        gridOpts.horiz = true;
+        gridOpts.edge = false;
+        gridOpts.numX = topNum;
+        gridOpts.numY = 1;
 
         // constant on top is for space for text
-        gridArrange( innerL, innerR, outerU-0.8f, innerU,
-                0.0f, 0.0f, 0.0f, 0.0f, data, gridOpts );
+        ret &= gridArrange( innerL, innerR, outerU-0.8f, innerU,
+                objects.sub( 0, topNum ), gridOpts );
     }
 
-    end = topNum + sideNum;
-
     if ( sideNum > 0 )
     {
-        //gravUtil::logVerbose( "arranging objects %d to %d to right\n", topNum, end-1 );
-        for ( int i = topNum; i < end; i++ )
-            rightObjs.push_back( objects[i] );
-
-        data["objects"] = rightObjs;
-        gridOpts["horiz"] = "False";
-        gridOpts["edge"] = "True";
-        gridOpts["resize"] = "True";
-        gridOpts["numX"] = "1";
-        gridOpts["numY"] = int2str( sideNum );
-
-        gridArrange( innerR, outerR, outerU, outerD,
-                0.0f, 0.0f, 0.0f, 0.0f, data, gridOpts );
-    }
+        gridOpts.horiz = false;
+        gridOpts.edge = true;
+        gridOpts.numX = 1;
+        gridOpts.numY = sideNum;
 
-    end = topNum + sideNum + bottomNum;
+        ret &= gridArrange( innerR, outerR, outerU, outerD,
+                objects.sub( topNum, sideNum ), gridOpts );
+    }
 
     if ( bottomNum > 0 )
     {
-        //gravUtil::logVerbose( "arranging objects %d to %d to bottom\n", topNum + sideNum,
-        //        end-1 );
-        for ( int i = end-1; i >= topNum + sideNum; i-- )
-            bottomObjs.push_back( objects[i] );
-
-        data["objects"] = bottomObjs;
-        gridOpts["horiz"] = "True";
-        gridOpts["edge"] = "False";
-        gridOpts["resize"] = "True";
-        gridOpts["numX"] = int2str( bottomNum );
-        gridOpts["numY"] = "1";
-
-        gridArrange( innerL, innerR, innerD, outerD,
-                0.0f, 0.0f, 0.0f, 0.0f, data, gridOpts );
+        gridOpts.horiz = true;
+        gridOpts.edge = false;
+        gridOpts.numX = bottomNum;
+        gridOpts.numY = 1;
+
+        ret &= gridArrange( innerL, innerR, innerD, outerD,
+                objects.sub( topNum + sideNum, bottomNum ).reversed(),
+                gridOpts );
     }
 
-    if ( sideNum > 0 )
+    int leftStart = topNum + sideNum + bottomNum;
+    if ( sideNum > 0 && leftStart < (int)objects.size() )
     {
-        //gravUtil::logVerbose( "arranging objects %d to %d to left\n",
-        //        topNum + sideNum + bottomNum, objects.size()-1 );
-        for ( int i = objects.size()-1; i >= topNum + sideNum + bottomNum; i-- )
-            leftObjs.push_back( objects[i] );
-
-        data["objects"] = leftObjs;
-        gridOpts["horiz"] = "False";
-        gridOpts["edge"] = "True";
-        gridOpts["resize"] = "True";
-        gridOpts["numX"] = "1";
-        gridOpts["numY"] = int2str( sideNum );
-
-        gridArrange( outerL, innerL, outerU, outerD,
-                0.0f, 0.0f, 0.0f, 0.0f, data, gridOpts );
+        gridOpts.horiz = false;
+        gridOpts.edge = true;
+        gridOpts.numX = 1;
+        gridOpts.numY = sideNum;
+
+        ret &= gridArrange( outerL, innerL, outerU, outerD,
+                objects.sub( leftStart, objects.size() - leftStart )
+                    .reversed(),
+                gridOpts );
     }
-    // TODO - return the conjunction of the above gridArrange return values
-    return true;
+
+    return ret;
 }
 
 bool LayoutManager::gridArrange( float outerL, float outerR,
         float outerU, float outerD,
-        float innerL, float innerR,
-        float innerU, float innerD,
-        std::map<std::string, std::vector<RectangleBase*> > data,
-        std::map<std::string, std::string> opts )
+        ObjectSpan objects,
+        const LayoutOptions& options )
 {
-    // Setup opts defaults
-    std::map<std::string, std::string> dflt =
-        std::map<std::string, std::string>();
-    dflt["horiz"] = "True";
-    dflt["edge"] = "False";
-    dflt["resize"] = "True";
-    dflt["preserveAspect"] = "True";
-    dflt["numX"] = "0";
-    dflt["numY"] = "0";
-
-    // Apply the opts defaults to opts
-    for (std::map<std::string,std::string>::iterator i = dflt.begin();
-         i != dflt.end(); i++)
-    {
-        // If the value wasn't specified by our caller, then load the default
-        if ( opts.find(i->first) == opts.end() )
-            opts[i->first] = i->second;
-    }
-
-    bool horiz = str2bool( opts["horiz"] );
-    bool edge = str2bool( opts["edge"] );
-    bool resize = str2bool( opts["resize"] );
-    bool preserveAspect = str2bool( opts["preserveAspect"] );
-    int numX = str2int( opts["numX"] );
-    int numY = str2int( opts["numY"] );
-
-    // Extract object data
-    if ( data.find("objects") == data.end() )
-    {
-        gravUtil::logError( "LayoutManager::gridArrange was not passed an "
-                "'objects'\n" );
-        return false;
-    }
-    std::vector<RectangleBase*> objects = data["objects"];
+    bool horiz = options.horiz;
+    bool edge = options.edge;
+    bool resize = options.resize;
+    bool preserveAspect = options.preserveAspect;
+    int numX = options.numX;
+    int numY = options.numY;
 
     if ( objects.size() == 0 )
         return false;
@@ -373,46 +437,25 @@ bool LayoutManager::gridArrange( float outerL, float outerR,
     {
         for ( unsigned int i = 0; i < objects.size(); i++ )
         {
-            float objectAspect =
-                       objects[i]->getDestTotalWidth()/objects[i]->getDestTotalHeight();
-            float aspect = 1.0f;
-            float newWidth = 1.0f;
-            float newHeight = 1.0f;
             if ( horiz )
-            {
-                aspect = stride / span;
-                // the .95s are to push things away from the edges, which can
-                // cut close due to roundoff error etc.
-                newHeight = span * 0.95f;
-                newWidth = stride * 0.95f;
-            }
+                fitToCell( objects[i], stride, span, preserveAspect );
             else
-            {
-                aspect = span / stride;
-                newHeight = stride * 0.95f;
-                newWidth = span * 0.95f;
-            }
-
-            if ( preserveAspect )
-            {
-                if ( aspect > objectAspect )
-                {
-                    objects[i]->setTotalHeight( newHeight );
-                }
-                else
-                {
-                    objects[i]->setTotalWidth( newWidth );
-                }
-            }
-            else
-            {
-                objects[i]->setTotalSize( newWidth, newHeight );
-            }
+                fitToCell( objects[i], span, stride, preserveAspect );
         }
     }
 
     for ( unsigned int i = 0; i < objects.size(); i++ )
     {
+        // the default arrangement is shared with the one-cell-at-a-time
+        // placement, so the two always agree
+        if ( horiz && !edge )
+        {
+            gridCellCenter( outerL, outerR, outerU, outerD, numX, numY,
+                            objects.size(), i, curX, curY );
+            objects[i]->move( curX, curY - objects[i]->getDestCenterOffsetY() );
+            continue;
+        }
+
         //gravUtil::logVerbose( "grid: moving object %i to %f,%f\n", i, curX, curY );
         objects[i]->move( curX, curY - objects[i]->getDestCenterOffsetY() );
         int objectsLeft = (int)objects.size() - i - 1;
@@ -459,43 +502,50 @@ bool LayoutManager::gridArrange( float outerL, float outerR,
     return true;
 }
 
-bool LayoutManager::focus( float outerL, float outerR,
+void LayoutManager::gridCellCenter( float outerL, float outerR,
         float outerU, float outerD,
-        float innerL, float innerR,
-        float innerU, float innerD,
-        std::map<std::string, std::vector<RectangleBase*> > data,
-        std::map<std::string, std::string> opts)
+        int numX, int numY, unsigned int num,
+        unsigned int index, float& x, float& y )
 {
-    // Extract object data
-    if ( data.find("outers") == data.end() )
-    {
-        gravUtil::logError( "LayoutManager::focus was not passed an "
-                "'outers'\n" );
-        return false;
-    }
-    if ( data.find("inners") == data.end() )
-    {
-        gravUtil::logError( "LayoutManager::focus was not passed an "
-                "'inners'\n" );
-        return false;
-    }
-    std::vector<RectangleBase*> outers = data["outers"];
-    std::vector<RectangleBase*> inners = data["inners"];
+    int row = index / numX;
+    int col = index % numX;
+    int inRow = std::min( numX, (int)num - ( row * numX ) );
+    float stride = ( outerR - outerL ) / std::max( 1, inRow );
+    float span = ( outerU - outerD ) / numY;
+
+    x = outerL + ( stride * ( col + 0.5f ) );
+    y = outerU - ( span * ( row + 0.5f ) );
+}
 
-    // Setup opts defaults
-    std::map<std::string, std::string> dflt =
-        std::map<std::string, std::string>();
-    dflt["scaleX"] = "0.65";   dflt["scaleY"] = "0.6";
+void LayoutManager::fitToCell( RectangleBase* object, float cellWidth,
+        float cellHeight, bool preserveAspect )
+{
+    // the .95s are to push things away from the edges, which can cut close
+    // due to roundoff error etc.
+    float newWidth = cellWidth * 0.95f;
+    float newHeight = cellHeight * 0.95f;
 
-    // Apply the opts defaults to opts
-    for (std::map<std::string,std::string>::iterator i = dflt.begin();
-         i != dflt.end(); i++)
+    if ( preserveAspect )
     {
-        // If the value wasn't specified by our caller, then load the default
-        if ( opts.find(i->first) == opts.end() )
-            opts[i->first] = i->second;
+        float objectAspect =
+                object->getDestTotalWidth() / object->getDestTotalHeight();
+        if ( cellWidth / cellHeight > objectAspect )
+            object->setTotalHeight( newHeight );
+        else
+            object->setTotalWidth( newWidth );
     }
+    else
+    {
+        object->setTotalSize( newWidth, newHeight );
+    }
+}
 
+bool LayoutManager::focus( float outerL, float outerR,
+        float outerU, float outerD,
+        float innerL, float innerR,
+        float innerU, float innerD,
+        ObjectSpan outers, ObjectSpan inners )
+{
     float gridBoundL;
     float gridBoundR;
     float gridBoundU;
@@ -521,8 +571,7 @@ bool LayoutManager::focus( float outerL, float outerR,
         float Xdist = ( innerR - innerL ) / 2.0f;
         float Ydist = ( innerU - innerD ) / 2.0f;
         // .95f to give some extra room
-        // TODO make this an argument?
-        // could be easier now with the opts map?
+        // TODO make this an option?
         gridBoundL = centerX - (Xdist*0.95f);
         gridBoundR = centerX + (Xdist*0.95f);
         gridBoundU = centerY + (Ydist*0.95f);
@@ -533,30 +582,21 @@ bool LayoutManager::focus( float outerL, float outerR,
         perimeterInnerD = centerY - Ydist;
     }
 
-    std::map<std::string, std::vector<RectangleBase*> > gridData =
-        std::map<std::string, std::vector<RectangleBase*> >();
-    gridData["objects"] = inners;
-
-    std::map<std::string, std::string> gridOpts =
-                std::map<std::string, std::string>();
-    gridOpts["horiz"] = "True";
-    gridOpts["edge"] = "False";
-    gridOpts["resize"] = "True";
+    LayoutOptions gridOpts;
+    gridOpts.horiz = true;
+    gridOpts.edge = false;
+    gridOpts.resize = true;
 
     bool gridRes = gridArrange( gridBoundL, gridBoundR, gridBoundU, gridBoundD,
-                                 0.0f, 0.0f, 0.0f, 0.0f,
-                                 gridData, gridOpts );
+                                inners, gridOpts );
 
     bool perimRes = true;
     if ( !outers.empty() )
     {
-        std::map<std::string, std::vector<RectangleBase*> > perimData =
-                std::map<std::string, std::vector<RectangleBase*> >();
-        perimData["objects"] = outers;
         perimRes = perimeterArrange( outerL, outerR, outerU, outerD,
                             perimeterInnerL, perimeterInnerR,
                             perimeterInnerU, perimeterInnerD,
-                            perimData );
+                            outers );
     }
 
     return gridRes && perimRes;
@@ -564,45 +604,12 @@ bool LayoutManager::focus( float outerL, float outerR,
 
 bool LayoutManager::aspectFocus( float outerL, float outerR,
         float outerU, float outerD,
-        float innerL, float innerR,
-        float innerU, float innerD,
-        std::map<std::string, std::vector<RectangleBase*> > data,
-        std::map<std::string, std::string> opts )
+        ObjectSpan outers, ObjectSpan inners,
+        const LayoutOptions& options )
 {
-    // Extract object data
-    if ( data.find("outers") == data.end() )
-    {
-        gravUtil::logError( "LayoutManager::aspectfocus was not passed an "
-                "'outers'\n" );
-        return false;
-    }
-    if ( data.find("inners") == data.end() )
-    {
-        gravUtil::logError( "LayoutManager::aspectfocus was not passed an "
-                "'inners'\n" );
-        return false;
-    }
-    std::vector<RectangleBase*> outers = data["outers"];
-    std::vector<RectangleBase*> inners = data["inners"];
-
-    // Setup opts defaults
-    std::map<std::string, std::string> dflt =
-        std::map<std::string, std::string>();
-    dflt["aspect"] = "1.5555";
-    dflt["scale"] = "0.65";
-
-    // Apply the opts defaults to opts
-    for (std::map<std::string,std::string>::iterator i = dflt.begin();
-         i != dflt.end(); i++)
-    {
-        // If the value wasn't specified by our caller, then load the default
-        if ( opts.find(i->first) == opts.end() )
-            opts[i->first] = i->second;
-    }
-
     float outerAspect = ( outerR - outerL ) / ( outerU - outerD );
-    float aspect = str2fl( opts["aspect"] );
-    float scale = str2fl( opts["scale"] );
+    float aspect = options.aspect;
+    float scale = options.scale;
     float centerX = ( outerL + outerR ) / 2.0f;
     float centerY = ( outerD + outerU ) / 2.0f;
     float width = outerR - outerL;
@@ -625,12 +632,8 @@ bool LayoutManager::aspectFocus( float outerL, float outerR,
         xScale = yScale * aspect;
     }
 
-    innerL = centerX - xScale;
-    innerR = centerX + xScale;
-    innerU = centerY + yScale;
-    innerD = centerY - yScale;
-
     return focus( outerL, outerR, outerU, outerD,
-                  innerL, innerR, innerU, innerD,
-                  data, opts );
+                  centerX - xScale, centerX + xScale,
+                  centerY + yScale, centerY - yScale,
+                  outers, inners );
 }
@@ -0,0 +1,327 @@
+/*
+ * @file LayoutWorker.cpp
+ *
+ * Implementation of the threaded layout runner.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LayoutWorker.h"
+#include "gravUtil.h"
+
+#include <wx/utils.h>
+
+/*
+ * Stand-in for an object while its layout is being worked out. Copies the
+ * object's state and reproduces its width/height behavior (ie, videos are
+ * aspect * scale wide) without touching the original, which the main thread
+ * may be drawing or modifying meanwhile.
+ */
+class LayoutProxy : public RectangleBase
+{
+
+public:
+    LayoutProxy( RectangleBase* obj ) :
+        RectangleBase( *obj ), original( obj )
+    {
+        // (the copy has the same dest scale as the original)
+        widthFactor = destScaleX != 0.0f ?
+                        obj->getDestWidth() / destScaleX : 1.0f;
+        originalAspect = obj->getOriginalAspect();
+        setAnimation( false );
+
+        snapX = obj->getDestX();
+        snapY = obj->getDestY();
+        snapWidth = obj->getDestWidth();
+        snapHeight = obj->getDestHeight();
+    }
+
+    float getWidth() { return widthFactor * scaleX; }
+    float getDestWidth() { return widthFactor * destScaleX; }
+
+    void setWidth( float w )
+    {
+        setScale( w / widthFactor,
+                  destScaleY * ( w / ( destScaleX * widthFactor ) ) );
+    }
+
+    float getOriginalAspect() { return originalAspect; }
+
+    float getResultScaleX() { return destScaleX; }
+    float getResultScaleY() { return destScaleY; }
+
+    // set to NULL if the object gets deleted before results are applied
+    RectangleBase* original;
+
+    // the original's destination when the request was made
+    float snapX, snapY, snapWidth, snapHeight;
+
+private:
+    float widthFactor;
+    float originalAspect;
+
+};
+
+struct LayoutRequest
+{
+    LayoutMethod method;
+    float outerL, outerR, outerU, outerD;
+    float innerL, innerR, innerU, innerD;
+    LayoutOptions options;
+
+    // proxies for objects and inners respectively, in order
+    std::vector<RectangleBase*> objects;
+    std::vector<RectangleBase*> inners;
+
+    ~LayoutRequest()
+    {
+        for ( unsigned int i = 0; i < objects.size(); i++ )
+            delete objects[i];
+        for ( unsigned int i = 0; i < inners.size(); i++ )
+            delete inners[i];
+    }
+};
+
+LayoutWorker::LayoutWorker()
+{
+    queueMutex = mutex_create();
+    workerThread = NULL;
+    running = false;
+    current = NULL;
+}
+
+LayoutWorker::~LayoutWorker()
+{
+    stop();
+
+    for ( unsigned int i = 0; i < pending.size(); i++ )
+        delete pending[i];
+    for ( unsigned int i = 0; i < finished.size(); i++ )
+        delete finished[i];
+
+    mutex_free( queueMutex );
+}
+
+void LayoutWorker::start()
+{
+    if ( running )
+        return;
+
+    running = true;
+    workerThread = thread_start( threadMain, this );
+}
+
+void LayoutWorker::stop()
+{
+    if ( !running )
+        return;
+
+    running = false;
+    thread_join( workerThread );
+    workerThread = NULL;
+
+    // finish whatever's left here, same as if it had been requested with the
+    // thread stopped - otherwise it'd just sit in the queue
+    std::deque<LayoutRequest*> left;
+    mutex_lock( queueMutex );
+    left.swap( pending );
+    mutex_unlock( queueMutex );
+
+    for ( unsigned int i = 0; i < left.size(); i++ )
+    {
+        compute( left[i] );
+        mutex_lock( queueMutex );
+        finished.push_back( left[i] );
+        mutex_unlock( queueMutex );
+    }
+}
+
+void LayoutWorker::request( LayoutMethod method, RectangleBase outerRect,
+                            RectangleBase innerRect,
+                            ObjectSpan objects, ObjectSpan inners,
+                            const LayoutOptions& options )
+{
+    LayoutRequest* req = new LayoutRequest();
+    req->method = method;
+    req->outerL = outerRect.getDestLBound();
+    req->outerR = outerRect.getDestRBound();
+    req->outerU = outerRect.getDestUBound();
+    req->outerD = outerRect.getDestDBound();
+    req->innerL = innerRect.getDestLBound();
+    req->innerR = innerRect.getDestRBound();
+    req->innerU = innerRect.getDestUBound();
+    req->innerD = innerRect.getDestDBound();
+    req->options = options;
+
+    for ( unsigned int i = 0; i < objects.size(); i++ )
+        req->objects.push_back( new LayoutProxy( objects[i] ) );
+    for ( unsigned int i = 0; i < inners.size(); i++ )
+        req->inners.push_back( new LayoutProxy( inners[i] ) );
+
+    if ( !running )
+    {
+        compute( req );
+        mutex_lock( queueMutex );
+        finished.push_back( req );
+        mutex_unlock( queueMutex );
+        return;
+    }
+
+    mutex_lock( queueMutex );
+    pending.push_back( req );
+    mutex_unlock( queueMutex );
+}
+
+void LayoutWorker::compute( LayoutRequest* req )
+{
+    layouts.arrange( req->method,
+                     req->outerL, req->outerR, req->outerU, req->outerD,
+                     req->innerL, req->innerR, req->innerU, req->innerD,
+                     req->objects, req->inners, req->options );
+}
+
+int LayoutWorker::applyResults()
+{
+    std::vector<LayoutRequest*> done;
+    mutex_lock( queueMutex );
+    done.swap( finished );
+    mutex_unlock( queueMutex );
+
+    int applied = 0;
+    for ( unsigned int r = 0; r < done.size(); r++ )
+    {
+        std::vector<RectangleBase*>* lists[2] =
+            { &done[r]->objects, &done[r]->inners };
+        for ( unsigned int l = 0; l < 2; l++ )
+        {
+            for ( unsigned int i = 0; i < lists[l]->size(); i++ )
+            {
+                LayoutProxy* proxy = (LayoutProxy*)(*lists[l])[i];
+                RectangleBase* obj = proxy->original;
+                if ( obj == NULL )
+                    continue;
+
+                // if it's been moved since the snapshot, by something other
+                // than an earlier result from here, keep the newer position
+                float x = obj->getDestX();
+                float y = obj->getDestY();
+                float w = obj->getDestWidth();
+                float h = obj->getDestHeight();
+                bool unchanged = x == proxy->snapX && y == proxy->snapY &&
+                        w == proxy->snapWidth && h == proxy->snapHeight;
+                std::map<RectangleBase*, AppliedDest>::iterator last =
+                        lastApplied.find( obj );
+                if ( !unchanged && last != lastApplied.end() )
+                {
+                    unchanged = x == last->second.x && y == last->second.y &&
+                            w == last->second.width &&
+                            h == last->second.height;
+                }
+                if ( !unchanged )
+                    continue;
+
+                // scale before move since the position was worked out with
+                // the new size
+                obj->setScale( proxy->getResultScaleX(),
+                               proxy->getResultScaleY() );
+                obj->move( proxy->getDestX(), proxy->getDestY() );
+
+                AppliedDest dest;
+                dest.x = obj->getDestX();
+                dest.y = obj->getDestY();
+                dest.width = obj->getDestWidth();
+                dest.height = obj->getDestHeight();
+                lastApplied[ obj ] = dest;
+                applied++;
+            }
+        }
+        delete done[r];
+    }
+
+    return applied;
+}
+
+void LayoutWorker::forget( RectangleBase* object )
+{
+    lastApplied.erase( object );
+
+    mutex_lock( queueMutex );
+
+    std::vector<LayoutRequest*> all( pending.begin(), pending.end() );
+    all.insert( all.end(), finished.begin(), finished.end() );
+    if ( current != NULL )
+        all.push_back( current );
+    for ( unsigned int r = 0; r < all.size(); r++ )
+    {
+        for ( unsigned int i = 0; i < all[r]->objects.size(); i++ )
+        {
+            LayoutProxy* proxy = (LayoutProxy*)all[r]->objects[i];
+            if ( proxy->original == object )
+                proxy->original = NULL;
+        }
+        for ( unsigned int i = 0; i < all[r]->inners.size(); i++ )
+        {
+            LayoutProxy* proxy = (LayoutProxy*)all[r]->inners[i];
+            if ( proxy->original == object )
+                proxy->original = NULL;
+        }
+    }
+
+    mutex_unlock( queueMutex );
+}
+
+void* LayoutWorker::threadMain( void* args )
+{
+    LayoutWorker* worker = (LayoutWorker*)args;
+    gravUtil::logVerbose( "LayoutWorker::starting layout thread...\n" );
+
+    while ( worker->running )
+    {
+        LayoutRequest* req = NULL;
+        mutex_lock( worker->queueMutex );
+        if ( !worker->pending.empty() )
+        {
+            req = worker->pending.front();
+            worker->pending.pop_front();
+            worker->current = req;
+        }
+        mutex_unlock( worker->queueMutex );
+
+        // layouts are rare, so just poll rather than needing a condition
+        // variable - a few ms of latency doesn't matter since the results get
+        // animated anyway
+        if ( req == NULL )
+        {
+            wxMilliSleep( 5 );
+            continue;
+        }
+
+        // forget() may clear originals in this while it's being computed,
+        // which is fine since the layout only uses the proxies' geometry
+        worker->compute( req );
+
+        mutex_lock( worker->queueMutex );
+        worker->finished.push_back( req );
+        worker->current = NULL;
+        mutex_unlock( worker->queueMutex );
+    }
+
+    gravUtil::logVerbose( "LayoutWorker::layout thread ending...\n" );
+    return 0;
+}
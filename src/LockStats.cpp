@@ -0,0 +1,136 @@
+/*
+ * @file LockStats.cpp
+ *
+ * Implementation of the lock wait/hold time histograms.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LockStats.h"
+#include "gravUtil.h"
+
+LockStats::LockStats()
+{
+    reset();
+}
+
+void LockStats::reset()
+{
+    for ( int i = 0; i < numBuckets; i++ )
+    {
+        waitCounts[i] = 0;
+        holdCounts[i] = 0;
+    }
+    numWaits = 0;
+    numHolds = 0;
+    maxWait = 0;
+    maxHold = 0;
+}
+
+int LockStats::getBucket( long us )
+{
+    int bucket = 0;
+    while ( bucket < numBuckets - 1 && us >= ( 1L << bucket ) )
+        bucket++;
+    return bucket;
+}
+
+void LockStats::addWait( long us )
+{
+    waitCounts[ getBucket( us ) ]++;
+    numWaits++;
+    if ( us > maxWait )
+        maxWait = us;
+}
+
+void LockStats::addHold( long us )
+{
+    holdCounts[ getBucket( us ) ]++;
+    numHolds++;
+    if ( us > maxHold )
+        maxHold = us;
+}
+
+long LockStats::getPercentile( unsigned long* counts, unsigned long total,
+                               float p )
+{
+    if ( total == 0 )
+        return 0;
+
+    unsigned long target = (unsigned long)( (float)total * p );
+    unsigned long sum = 0;
+    for ( int i = 0; i < numBuckets; i++ )
+    {
+        sum += counts[i];
+        if ( sum > target )
+            return 1L << i;
+    }
+    return 1L << ( numBuckets - 1 );
+}
+
+long LockStats::getHoldPercentile( float p )
+{
+    return getPercentile( holdCounts, numHolds, p );
+}
+
+long LockStats::getWaitPercentile( float p )
+{
+    return getPercentile( waitCounts, numWaits, p );
+}
+
+long LockStats::getMaxHold()
+{
+    return maxHold;
+}
+
+long LockStats::getMaxWait()
+{
+    return maxWait;
+}
+
+unsigned long LockStats::getNumLocks()
+{
+    return numHolds;
+}
+
+void LockStats::logHistogram( unsigned long* counts, unsigned long total )
+{
+    for ( int i = 0; i < numBuckets; i++ )
+    {
+        if ( counts[i] == 0 )
+            continue;
+        gravUtil::logVerbose( "    < %8ld us: %8lu (%5.1f%%)\n", 1L << i,
+                              counts[i],
+                              100.0f * (float)counts[i] / (float)total );
+    }
+}
+
+void LockStats::log( std::string name )
+{
+    gravUtil::logVerbose( "LockStats::%s: %lu locks, max wait %ld us, "
+                          "max hold %ld us\n", name.c_str(), numHolds, maxWait,
+                          maxHold );
+    if ( numHolds == 0 )
+        return;
+
+    gravUtil::logVerbose( "  wait times:\n" );
+    logHistogram( waitCounts, numWaits );
+    gravUtil::logVerbose( "  hold times:\n" );
+    logHistogram( holdCounts, numHolds );
+}
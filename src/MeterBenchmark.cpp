@@ -0,0 +1,157 @@
+/*
+ * @file MeterBenchmark.cpp
+ *
+ * Implementation of the audio meter timing harness.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MeterBenchmark.h"
+#include "AudioLevelMeter.h"
+#include "gravUtil.h"
+
+#include <cmath>
+
+#include <sys/time.h>
+
+// 20ms packets at 8kHz mono, 16kHz mono, 48kHz mono & 48kHz stereo (plus an
+// odd size to make sure the tail handling gets checked)
+static const uint32_t benchSizes[] = { 160, 320, 960, 1920, 1931 };
+static const unsigned int numBenchSizes =
+        sizeof( benchSizes ) / sizeof( benchSizes[0] );
+
+// how long to keep repeating each kernel/size pair for, in microseconds
+static const long benchTargetUS = 200000;
+
+// samples per second for the "sources per core" estimate - 48kHz stereo
+static const double sourceRate = 96000.0;
+
+static long getTimeUS()
+{
+    struct timeval t;
+    gettimeofday( &t, NULL );
+    return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+MeterBenchmark::MeterBenchmark()
+{
+    // a couple of tones plus some noise, with the volume swinging between
+    // quiet and full scale (including hitting -32768) so both the sums and
+    // the peak tracking get exercised
+    const uint32_t total = 96000 * 2;
+    unsigned int noise = 12345;
+    samples.resize( total );
+    for ( uint32_t i = 0; i < total; i++ )
+    {
+        noise = noise * 1103515245u + 12345u;
+        double t = (double)i / 96000.0;
+        double v = 0.6 * sin( t * 2.0 * M_PI * 220.0 ) +
+                   0.3 * sin( t * 2.0 * M_PI * 1375.0 ) +
+                   0.1 * ( (double)( ( noise >> 16 ) & 0x7FFF ) / 16384.0 -
+                           1.0 );
+        double envelope = 0.5 + 0.5 * sin( t * 2.0 * M_PI * 0.7 );
+        double s = v * envelope * 40000.0;
+        if ( s > 32767.0 )
+            s = 32767.0;
+        if ( s < -32768.0 )
+            s = -32768.0;
+        samples[i] = (int16_t)s;
+    }
+}
+
+double MeterBenchmark::runKernel( const char* name, MeasureFunc func,
+                                  uint32_t num, unsigned int& mismatches )
+{
+    uint32_t numBlocks = samples.size() / num;
+
+    // check every block once against scalar first
+    for ( uint32_t b = 0; b < numBlocks; b++ )
+    {
+        uint64_t sum, expectedSum;
+        int p, expectedPeak;
+        func( &samples[ b * num ], num, sum, p );
+        AudioLevelMeter::measureScalar( &samples[ b * num ], num,
+                                        expectedSum, expectedPeak );
+        if ( sum != expectedSum || p != expectedPeak )
+            mismatches++;
+    }
+
+    // (the sum gets used so the loop can't be optimized away)
+    volatile uint64_t sink = 0;
+    unsigned long blocks = 0;
+    long start = getTimeUS();
+    long elapsed = 0;
+    while ( elapsed < benchTargetUS || blocks < 3 )
+    {
+        for ( uint32_t b = 0; b < numBlocks; b++ )
+        {
+            uint64_t sum;
+            int p;
+            func( &samples[ b * num ], num, sum, p );
+            sink = sink + sum + p;
+        }
+        blocks += numBlocks;
+        elapsed = getTimeUS() - start;
+    }
+
+    double nsPerSample = (double)elapsed * 1000.0 /
+                         ( (double)blocks * (double)num );
+    gravUtil::logMessage( "MeterBenchmark: %-6s %5u samples: %7.3f ns/sample, "
+                          "~%.0f 48k stereo sources/core\n", name, num,
+                          nsPerSample, 1.0e9 / ( nsPerSample * sourceRate ) );
+    return nsPerSample;
+}
+
+bool MeterBenchmark::run()
+{
+    gravUtil::logMessage( "MeterBenchmark: meters will use %s kernel\n",
+                          AudioLevelMeter::getKernelName() );
+
+    unsigned int mismatches = 0;
+    for ( unsigned int s = 0; s < numBenchSizes; s++ )
+    {
+        uint32_t num = benchSizes[s];
+        double scalar = runKernel( "scalar", &AudioLevelMeter::measureScalar,
+                                   num, mismatches );
+#ifdef GRAV_METER_SSE2
+        double sse2 = runKernel( "SSE2", &AudioLevelMeter::measureSSE2, num,
+                                 mismatches );
+        gravUtil::logMessage( "MeterBenchmark: SSE2 speedup %.2fx\n",
+                              scalar / sse2 );
+#endif
+#ifdef GRAV_METER_AVX2
+        if ( AudioLevelMeter::haveAVX2() )
+        {
+            double avx2 = runKernel( "AVX2", &AudioLevelMeter::measureAVX2,
+                                     num, mismatches );
+            gravUtil::logMessage( "MeterBenchmark: AVX2 speedup %.2fx\n",
+                                  scalar / avx2 );
+        }
+#endif
+    }
+
+    if ( mismatches > 0 )
+    {
+        gravUtil::logError( "MeterBenchmark: %u blocks didn't match the "
+                            "scalar kernel\n", mismatches );
+        return false;
+    }
+    gravUtil::logMessage( "MeterBenchmark: all kernels match\n" );
+    return true;
+}
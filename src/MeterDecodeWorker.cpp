@@ -0,0 +1,228 @@
+/*
+ * @file MeterDecodeWorker.cpp
+ *
+ * Implementation of the audio level measuring thread.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MeterDecodeWorker.h"
+#include "gravUtil.h"
+
+#include <cstring>
+#include <sys/time.h>
+
+#include <wx/utils.h>
+
+MeterDecodeWorker::MeterDecodeWorker()
+{
+    queueMutex = mutex_create();
+    dropped = 0;
+    workerThread = NULL;
+    running = false;
+}
+
+MeterDecodeWorker::~MeterDecodeWorker()
+{
+    stop();
+
+    std::set<MeterChannel*>::iterator i;
+    for ( i = channels.begin(); i != channels.end(); ++i )
+        delete *i;
+
+    mutex_free( queueMutex );
+}
+
+void MeterDecodeWorker::start()
+{
+    if ( running )
+        return;
+
+    running = true;
+    workerThread = thread_start( threadMain, this );
+}
+
+void MeterDecodeWorker::stop()
+{
+    if ( !running )
+        return;
+
+    running = false;
+    thread_join( workerThread );
+    workerThread = NULL;
+
+    // nothing's going to measure what's left, but releases still need doing
+    mutex_lock( queueMutex );
+    for ( unsigned int i = 0; i < jobs.size(); i++ )
+    {
+        if ( jobs[i].type == MeterJob::RELEASE )
+        {
+            channels.erase( jobs[i].channel );
+            delete jobs[i].channel;
+        }
+    }
+    jobs.clear();
+    bytes.clear();
+    mutex_unlock( queueMutex );
+}
+
+MeterChannel* MeterDecodeWorker::createChannel( AudioCodecMeter::Codec codec )
+{
+    MeterChannel* channel = new MeterChannel;
+    channel->codec = codec;
+    channel->worker = this;
+    channel->level = 0.0f;
+    channel->lastPacketMS = getTimeMS();
+
+    mutex_lock( queueMutex );
+    channels.insert( channel );
+    mutex_unlock( queueMutex );
+    return channel;
+}
+
+void MeterDecodeWorker::releaseChannel( MeterChannel* channel )
+{
+    mutex_lock( queueMutex );
+    if ( running )
+    {
+        MeterJob job;
+        job.type = MeterJob::RELEASE;
+        job.channel = channel;
+        job.offset = 0;
+        job.length = 0;
+        jobs.push_back( job );
+        mutex_unlock( queueMutex );
+        return;
+    }
+
+    // if the thread isn't running nothing can be queued for it
+    channels.erase( channel );
+    mutex_unlock( queueMutex );
+    delete channel;
+}
+
+void MeterDecodeWorker::post( MeterChannel* channel, const uint8_t* data,
+                              uint32_t length )
+{
+    if ( !running || length == 0 )
+        return;
+
+    mutex_lock( queueMutex );
+    if ( bytes.size() + length > maxQueuedBytes )
+    {
+        mutex_unlock( queueMutex );
+        // (only written here, under the lock)
+        dropped++;
+        return;
+    }
+
+    MeterJob job;
+    job.type = MeterJob::PACKET;
+    job.channel = channel;
+    job.offset = bytes.size();
+    job.length = length;
+    bytes.resize( bytes.size() + length );
+    memcpy( &bytes[ job.offset ], data, length );
+    jobs.push_back( job );
+    mutex_unlock( queueMutex );
+}
+
+unsigned long MeterDecodeWorker::getDroppedCount()
+{
+    return dropped;
+}
+
+void* MeterDecodeWorker::threadMain( void* args )
+{
+    MeterDecodeWorker* worker = (MeterDecodeWorker*)args;
+    gravUtil::logVerbose( "MeterDecodeWorker::starting meter thread...\n" );
+
+    std::vector<MeterJob> jobList;
+    std::vector<uint8_t> byteList;
+
+    while ( worker->running )
+    {
+        mutex_lock( worker->queueMutex );
+        worker->jobs.swap( jobList );
+        worker->bytes.swap( byteList );
+        mutex_unlock( worker->queueMutex );
+
+        long nowMS = getTimeMS();
+        if ( !jobList.empty() )
+        {
+            worker->process( jobList, byteList, nowMS );
+            jobList.clear();
+            byteList.clear();
+        }
+        worker->checkSilence( nowMS );
+
+        // packets come in every 20ms or so per stream, so polling at this
+        // rate keeps up without needing a condition variable
+        wxMilliSleep( 5 );
+    }
+
+    gravUtil::logVerbose( "MeterDecodeWorker::meter thread ending...\n" );
+    return 0;
+}
+
+void MeterDecodeWorker::process( std::vector<MeterJob>& jobList,
+                                 std::vector<uint8_t>& byteList, long nowMS )
+{
+    for ( unsigned int i = 0; i < jobList.size(); i++ )
+    {
+        MeterJob& job = jobList[i];
+        if ( job.type == MeterJob::RELEASE )
+        {
+            // any packets for it were before this in the list, so it's done
+            mutex_lock( queueMutex );
+            channels.erase( job.channel );
+            mutex_unlock( queueMutex );
+            delete job.channel;
+            continue;
+        }
+
+        float level = AudioCodecMeter::measure( job.channel->codec,
+                                                &byteList[ job.offset ],
+                                                job.length );
+        if ( level >= 0.0f )
+        {
+            job.channel->level = level;
+            job.channel->lastPacketMS = nowMS;
+        }
+    }
+}
+
+void MeterDecodeWorker::checkSilence( long nowMS )
+{
+    mutex_lock( queueMutex );
+    std::set<MeterChannel*>::iterator i;
+    for ( i = channels.begin(); i != channels.end(); ++i )
+    {
+        if ( nowMS - (*i)->lastPacketMS > silenceTimeoutMS )
+            (*i)->level = 0.0f;
+    }
+    mutex_unlock( queueMutex );
+}
+
+long MeterDecodeWorker::getTimeMS()
+{
+    struct timeval now;
+    gettimeofday( &now, NULL );
+    return now.tv_sec * 1000L + now.tv_usec / 1000L;
+}
@@ -27,17 +27,32 @@
 
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <png.h>
+#include <sys/mman.h>
 
 #include "GLUtil.h"
 #include "PNGLoader.h"
+#include "TextureCache.h"
 #include "gravUtil.h"
 
-GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
+GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height,
+                           bool mipmap )
 {
-    int size = 0;
-    glGetIntegerv( GL_MAX_TEXTURE_SIZE, &size );
-    gravUtil::logVerbose( "PNGLoader::loadPNG: max tex size is %i", size );
+    DecodedImage image;
+    if ( !TextureCache::load( filename, image ) )
+        return 0;
+
+    GLuint texID = uploadImage( image, mipmap );
+    width = image.width;
+    height = image.height;
+    freeImage( image );
+    return texID;
+}
+
+bool PNGLoader::decodePNG( std::string filename, DecodedImage& image )
+{
+    initImage( image );
 
     png_byte PNGheader[8];
 
@@ -45,17 +60,18 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
     FILE* texfile = fopen( filename.c_str(), "rb" );
     if ( !texfile )
     {
-        gravUtil::logError( "PNGLoader::loadPNG: error opening file %s\n",
+        gravUtil::logError( "PNGLoader::decodePNG: error opening file %s\n",
                 filename.c_str() );
-        return 0;
+        return false;
     }
 
     size_t retval = fread( PNGheader, 1, 8, texfile );
     if ( retval == 0 )
     {
-        gravUtil::logError( "PNGLoader::loadPNG: error reading file %s?\n",
+        gravUtil::logError( "PNGLoader::decodePNG: error reading file %s?\n",
                 filename.c_str() );
-        return 0;
+        fclose( texfile );
+        return false;
     }
 
     // check the header
@@ -63,7 +79,7 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
     if ( !pngTest )
     {
         fclose( texfile );
-        return 0;
+        return false;
     }
 
     // make the main png struct
@@ -72,7 +88,7 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
     if ( !png )
     {
         fclose( texfile );
-        return 0;
+        return false;
     }
 
     // make the info struct
@@ -81,7 +97,7 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
     {
         png_destroy_read_struct( &png, (png_infopp)NULL, (png_infopp)NULL );
         fclose( texfile );
-        return 0;
+        return false;
     }
 
     // make the end struct
@@ -90,15 +106,20 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
     {
         png_destroy_read_struct( &png, &pngInfo, (png_infopp)NULL );
         fclose( texfile );
-        return 0;
+        return false;
     }
 
+    // volatile since it changes after the setjmp
+    png_bytep* volatile rowPointers = NULL;
+
     // weird png error stuff...
     if ( setjmp( png_jmpbuf( png ) ) )
     {
         png_destroy_read_struct( &png, &pngInfo, &pngEnd );
         fclose ( texfile );
-        return 0;
+        delete[] rowPointers;
+        freeImage( image );
+        return false;
     }
 
     // initialize reading, set that we already read the header & read the
@@ -113,36 +134,86 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
 
     png_get_IHDR( png, pngInfo, &iwidth, &iheight, &bitDepth, &colorType,
                     NULL, NULL, NULL );
-    width = iwidth; height = iheight;
 
-    gravUtil::logVerbose( "PNGLoader::loadPNG: bitDepth: %i, colorType: %i, "
+    gravUtil::logVerbose( "PNGLoader::decodePNG: bitDepth: %i, colorType: %i, "
             "RGBA: %i\n", bitDepth, colorType, PNG_COLOR_TYPE_RGBA );
 
-    int pwidth = GLUtil::getInstance()->pow2( iwidth );
-    int pheight = GLUtil::getInstance()->pow2( iheight );
-    gravUtil::logVerbose( "PNGLoader::loadPNG: read in PNG: image dimensions: "
-            "%ux%u, pow2 dimensions: %ux%u\n",
+    // whatever the file is, get 8 bit RGBA out of it, since that's what the
+    // texture is going to be
+    if ( colorType == PNG_COLOR_TYPE_PALETTE )
+        png_set_palette_to_rgb( png );
+    if ( colorType == PNG_COLOR_TYPE_GRAY ||
+            colorType == PNG_COLOR_TYPE_GRAY_ALPHA )
+        png_set_gray_to_rgb( png );
+    if ( png_get_valid( png, pngInfo, PNG_INFO_tRNS ) )
+        png_set_tRNS_to_alpha( png );
+    else if ( !( colorType & PNG_COLOR_MASK_ALPHA ) )
+        png_set_filler( png, 0xFF, PNG_FILLER_AFTER );
+    if ( bitDepth == 16 )
+        png_set_strip_16( png );
+    else if ( bitDepth < 8 )
+        png_set_packing( png );
+
+    image.width = iwidth;
+    image.height = iheight;
+    image.texWidth = GLUtil::getInstance()->pow2( iwidth );
+    image.texHeight = GLUtil::getInstance()->pow2( iheight );
+    gravUtil::logVerbose( "PNGLoader::decodePNG: read in PNG: image "
+            "dimensions: %ux%u, pow2 dimensions: %ux%u\n",
             (unsigned int)iwidth, (unsigned int)iheight,
-            (unsigned int)pwidth, (unsigned int)pheight );
+            (unsigned int)image.texWidth, (unsigned int)image.texHeight );
 
     // update the info struct
     png_read_update_info( png, pngInfo );
-    int rowBytes = png_get_rowbytes( png, pngInfo );
+    unsigned int rowBytes = png_get_rowbytes( png, pngInfo );
+    unsigned int texRowBytes = image.texWidth * 4;
+    if ( rowBytes > texRowBytes )
+    {
+        gravUtil::logError( "PNGLoader::decodePNG: unexpected row size %u "
+                "in %s\n", rowBytes, filename.c_str() );
+        png_destroy_read_struct( &png, &pngInfo, &pngEnd );
+        fclose( texfile );
+        return false;
+    }
 
-    png_byte* image = new png_byte[ rowBytes * iheight ];
+    // decode straight into the pow2 sized buffer - the padding is grey, like
+    // it always has been
+    image.pixels = new unsigned char[ texRowBytes * image.texHeight ];
+    memset( image.pixels, 128, texRowBytes * image.texHeight );
 
-    // set the pointers for libpng to read the image row-by-row
-    png_bytep* rowPointers = new png_bytep[ iheight ];
+    // set the pointers for libpng to read the image row-by-row, flipped for
+    // GL
+    rowPointers = new png_bytep[ iheight ];
     for ( unsigned int i = 0; i < iheight; i++ )
-        rowPointers[iheight - 1 - i] = image + (i * rowBytes);
+        rowPointers[iheight - 1 - i] = image.pixels + ( i * texRowBytes );
 
     // read in the image
     png_read_image( png, rowPointers );
 
+    png_destroy_read_struct( &png, &pngInfo, &pngEnd );
+    delete[] rowPointers;
+    fclose( texfile );
+
+    return true;
+}
+
+GLuint PNGLoader::uploadImage( const DecodedImage& image, bool mipmap )
+{
+    if ( image.pixels == NULL )
+        return 0;
+
+    int maxSize = GLUtil::getInstance()->getMaxTextureSize();
+    if ( image.texWidth > maxSize || image.texHeight > maxSize )
+    {
+        gravUtil::logWarning( "PNGLoader::uploadImage: %ix%i is bigger than "
+                "the max texture size (%i)\n", image.texWidth,
+                image.texHeight, maxSize );
+    }
+
     GLenum  gl_error = glGetError();
     for ( ; (gl_error); gl_error = glGetError() )
     {
-        gravUtil::logError( "PNGLoader::loadPNG: GLError: %s\n",
+        gravUtil::logError( "PNGLoader::uploadImage: GLError: %s\n",
                 (const GLchar*)gluErrorString( gl_error ) );
     }
 
@@ -150,49 +221,45 @@ GLuint PNGLoader::loadPNG( std::string filename, int &width, int &height )
     glGenTextures( 1, &texID );
     glBindTexture( GL_TEXTURE_2D, texID );
 
-    // allocate a buffer for the pow2 size
-    unsigned char *buffer = new unsigned char[pwidth * pheight * 4];
-    gravUtil::logVerbose( "PNGLoader::loadPNG: made buffer, "
-            "allocating texture\n" );
-    memset( buffer, 128, pwidth * pheight * 4 );
-
-    gl_error = glGetError();
-    for ( ; (gl_error); gl_error = glGetError() )
-    {
-        gravUtil::logError( "PNGLoader::loadPNG: GLError: %s\n",
-                (const GLchar*)gluErrorString( gl_error ) );
-    }
+    // the whole chain gets regenerated whenever level 0 changes
+    if ( mipmap && GLEW_VERSION_1_4 )
+        glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE );
 
     glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
-    glPixelStorei( GL_UNPACK_ROW_LENGTH, pwidth );
-
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, pwidth, pheight, 0, GL_RGBA,
-                    GL_UNSIGNED_BYTE, (GLvoid*)buffer );
+    glPixelStorei( GL_UNPACK_ROW_LENGTH, image.texWidth );
 
-    glPixelStorei( GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei( GL_UNPACK_ROW_LENGTH, iwidth);
-
-    gravUtil::logVerbose( "PNGLoader::loadPNG: putting PNG in texture area\n" );
-
-    // put the actual image in a sub-area of the pow2 memory area
-    glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, iwidth, iheight, GL_RGBA,
-                    GL_UNSIGNED_BYTE, (GLvoid*)image );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, image.texWidth, image.texHeight,
+                    0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)image.pixels );
 
     gl_error = glGetError();
     for ( ; (gl_error); gl_error = glGetError() )
     {
-        gravUtil::logError("PNGLoader::loadPNG: GLError: %s\n",
+        gravUtil::logError("PNGLoader::uploadImage: GLError: %s\n",
                 (const GLchar*)gluErrorString( gl_error ) );
     }
 
-    gravUtil::logVerbose( "PNGLoader::loadPNG: PNGLoader::generated ID is %i\n",
+    gravUtil::logVerbose( "PNGLoader::uploadImage: generated ID is %i\n",
             texID );
 
-    png_destroy_read_struct( &png, &pngInfo, &pngEnd );
-    delete[] image;
-    delete[] rowPointers;
-    delete[] buffer;
-    fclose( texfile );
-
     return texID;
 }
+
+void PNGLoader::initImage( DecodedImage& image )
+{
+    image.width = 0;
+    image.height = 0;
+    image.texWidth = 0;
+    image.texHeight = 0;
+    image.pixels = NULL;
+    image.mapping = NULL;
+    image.mappingSize = 0;
+}
+
+void PNGLoader::freeImage( DecodedImage& image )
+{
+    if ( image.mapping != NULL )
+        munmap( image.mapping, image.mappingSize );
+    else
+        delete[] image.pixels;
+    initImage( image );
+}
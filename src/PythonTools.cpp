@@ -30,9 +30,62 @@
 #include <iostream>
 #include <cstdlib>
 
+#include <wx/utils.h>
+#include <wx/stopwatch.h>
+
 PythonTools* PythonTools::instance = NULL;
 bool PythonTools::disableInit = false;
 
+PythonRequest::PythonRequest( std::string s, std::string f,
+                              std::vector<std::string> a, ResultType t )
+    : script( s ), func( f ), args( a ), type( t )
+{
+    success = false;
+    refs = 2;
+    done = false;
+}
+
+bool PythonRequest::isDone()
+{
+    bool d = done;
+    // so the results are seen after done is
+    __sync_synchronize();
+    return d;
+}
+
+bool PythonRequest::wait( int timeoutMS )
+{
+    // this should be rare (ie, only at startup), so just poll
+    int waited = 0;
+    while ( !isDone() && ( timeoutMS < 0 || waited < timeoutMS ) )
+    {
+        wxMilliSleep( 5 );
+        waited += 5;
+    }
+    return isDone();
+}
+
+bool PythonRequest::succeeded()
+{
+    return success;
+}
+
+std::string PythonRequest::getString()
+{
+    return stringResult;
+}
+
+std::map<std::string, std::string> PythonRequest::getMap()
+{
+    return mapResult;
+}
+
+void PythonRequest::release()
+{
+    if ( __sync_sub_and_fetch( &refs, 1 ) == 0 )
+        delete this;
+}
+
 PythonTools* PythonTools::getInstance()
 {
     if ( instance == NULL )
@@ -56,17 +109,157 @@ PythonTools::PythonTools()
     init = false;
     main_m = NULL;
     main_d = NULL;
-    if ( !disableInit )
+    queueMutex = mutex_create();
+    running = true;
+    interpThread = NULL;
+    // the interpreter isn't started until something actually gets called,
+    // see callAsync
+}
+
+PythonTools::~PythonTools()
+{
+    // the interpreter thread finishes the call it's on, then shuts python
+    // down itself
+    running = false;
+    if ( interpThread != NULL )
+        thread_join( interpThread );
+
+    // anything left never ran
+    for ( unsigned int i = 0; i < queue.size(); i++ )
+    {
+        queue[i]->done = true;
+        queue[i]->release();
+    }
+    mutex_free( queueMutex );
+}
+
+PythonRequest* PythonTools::callAsync( std::string script, std::string func,
+        std::vector<std::string> args, PythonRequest::ResultType type )
+{
+    PythonRequest* req = new PythonRequest( script, func, args, type );
+
+    // python (& the scripts it imports) takes a while to start, and most
+    // runs never use it, so only start it the first time it's needed
+    if ( interpThread == NULL && !disableInit )
+    {
+        gravUtil::logVerbose( "PythonTools::callAsync: starting interpreter "
+                "for %s\n", func.c_str() );
+        interpThread = thread_start( threadMain, this );
+    }
+
+    if ( interpThread == NULL )
+    {
+        gravUtil::logError( "PythonTools::callAsync: PyTools not "
+                            "initialized\n" );
+        req->done = true;
+        req->release();
+        return req;
+    }
+
+    mutex_lock( queueMutex );
+    queue.push_back( req );
+    mutex_unlock( queueMutex );
+    return req;
+}
+
+PythonRequest* PythonTools::callAsync( std::string script, std::string func,
+        std::string arg, PythonRequest::ResultType type )
+{
+    return callAsync( script, func, std::vector<std::string>( 1, arg ), type );
+}
+
+PythonRequest* PythonTools::callAsync( std::string script, std::string func,
+        PythonRequest::ResultType type )
+{
+    return callAsync( script, func, std::vector<std::string>(), type );
+}
+
+void* PythonTools::threadMain( void* args )
+{
+    PythonTools* tools = (PythonTools*)args;
+
+    // python has to be started on the same thread it's used on
+    wxStopWatch startTime;
+    tools->init = tools->initialize();
+    long initTime = startTime.Time();
+    bool firstCall = true;
+
+    while ( tools->running )
+    {
+        mutex_lock( tools->queueMutex );
+        if ( tools->queue.empty() )
+        {
+            mutex_unlock( tools->queueMutex );
+            wxMilliSleep( 10 );
+            continue;
+        }
+        PythonRequest* req = tools->queue.front();
+        tools->queue.erase( tools->queue.begin() );
+        mutex_unlock( tools->queueMutex );
+
+        // req might be gone after it's run
+        std::string func = req->func;
+        tools->runRequest( req );
+
+        if ( firstCall )
+        {
+            gravUtil::logVerbose( "PythonTools::startup: first call (%s) "
+                    "done %ld ms after starting (%ld ms of that in the "
+                    "call)\n", func.c_str(), startTime.Time(),
+                    startTime.Time() - initTime );
+            firstCall = false;
+        }
+    }
+
+    Py_Finalize();
+    return NULL;
+}
+
+void PythonTools::runRequest( PythonRequest* req )
+{
+    PyObject* args = NULL;
+    bool tuple = false;
+    if ( req->args.size() == 1 )
     {
-        init = initialize();
+        // gets stolen by call
+        args = PyString_FromString( req->args[0].c_str() );
     }
+    else if ( req->args.size() > 1 )
+    {
+        args = PyTuple_New( req->args.size() );
+        for ( unsigned int i = 0; i < req->args.size(); i++ )
+            PyTuple_SetItem( args, i,
+                             PyString_FromString( req->args[i].c_str() ) );
+        tuple = true;
+    }
+
+    PyObject* res = call( req->script, req->func, args );
+    if ( tuple )
+        Py_DECREF( args );
+
+    req->success = res != NULL;
+    if ( res != NULL && res != Py_None )
+    {
+        if ( req->type == PythonRequest::STRING_RESULT &&
+                PyString_Check( res ) )
+            req->stringResult = PyString_AsString( res );
+        else if ( req->type == PythonRequest::MAP_RESULT )
+            req->mapResult = dtom( res );
+    }
+    Py_XDECREF( res );
+
+    __sync_synchronize();
+    req->done = true;
+    req->release();
 }
 
 bool PythonTools::initialize()
 {
+    wxStopWatch phaseTime;
     Py_Initialize();
     main_m = PyImport_AddModule( "__main__" );
     main_d = PyModule_GetDict( main_m );
+    long pyInitTime = phaseTime.Time();
 
     gravUtil* util = gravUtil::getInstance();
     entryModule = util->findFile( "gravEntry.py" );
@@ -79,10 +272,14 @@ bool PythonTools::initialize()
         bool open = file_1 != NULL;
         if ( open )
         {
+            phaseTime.Start();
             PyRun_File( file_1, entryModule.c_str(), Py_file_input, main_d,
                             main_d );
             fclose( file_1 );
             ret = true;
+            gravUtil::logVerbose( "PythonTools::startup: Py_Initialize took "
+                    "%ld ms, running %s took %ld ms\n", pyInitTime,
+                    entryModule.c_str(), phaseTime.Time() );
         }
         else
         {
@@ -99,11 +296,6 @@ bool PythonTools::initialize()
     return ret;
 }
 
-PythonTools::~PythonTools()
-{
-    Py_Finalize();
-}
-
 PyObject* PythonTools::mtod( std::map<std::string, std::string> m )
 {
     PyObject* dict = PyDict_New();
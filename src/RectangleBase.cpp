@@ -28,11 +28,15 @@
 #include "PNGLoader.h"
 #include "GLUtil.h"
 #include "Point.h"
+#include "Earth.h"
 
 #include "gravUtil.h"
+#include "Frustum.h"
 
 #include <cmath>
 
+Frustum* RectangleBase::cullFrustum = NULL;
+
 RectangleBase::RectangleBase()
 {
     setDefaults();
@@ -57,6 +61,7 @@ RectangleBase::RectangleBase( const RectangleBase& other )
     effectVal = other.effectVal;
 
     lat = other.lat; lon = other.lon;
+    unitX = other.unitX; unitY = other.unitY; unitZ = other.unitZ;
 
     borderColor = other.borderColor;
     destBColor = other.destBColor;
@@ -70,6 +75,8 @@ RectangleBase::RectangleBase( const RectangleBase& other )
     shown = other.shown;
 
     debugDraw = other.debugDraw;
+    culled = other.culled;
+    occluded = other.occluded;
 
     name = other.name;
     siteID = other.siteID;
@@ -78,6 +85,7 @@ RectangleBase::RectangleBase( const RectangleBase& other )
     cutoffPos = other.cutoffPos;
 
     font = other.font;
+    textBounds = other.textBounds;
     relativeTextScale = other.relativeTextScale;
     borderScale = other.borderScale;
     titleStyle = other.titleStyle;
@@ -134,6 +142,8 @@ void RectangleBase::setDefaults()
     shown = true;
 
     debugDraw = false;
+    culled = false;
+    occluded = false;
 
     relativeTextScale = 0.0009;
     titleStyle = TOPTEXT;
@@ -168,7 +178,7 @@ void RectangleBase::setDefaults()
     secondColAnimating = false;
 
     // TODO: this should be dynamic
-    lat = 43.165556f; lon = -77.611389f;
+    setLocation( 43.165556f, -77.611389f );
 
     font = GLUtil::getInstance()->getMainFont();
 
@@ -596,6 +606,20 @@ float RectangleBase::getLon()
     return lon;
 }
 
+void RectangleBase::setLocation( float newLat, float newLon )
+{
+    lat = newLat;
+    lon = newLon;
+    Earth::latLongToUnit( lat, lon, unitX, unitY, unitZ );
+}
+
+void RectangleBase::getEarthUnitPos( float& ux, float& uy, float& uz )
+{
+    ux = unitX;
+    uy = unitY;
+    uz = unitZ;
+}
+
 float RectangleBase::getOriginalAspect()
 {
     return 1.0;
@@ -921,9 +945,16 @@ void RectangleBase::draw()
 
     animateValues();
 
+    culled = false;
     if ( borderColor.A < 0.01f )
         return;
 
+    // still animated above, so it'll be in the right place once it's back in
+    // view
+    culled = occluded || isOutsideFrustum();
+    if ( culled )
+        return;
+
     // set up our position
     glPushMatrix();
 
@@ -1108,6 +1139,47 @@ void RectangleBase::draw()
     xAngle += 0.01f;*/
 }
 
+void RectangleBase::setCullFrustum( Frustum* f )
+{
+    cullFrustum = f;
+}
+
+void RectangleBase::setOccluded( bool o )
+{
+    occluded = o;
+}
+
+bool RectangleBase::isOccluded()
+{
+    return occluded;
+}
+
+bool RectangleBase::isMoving()
+{
+    return positionAnimating || scaleAnimating;
+}
+
+void RectangleBase::getDrawExtent( float& halfWidth, float& halfHeight )
+{
+    halfWidth = std::max( ( getWidth() / 2.0f ) + getBorderSize(),
+                          getTextWidth() );
+    halfHeight = ( getHeight() / 2.0f ) + getBorderSize() + getTextOffset() +
+                    getTextHeight();
+}
+
+bool RectangleBase::isOutsideFrustum()
+{
+    if ( cullFrustum == NULL )
+        return false;
+
+    // (angles aren't an issue since this is a sphere)
+    float halfWidth, halfHeight;
+    getDrawExtent( halfWidth, halfHeight );
+    float radius = sqrt( ( halfWidth * halfWidth ) +
+                         ( halfHeight * halfHeight ) );
+    return !cullFrustum->sphereVisible( x, y, z, radius );
+}
+
 void RectangleBase::drawBorder( float Xdist, float Ydist, float s, float t )
 {
     glEnable( GL_BLEND );
@@ -0,0 +1,207 @@
+/*
+ * @file RenderThread.cpp
+ *
+ * Implementation of the dedicated render thread.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RenderThread.h"
+#include "GLCanvas.h"
+#include "gravManager.h"
+#include "InputHandler.h"
+#include "gravUtil.h"
+
+BEGIN_EVENT_TABLE(RenderThread, wxEvtHandler)
+EVT_KEY_DOWN(RenderThread::queueKeyEvent)
+EVT_MOTION(RenderThread::queueMouseEvent)
+EVT_LEFT_DOWN(RenderThread::queueMouseEvent)
+EVT_LEFT_DCLICK(RenderThread::queueMouseEvent)
+EVT_LEFT_UP(RenderThread::queueMouseEvent)
+EVT_RIGHT_DOWN(RenderThread::queueMouseEvent)
+END_EVENT_TABLE()
+
+RenderThread::RenderThread( GLCanvas* c, gravManager* g, InputHandler* i )
+    : canvas( c ), grav( g ), input( i )
+{
+    resizePending = false;
+    resizeWidth = 0;
+    resizeHeight = 0;
+    messageMutex = mutex_create();
+
+    renderThread = NULL;
+    running = false;
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+
+    for ( unsigned int i = 0; i < pendingInput.size(); i++ )
+        delete pendingInput[i];
+    mutex_free( messageMutex );
+}
+
+bool RenderThread::start()
+{
+    if ( running )
+        return true;
+
+#if defined(__WXGTK__)
+    grav->setRenderThreaded( true );
+
+    // input gets handled on the render thread from here on - the
+    // InputHandler was on the canvas' chain, so this takes its place
+    canvas->RemoveEventHandler( input );
+    canvas->PushEventHandler( this );
+    canvas->setRenderThread( this );
+
+    canvas->releaseContext();
+    running = true;
+    renderThread = thread_start( threadMain, this );
+    return true;
+#else
+    gravUtil::logWarning( "RenderThread::start: not supported on this "
+                          "platform, drawing on the main thread\n" );
+    return false;
+#endif
+}
+
+void RenderThread::stop()
+{
+    if ( !running )
+        return;
+
+    running = false;
+    thread_join( renderThread );
+    renderThread = NULL;
+
+    // anything after this (ie, deleting sources on exit) is back on the main
+    // thread, and needs the context there
+    canvas->setRenderThread( NULL );
+    canvas->makeCurrent();
+    grav->setRenderThreaded( false );
+}
+
+void RenderThread::postResize( int w, int h )
+{
+    mutex_lock( messageMutex );
+    resizePending = true;
+    resizeWidth = w;
+    resizeHeight = h;
+    mutex_unlock( messageMutex );
+}
+
+void* RenderThread::threadMain( void* args )
+{
+    RenderThread* r = (RenderThread*)args;
+    r->run();
+    return 0;
+}
+
+void RenderThread::run()
+{
+    gravUtil::logVerbose( "RenderThread::starting render thread...\n" );
+    grav->claimRenderThread();
+    canvas->makeCurrent();
+
+    FrameScheduler* scheduler = canvas->getScheduler();
+    while ( running )
+    {
+        if ( !scheduler->isFrameDue() )
+        {
+            scheduler->waitForFrame( 4000 );
+            continue;
+        }
+
+        grav->beginFrame();
+        processMessages();
+        canvas->draw();
+        grav->endFrame();
+    }
+
+    // so the main thread can have it back - see stop()
+    canvas->releaseContext();
+    gravUtil::logVerbose( "RenderThread::render thread ending...\n" );
+}
+
+void RenderThread::queueKeyEvent( wxKeyEvent& evt )
+{
+    queueEvent( evt );
+    // same as InputHandler, so the char event still gets generated
+    evt.Skip();
+}
+
+void RenderThread::queueMouseEvent( wxMouseEvent& evt )
+{
+    queueEvent( evt );
+    // InputHandler lets the left button events through to the canvas as well
+    if ( evt.LeftDown() || evt.LeftUp() || evt.LeftDClick() )
+        evt.Skip();
+}
+
+void RenderThread::queueEvent( wxEvent& evt )
+{
+    wxEvent* copy = evt.Clone();
+    mutex_lock( messageMutex );
+    pendingInput.push_back( copy );
+    mutex_unlock( messageMutex );
+}
+
+void RenderThread::processMessages()
+{
+    std::vector<wxEvent*> events;
+    mutex_lock( messageMutex );
+    events.swap( pendingInput );
+    bool resize = resizePending;
+    int w = resizeWidth;
+    int h = resizeHeight;
+    resizePending = false;
+    mutex_unlock( messageMutex );
+
+    // resize first, since the mouse positions are relative to the window as
+    // it is now
+    if ( resize )
+        canvas->GLreshape( w, h );
+
+    for ( unsigned int i = 0; i < events.size(); i++ )
+    {
+        dispatch( events[i] );
+        delete events[i];
+    }
+}
+
+void RenderThread::dispatch( wxEvent* evt )
+{
+    // called directly rather than through ProcessEvent, which would pass
+    // skipped events on to the app object from this thread
+    wxEventType type = evt->GetEventType();
+    if ( type == wxEVT_KEY_DOWN )
+        input->wxKeyDown( *(wxKeyEvent*)evt );
+    else if ( type == wxEVT_MOTION )
+        input->wxMouseMove( *(wxMouseEvent*)evt );
+    else if ( type == wxEVT_LEFT_DOWN )
+        input->wxMouseLDown( *(wxMouseEvent*)evt );
+    else if ( type == wxEVT_LEFT_DCLICK )
+        input->wxMouseLDClick( *(wxMouseEvent*)evt );
+    else if ( type == wxEVT_LEFT_UP )
+        input->wxMouseLUp( *(wxMouseEvent*)evt );
+    else if ( type == wxEVT_RIGHT_DOWN )
+        input->wxMouseRDown( *(wxMouseEvent*)evt );
+}
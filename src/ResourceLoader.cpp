@@ -0,0 +1,107 @@
+/*
+ * @file ResourceLoader.cpp
+ *
+ * Implementation of the background texture loader.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResourceLoader.h"
+#include "TextureCache.h"
+#include "gravUtil.h"
+
+ResourceLoader::LoadJob::LoadJob()
+{
+    mipmap = false;
+    loaded = false;
+    PNGLoader::initImage( image );
+}
+
+ResourceLoader::LoadJob::~LoadJob()
+{
+    PNGLoader::freeImage( image );
+}
+
+void ResourceLoader::LoadJob::run()
+{
+    loaded = TextureCache::load( fileName, image );
+}
+
+ResourceLoader::ResourceLoader()
+{
+    workers = new WorkerPool( maxThreads );
+}
+
+ResourceLoader::~ResourceLoader()
+{
+    // workers finish the file they're on, then exit
+    delete workers;
+}
+
+void ResourceLoader::requestTexture( std::string name, std::string fileName,
+                                     bool mipmap )
+{
+    LoadJob* job = new LoadJob;
+    job->name = name;
+    job->fileName = fileName;
+    job->mipmap = mipmap;
+    workers->push( job );
+}
+
+int ResourceLoader::uploadFinished( std::map<std::string, Texture>& textures,
+                                    std::set<std::string>& failed )
+{
+    std::vector<WorkerJob*> done;
+    workers->takeFinished( done );
+
+    int added = 0;
+    for ( unsigned int i = 0; i < done.size(); i++ )
+    {
+        LoadJob* job = static_cast<LoadJob*>( done[i] );
+        Texture t;
+        t.ID = 0;
+        if ( job->loaded )
+            t.ID = PNGLoader::uploadImage( job->image, job->mipmap );
+
+        if ( t.ID != 0 )
+        {
+            t.width = job->image.width;
+            t.height = job->image.height;
+            textures[ job->name ] = t;
+            failed.erase( job->name );
+            added++;
+        }
+        else
+        {
+            gravUtil::logWarning( "ResourceLoader::uploadFinished: texture "
+                                  "%s failed to load\n",
+                                  job->fileName.c_str() );
+            failed.insert( job->name );
+        }
+
+        delete job;
+    }
+
+    return added;
+}
+
+int ResourceLoader::getPendingCount()
+{
+    return workers->getPendingCount();
+}
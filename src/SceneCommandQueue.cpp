@@ -0,0 +1,68 @@
+/*
+ * @file SceneCommandQueue.cpp
+ *
+ * Implementation of the network -> main thread command queue.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SceneCommandQueue.h"
+
+#include <cstddef>
+
+SceneCommand::SceneCommand( Type t ) :
+    type( t ), source( NULL ), session( NULL ), ssrc( 0 ), next( NULL )
+{ }
+
+SceneCommandQueue::SceneCommandQueue() :
+    head( NULL )
+{ }
+
+void SceneCommandQueue::push( SceneCommand* cmd )
+{
+    // standard lock-free stack push. there's no ABA problem here since the
+    // consumer never pops single entries, it only swaps out the whole list
+    SceneCommand* oldHead;
+    do
+    {
+        oldHead = head;
+        cmd->next = oldHead;
+    } while ( !__sync_bool_compare_and_swap( &head, oldHead, cmd ) );
+}
+
+SceneCommand* SceneCommandQueue::takeAll()
+{
+    if ( head == NULL )
+        return NULL;
+
+    // __sync_lock_test_and_set is only an acquire barrier, which is what we
+    // want here - we need to see everything written before the pushes
+    SceneCommand* list = __sync_lock_test_and_set( &head, (SceneCommand*)NULL );
+
+    // reverse so the oldest command comes first
+    SceneCommand* ordered = NULL;
+    while ( list != NULL )
+    {
+        SceneCommand* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    return ordered;
+}
@@ -42,6 +42,7 @@ SessionEntry::SessionEntry( std::string addr, bool aud )
 
     processingEnabled = true;
     initialized = false;
+    connecting = false;
     inFailedState = false;
 
     encryptionKey = "__NO_KEY__";
@@ -63,6 +64,11 @@ SessionEntry::SessionEntry( std::string addr, bool aud )
     failedColor.B = 0.15f;
     failedColor.A = 0.55f;
 
+    connectingColor.R = 1.0f;
+    connectingColor.G = 0.8f;
+    connectingColor.B = 0.15f;
+    connectingColor.A = 0.55f;
+
     baseBColor = disabledColor;
     borderColor = disabledColor;
     borderColor.A = 0.0f;
@@ -85,37 +91,7 @@ bool SessionEntry::initSession( VPMSessionListener* listener )
 {
     if ( !isSessionEnabled() )
     {
-        VPMSessionFactory* factory = VPMSessionFactory::getInstance();
-        session = factory->createSession( address.c_str(), *listener );
-
-        session->enableVideo( !audio );
-        session->enableAudio( audio );
-        session->enableOther( false );
-
-        if ( !session->initialise() )
-        {
-            gravUtil::logError( "SessionEntry::init: failed to initialize on "
-                                "address %s\n", address.c_str() );
-            initialized = false;
-            // might as well delete the session object here to prevent potential
-            // memleaks (ie, reinitializing a session that failed to init)
-            disableSession();
-            setBaseColor( failedColor );
-            inFailedState = true;
-            return false;
-        }
-
-        if ( encryptionKey.compare( "__NO_KEY__" ) != 0 )
-        {
-            session->setEncryptionKey( encryptionKey.c_str() );
-        }
-
-        sessionTS = random32();
-
-        initialized = true;
-        inFailedState = false;
-        resetColor();
-        return true;
+        return finishInit( createSession( address, audio, listener ) );
     }
     else
     {
@@ -125,6 +101,72 @@ bool SessionEntry::initSession( VPMSessionListener* listener )
     }
 }
 
+void SessionEntry::startConnecting()
+{
+    connecting = true;
+    inFailedState = false;
+    setBaseColor( connectingColor );
+}
+
+VPMSession* SessionEntry::createSession( std::string address, bool audio,
+                                         VPMSessionListener* listener )
+{
+    VPMSessionFactory* factory = VPMSessionFactory::getInstance();
+    VPMSession* s = factory->createSession( address.c_str(), *listener );
+
+    s->enableVideo( !audio );
+    s->enableAudio( audio );
+    s->enableOther( false );
+
+    if ( !s->initialise() )
+    {
+        gravUtil::logError( "SessionEntry::init: failed to initialize on "
+                            "address %s\n", address.c_str() );
+        // might as well delete the session object here to prevent potential
+        // memleaks (ie, reinitializing a session that failed to init)
+        delete s;
+        return NULL;
+    }
+
+    return s;
+}
+
+bool SessionEntry::finishInit( VPMSession* s )
+{
+    connecting = false;
+
+    if ( s == NULL )
+    {
+        initialized = false;
+        disableSession();
+        setBaseColor( failedColor );
+        inFailedState = true;
+        return false;
+    }
+
+    // shouldn't happen, but don't leak the old one if it does
+    if ( session != NULL )
+        disableSession();
+    session = s;
+
+    if ( encryptionKey.compare( "__NO_KEY__" ) != 0 )
+    {
+        session->setEncryptionKey( encryptionKey.c_str() );
+    }
+
+    sessionTS = random32();
+
+    initialized = true;
+    inFailedState = false;
+    resetColor();
+    return true;
+}
+
+bool SessionEntry::isConnecting()
+{
+    return connecting;
+}
+
 void SessionEntry::disableSession()
 {
     // even if it failed to initialize, we still need to delete the session
@@ -143,6 +185,7 @@ void SessionEntry::disableSession()
     }
 
     initialized = false;
+    connecting = false;
     setBaseColor( disabledColor );
     inFailedState = false;
     // was originally going to call this var "lastInitFailed" but that name
@@ -210,6 +253,11 @@ uint32_t SessionEntry::getTimestamp()
     return sessionTS;
 }
 
+VPMSession* SessionEntry::getSession()
+{
+    return isSessionEnabled() ? session : NULL;
+}
+
 bool SessionEntry::iterate()
 {
     bool running = isSessionEnabled() && processingEnabled;
@@ -0,0 +1,135 @@
+/*
+ * @file SessionInitializer.cpp
+ *
+ * Implementation of the background session starter.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <VPMedia/VPMSession.h>
+#include <VPMedia/VPMSessionFactory.h>
+
+#include <algorithm>
+
+#include "SessionInitializer.h"
+#include "SessionEntry.h"
+#include "gravUtil.h"
+
+SessionInitializer::InitJob::InitJob()
+{
+    entry = NULL;
+    audio = false;
+    listener = NULL;
+    session = NULL;
+}
+
+SessionInitializer::InitJob::~InitJob()
+{
+    delete session;
+}
+
+void SessionInitializer::InitJob::run()
+{
+    session = SessionEntry::createSession( address, audio, listener );
+}
+
+SessionInitializer::SessionInitializer()
+{
+    workers = new WorkerPool( maxThreads );
+
+    // make sure the factory's set up here, rather than racing to create it
+    // on the workers
+    VPMSessionFactory::getInstance();
+}
+
+SessionInitializer::~SessionInitializer()
+{
+    // workers finish the session they're on, then exit - whatever they
+    // started gets deleted along with the jobs
+    delete workers;
+}
+
+void SessionInitializer::request( SessionEntry* entry,
+                                  VPMSessionListener* listener )
+{
+    InitJob* job = new InitJob;
+    job->entry = entry;
+    job->address = entry->getAddress();
+    job->audio = entry->isAudioSession();
+    job->listener = listener;
+
+    outstanding.push_back( job );
+    workers->push( job );
+}
+
+void SessionInitializer::cancel( SessionEntry* entry )
+{
+    std::vector<InitJob*>::iterator it = outstanding.begin();
+    while ( it != outstanding.end() )
+    {
+        if ( (*it)->entry != entry )
+        {
+            ++it;
+            continue;
+        }
+
+        // not started yet - just drop it. otherwise it has to finish first
+        if ( workers->remove( *it ) )
+        {
+            delete *it;
+            it = outstanding.erase( it );
+        }
+        else
+        {
+            (*it)->entry = NULL;
+            ++it;
+        }
+    }
+}
+
+void SessionInitializer::finish( std::vector<SessionEntry*>& done )
+{
+    std::vector<WorkerJob*> jobs;
+    workers->takeFinished( jobs );
+
+    for ( unsigned int i = 0; i < jobs.size(); i++ )
+    {
+        InitJob* job = static_cast<InitJob*>( jobs[i] );
+        outstanding.erase( std::find( outstanding.begin(), outstanding.end(),
+                                      job ) );
+
+        if ( job->entry != NULL )
+        {
+            job->entry->finishInit( job->session );
+            job->session = NULL;
+            done.push_back( job->entry );
+        }
+        else
+        {
+            gravUtil::logVerbose( "SessionInitializer::finish: %s was "
+                    "cancelled while starting\n", job->address.c_str() );
+        }
+        delete job;
+    }
+}
+
+bool SessionInitializer::hasFinished()
+{
+    return workers->hasFinished();
+}
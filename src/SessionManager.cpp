@@ -28,9 +28,11 @@
 #include <wx/utils.h>
 
 #include <stdio.h>
+#include <sys/time.h>
 
 #include "SessionManager.h"
 #include "SessionEntry.h"
+#include "SessionInitializer.h"
 #include "SessionGroup.h"
 #include "SessionGroupButton.h"
 #include "VideoListener.h"
@@ -39,6 +41,7 @@
 #include "gravUtil.h"
 #include "SessionTreeControl.h"
 #include "gravManager.h"
+#include "Timers.h"
 
 SessionManager::SessionManager( VideoListener* vl, AudioManager* al,
                                 gravManager* g )
@@ -49,6 +52,7 @@ SessionManager::SessionManager( VideoListener* vl, AudioManager* al,
     y = destY - 10.0f; // for move-from-bottom animation
 
     sessionMutex = mutex_create();
+    initializer = new SessionInitializer();
 
     videoSessionCount = 0;
     audioSessionCount = 0;
@@ -58,6 +62,22 @@ SessionManager::SessionManager( VideoListener* vl, AudioManager* al,
     rotatePos = -1;
     lastRotateSession = NULL;
 
+    sessionTree = NULL;
+    rotateToPending = false;
+    rotateTogglePending = false;
+
+    rotateState = ROTATE_IDLE;
+    warmingSession = NULL;
+    prewarmTried = false;
+    switchFrom = NULL;
+    switchTo = NULL;
+    switchWarmed = false;
+    switchStartMS = 0;
+    fadeStartMS = 0;
+    firstVideoMS = 0;
+    switchCount = 0;
+    totalSwitchMS = 0;
+
     preserveChildAspect = false;
 
     locked = false;
@@ -132,6 +152,8 @@ SessionManager::SessionManager( VideoListener* vl, AudioManager* al,
 
 SessionManager::~SessionManager()
 {
+    // waits for any sessions still starting
+    delete initializer;
     mutex_free( sessionMutex );
 
     Group* sessions;
@@ -218,15 +240,16 @@ bool SessionManager::addSession( std::string address, SessionType type )
     Texture t = GLUtil::getInstance()->getTexture( "circle" );
     entry->setTexture( t.ID, t.width, t.height );
 
+    // started in the background - failures turn up later, through
+    // finishSessionInits
     if ( type != AVAILABLEVIDEOSESSION )
     {
-        ret = ret && initSession( entry );
+        ret = ret && initSessionAsync( entry );
     }
 
     /*
      * Note - used to delete entries on fail. Now will display an entry in a
      * failed state, so it can potentially be reenabled when it could work.
-     * (But still returns false on failed init)
      */
 
     sessions->add( entry );
@@ -263,6 +286,9 @@ bool SessionManager::removeSession( std::string addr, SessionType type )
             rotatePos--;
     }
 
+    forgetRotateSession( entry );
+    initializer->cancel( entry );
+
     objectManager->lockSources();
     objectManager->removeFromLists( entry, false );
     objectManager->unlockSources();
@@ -352,18 +378,30 @@ bool SessionManager::rotateTo( std::string addr, bool audio )
         return false;
     }
 
+    prewarmTried = false;
+
     // only rotate if there is a valid old one & it isn't the same as
     // current
     if ( lastRotateSession != NULL && current != NULL &&
             lastRotateSession != current )
     {
-        disableSession( lastRotateSession );
-        initSession( current );
+        startSwitch( lastRotateSession, current );
     }
-    // case for first rotate
+    // case for first rotate - nothing to keep up in the meantime, so just
+    // show it
     else if ( lastRotatePos == -1 )
     {
-        initSession( current );
+        if ( warmingSession == current && current->isSessionEnabled() )
+            objectManager->revealSession( current->getSession(), NULL );
+        // if it's still connecting, it just won't get hidden when it's done,
+        // since it isn't the warming session anymore
+        else if ( warmingSession != current || !current->isConnecting() )
+        {
+            if ( warmingSession != NULL )
+                stopSession( warmingSession );
+            initSessionAsync( current );
+        }
+        warmingSession = NULL;
     }
 
     unlockSessions();
@@ -383,6 +421,18 @@ void SessionManager::unrotate( bool audio )
     rotatePos = -1;
     lastRotateSession = NULL;
 
+    // drop anything mid-switch or started ahead of time as well
+    if ( warmingSession != NULL )
+        stopSession( warmingSession );
+    if ( switchFrom != NULL )
+        stopSession( switchFrom );
+    if ( switchTo != NULL )
+        stopSession( switchTo );
+    warmingSession = NULL;
+    switchFrom = NULL;
+    switchTo = NULL;
+    rotateState = ROTATE_IDLE;
+
     if ( current != NULL )
     {
         disableSession( current );
@@ -391,10 +441,113 @@ void SessionManager::unrotate( bool audio )
     unlockSessions();
 }
 
+void SessionManager::finishSessionInits()
+{
+    if ( !initializer->hasFinished() )
+        return;
+
+    std::vector<SessionEntry*> done;
+    lockSessions();
+    initializer->finish( done );
+
+    // sessions started ahead of a rotate have to be hidden before the network
+    // thread gets to them (ie, before the lock's let go), or their videos
+    // would pop up before the switch
+    for ( unsigned int i = 0; i < done.size(); i++ )
+    {
+        if ( done[i]->isSessionEnabled() && ( done[i] == warmingSession ||
+                ( rotateState == ROTATE_WAITING && done[i] == switchTo ) ) )
+            objectManager->setSessionStandby( done[i]->getSession(), true );
+    }
+    unlockSessions();
+
+    // entries only get deleted on this thread, so these are still valid
+    for ( unsigned int i = 0; i < done.size(); i++ )
+    {
+        bool ok = done[i]->isSessionEnabled();
+        if ( ok )
+            gravUtil::logVerbose( "SessionManager::initialized %s session on "
+                    "%s\n", done[i]->isAudioSession() ? "audio" : "video",
+                    done[i]->getAddress().c_str() );
+        else
+            gravUtil::logError( "SessionManager::finishSessionInits: "
+                    "failed to initialize session on %s\n",
+                    done[i]->getAddress().c_str() );
+
+        if ( sessionTree != NULL )
+            sessionTree->sessionInitFinished( done[i]->getAddress(), ok );
+    }
+}
+
+void SessionManager::updateRotation()
+{
+    if ( rotateState == ROTATE_IDLE )
+    {
+        prewarmNext();
+        return;
+    }
+
+    long now = getTimeMS();
+
+    if ( rotateState == ROTATE_WAITING )
+    {
+        VPMSession* to = switchTo->getSession();
+        // (standby sources change as the drawing thread adds them)
+        objectManager->lockScene();
+        bool ready = to != NULL && objectManager->sessionHasVideo( to );
+        objectManager->unlockScene();
+        // still connecting counts as waiting for video - if it failed to
+        // start, there's nothing to wait for
+        bool waiting = to != NULL || switchTo->isConnecting();
+        if ( !ready && waiting && now - switchStartMS < switchTimeoutMS )
+            return;
+
+        if ( !ready )
+            gravUtil::logWarning( "SessionManager::updateRotation: no video "
+                    "from %s after %ld ms, switching anyway\n",
+                    switchTo->getAddress().c_str(), now - switchStartMS );
+
+        lockSessions();
+        if ( to != NULL )
+            objectManager->revealSession( to, switchFrom->getSession() );
+        unlockSessions();
+
+        firstVideoMS = now - switchStartMS;
+        fadeStartMS = now;
+        rotateState = ROTATE_FADING;
+    }
+    else if ( rotateState == ROTATE_FADING )
+    {
+        if ( now - fadeStartMS < crossfadeMS )
+            return;
+
+        lockSessions();
+        stopSession( switchFrom );
+        unlockSessions();
+
+        long total = now - switchStartMS;
+        switchCount++;
+        totalSwitchMS += total;
+        gravUtil::logVerbose( "SessionManager::updateRotation: switched %s -> "
+                "%s (%s): first video after %ld ms, done after %ld ms "
+                "(average %ld ms over %d switches)\n",
+                switchFrom->getAddress().c_str(),
+                switchTo->getAddress().c_str(),
+                switchWarmed ? "pre-started" : "cold", firstVideoMS, total,
+                totalSwitchMS / switchCount, switchCount );
+
+        switchFrom = NULL;
+        switchTo = NULL;
+        rotateState = ROTATE_IDLE;
+    }
+}
+
 void SessionManager::setAutoRotate( bool a )
 {
+    objectManager->lockScene();
     availableVideoSessions->setRotating( a );
     avButton->setPlaying( a );
+    objectManager->unlockScene();
 }
 
 void SessionManager::sessionEntryAction( SessionEntry* entry )
@@ -411,7 +564,13 @@ void SessionManager::sessionEntryAction( SessionEntry* entry )
     }
     else if ( group == availableVideoSessions )
     {
-        sessionTree->rotateToVideoSession( entry->getAddress() );
+        if ( wxIsMainThread() )
+            sessionTree->rotateToVideoSession( entry->getAddress() );
+        else
+        {
+            pendingRotateTo = entry->getAddress();
+            rotateToPending = true;
+        }
     }
     else if ( group == audioSessions )
     {
@@ -439,7 +598,10 @@ void SessionManager::sessionGroupButtonAction( SessionGroupButton* button )
     }
     else if ( group == availableVideoSessions )
     {
-        sessionTree->toggleAutomaticRotate();
+        if ( wxIsMainThread() )
+            sessionTree->toggleAutomaticRotate();
+        else
+            rotateTogglePending = !rotateTogglePending;
     }
     else if ( group == audioSessions )
     {
@@ -455,6 +617,28 @@ void SessionManager::sessionGroupButtonAction( SessionGroupButton* button )
     objectManager->clearSelected();
 }
 
+void SessionManager::applyPendingActions()
+{
+    // this gets polled from the GUI thread's idle, so only take the scene if
+    // there's something there (the flags are only set with it held)
+    if ( !rotateToPending && !rotateTogglePending )
+        return;
+
+    objectManager->lockScene();
+    bool rotate = rotateToPending;
+    std::string rotateTo = pendingRotateTo;
+    bool toggle = rotateTogglePending;
+    rotateToPending = false;
+    rotateTogglePending = false;
+    objectManager->unlockScene();
+
+    // these lock what they need themselves
+    if ( rotate )
+        sessionTree->rotateToVideoSession( rotateTo );
+    if ( toggle )
+        sessionTree->toggleAutomaticRotate();
+}
+
 void SessionManager::checkGUISessionShift()
 {
     // this method doesn't do mutex locking - similar reasons to
@@ -590,6 +774,22 @@ bool SessionManager::isInFailedState( std::string addr, SessionType type )
     return ret;
 }
 
+bool SessionManager::isConnecting( std::string addr, SessionType type )
+{
+    lockSessions();
+
+    SessionEntry* entry = findSessionByAddress( addr, type );
+    if ( entry == NULL )
+    {
+        unlockSessions();
+        return false;
+    }
+
+    bool ret = entry->isConnecting();
+    unlockSessions();
+    return ret;
+}
+
 bool SessionManager::setEncryptionKey( std::string addr, std::string key )
 {
     lockSessions();
@@ -701,6 +901,12 @@ int SessionManager::getAudioSessionCount()
 
 void SessionManager::lockSessions()
 {
+    // adding & removing sessions changes what's drawn, so if there's a render
+    // thread it has to be kept out of the scene first. this is only safe
+    // since nothing holding the session lock waits on the scene - the network
+    // thread takes sessionMutex directly in iterateSessions, and its
+    // callbacks (see gravManager::removeSource) never wait for a frame
+    objectManager->lockScene();
     pause = true;
     mutex_lock( sessionMutex );
     lockCount++;
@@ -711,6 +917,7 @@ void SessionManager::unlockSessions()
     pause = false;
     lockCount--;
     mutex_unlock( sessionMutex );
+    objectManager->unlockScene();
 }
 
 void SessionManager::setSessionTreeControl( SessionTreeControl* s )
@@ -760,8 +967,27 @@ bool SessionManager::initSession( SessionEntry* session )
     return true;
 }
 
+bool SessionManager::initSessionAsync( SessionEntry* session )
+{
+    if ( session->isSessionEnabled() || session->isConnecting() )
+        return true;
+
+    VPMSessionListener* listener = session->isAudioSession() ?
+        (VPMSessionListener*)audioSessionListener :
+            (VPMSessionListener*)videoSessionListener;
+
+    session->startConnecting();
+    initializer->request( session, listener );
+
+    gravUtil::logVerbose( "SessionManager::connecting to %s session on %s\n",
+            session->isAudioSession() ? "audio" : "video",
+            session->getAddress().c_str() );
+    return true;
+}
+
 void SessionManager::disableSession( SessionEntry* session )
 {
+    initializer->cancel( session );
     session->disableSession();
 }
 
@@ -824,6 +1050,8 @@ bool SessionManager::shiftSession( SessionEntry* entry )
     Group* to;
     Group* from = entry->getGroup();
 
+    forgetRotateSession( entry );
+
     if ( from == videoSessions )
     {
         to = availableVideoSessions;
@@ -833,9 +1061,9 @@ bool SessionManager::shiftSession( SessionEntry* entry )
     {
         to = videoSessions;
 
-        if ( !entry->isSessionEnabled() )
+        if ( !entry->isSessionEnabled() && !entry->isConnecting() )
         {
-            initSession( entry );
+            initSessionAsync( entry );
         }
 
         int i = indexOf( entry );
@@ -859,3 +1087,154 @@ bool SessionManager::shiftSession( SessionEntry* entry )
 
     return true;
 }
+
+void SessionManager::startSwitch( SessionEntry* from, SessionEntry* to )
+{
+    // if the last switch isn't done yet, settle it first - from needs to be
+    // whatever's actually on screen
+    if ( rotateState == ROTATE_WAITING )
+    {
+        // the one we were waiting on never got shown
+        if ( switchTo != to )
+            stopSession( switchTo );
+        else
+            warmingSession = switchTo;
+        from = switchFrom;
+    }
+    else if ( rotateState == ROTATE_FADING )
+    {
+        stopSession( switchFrom );
+        from = switchTo;
+    }
+    switchFrom = NULL;
+    switchTo = NULL;
+    rotateState = ROTATE_IDLE;
+
+    // started the wrong one ahead of time (ie, rotated to something other
+    // than the next one)
+    if ( warmingSession != NULL && warmingSession != to )
+    {
+        stopSession( warmingSession );
+        warmingSession = NULL;
+    }
+
+    if ( from == to )
+    {
+        warmingSession = NULL;
+        return;
+    }
+
+    switchWarmed = warmingSession == to &&
+            ( to->isSessionEnabled() || to->isConnecting() );
+    warmingSession = NULL;
+    switchStartMS = getTimeMS();
+
+    // nothing on screen to keep up, so no point hiding the new one - if it's
+    // still connecting, it'll just show up when it's done
+    if ( from == NULL || !from->isSessionEnabled() )
+    {
+        if ( from != NULL && from->isConnecting() )
+            stopSession( from );
+        if ( to->isSessionEnabled() )
+            objectManager->revealSession( to->getSession(), NULL );
+        else
+            initSessionAsync( to );
+        return;
+    }
+
+    // started on a worker - finishSessionInits hides it when it's up, and
+    // updateRotation waits for it
+    if ( !switchWarmed && !to->isSessionEnabled() )
+        initSessionAsync( to );
+    else if ( !switchWarmed )
+        objectManager->setSessionStandby( to->getSession(), true );
+
+    switchFrom = from;
+    switchTo = to;
+    rotateState = ROTATE_WAITING;
+}
+
+void SessionManager::prewarmNext()
+{
+    if ( prewarmTried || sessionTree == NULL )
+        return;
+
+    long left = sessionTree->getTimer()->getTimeLeft();
+    if ( left < 0 || left > prewarmMS )
+        return;
+    prewarmTried = true;
+
+    lockSessions();
+
+    int numSessions = availableVideoSessions->numObjects();
+    // nothing to gain if there's only the one
+    if ( numSessions < 2 || rotatePos == -1 )
+    {
+        unlockSessions();
+        return;
+    }
+
+    SessionEntry* next = dynamic_cast<SessionEntry*>(
+            (*availableVideoSessions)[ ( rotatePos + 1 ) % numSessions ] );
+    // connecting happens on a worker, so this doesn't hold up the GUI (or a
+    // render thread, through the scene lock) - finishSessionInits hides it
+    // once it's up
+    if ( next != NULL && !next->isSessionEnabled() && !next->isConnecting() &&
+            initSessionAsync( next ) )
+    {
+        warmingSession = next;
+        gravUtil::logVerbose( "SessionManager::prewarmNext: starting %s "
+                "%ld ms before rotate\n", next->getAddress().c_str(), left );
+    }
+
+    unlockSessions();
+}
+
+void SessionManager::stopSession( SessionEntry* entry )
+{
+    VPMSession* session = entry->getSession();
+    disableSession( entry );
+    if ( session != NULL )
+        objectManager->setSessionStandby( session, false );
+}
+
+void SessionManager::forgetRotateSession( SessionEntry* entry )
+{
+    // anything hidden that's staying running needs to be shown
+    if ( entry == warmingSession )
+    {
+        if ( entry->isSessionEnabled() )
+            objectManager->revealSession( entry->getSession(), NULL );
+        warmingSession = NULL;
+    }
+
+    if ( rotateState == ROTATE_IDLE ||
+            ( entry != switchFrom && entry != switchTo ) )
+        return;
+
+    if ( rotateState == ROTATE_WAITING )
+    {
+        if ( switchTo->isSessionEnabled() )
+            objectManager->revealSession( switchTo->getSession(), NULL );
+        // the old one would be left running with nothing to stop it, since
+        // the rotate position's already moved on
+        if ( entry == switchTo )
+            stopSession( switchFrom );
+    }
+    else
+    {
+        // already faded out
+        stopSession( switchFrom );
+    }
+
+    switchFrom = NULL;
+    switchTo = NULL;
+    rotateState = ROTATE_IDLE;
+}
+
+long SessionManager::getTimeMS()
+{
+    timeval tv;
+    gettimeofday( &tv, NULL );
+    return ( tv.tv_sec * 1000L ) + ( tv.tv_usec / 1000L );
+}
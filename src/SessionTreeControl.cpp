@@ -110,6 +110,8 @@ void SessionTreeControl::addSession( std::string address, bool audio,
     added = sessionManager->addSession( address, type );
 
     current = AppendItem( node, wxString( address.c_str(), wxConvUTF8 ) );
+    // (if the address is already there, the first one stays indexed)
+    sessionItems.insert( std::make_pair( address, current ) );
     Expand( node );
 
     // note, these two cases shouldn't overlap - a rotate add won't return false
@@ -122,6 +124,25 @@ void SessionTreeControl::addSession( std::string address, bool audio,
         gravUtil::logWarning( "SessionTreeControl::addObject: "
                             "failed to initialize %s\n", address.c_str() );
     }
+    // grey until it's connected - see sessionInitFinished
+    else if ( sessionManager->isConnecting( address, type ) )
+        SetItemTextColour( current, *wxLIGHT_GREY );
+}
+
+void SessionTreeControl::sessionInitFinished( std::string address,
+                                                bool success )
+{
+    wxTreeItemId item = findSession( rootID, address );
+    if ( !item.IsOk() )
+        return;
+
+    SetItemTextColour( item, *wxBLACK );
+    if ( !success )
+    {
+        SetItemBackgroundColour( item, *wxRED );
+        gravUtil::logWarning( "SessionTreeControl::sessionInitFinished: "
+                            "failed to initialize %s\n", address.c_str() );
+    }
 }
 
 void SessionTreeControl::removeSession( std::string address )
@@ -151,7 +172,10 @@ void SessionTreeControl::removeSession( std::string address )
     }
 
     if ( sessionManager->removeSession( address, type ) )
+    {
         Delete( item );
+        forgetSession( address, item );
+    }
     else
     {
         gravUtil::logError( "SessionTreeControl::removeObject: "
@@ -162,6 +186,39 @@ void SessionTreeControl::removeSession( std::string address )
 
 wxTreeItemId SessionTreeControl::findSession( wxTreeItemId root,
                                                 std::string address )
+{
+    std::map<std::string, wxTreeItemId>::iterator it =
+        sessionItems.find( address );
+    if ( it == sessionItems.end() )
+    {
+        wxTreeItemId none;
+        return none;
+    }
+
+    if ( root == rootID || GetItemParent( it->second ) == root )
+        return it->second;
+
+    // same address somewhere else in the tree - rare enough to just look
+    return searchSession( root, address );
+}
+
+void SessionTreeControl::forgetSession( std::string address,
+                                        wxTreeItemId item )
+{
+    std::map<std::string, wxTreeItemId>::iterator it =
+        sessionItems.find( address );
+    if ( it == sessionItems.end() || it->second != item )
+        return;
+
+    sessionItems.erase( it );
+    // if there's another with the same address, that one's indexed now
+    wxTreeItemId other = searchSession( rootID, address );
+    if ( other.IsOk() )
+        sessionItems[ address ] = other;
+}
+
+wxTreeItemId SessionTreeControl::searchSession( wxTreeItemId root,
+                                                std::string address )
 {
     wxTreeItemIdValue temp; // unused var, needed in getchild
     wxTreeItemId targetItem;
@@ -176,7 +233,7 @@ wxTreeItemId SessionTreeControl::findSession( wxTreeItemId root,
 
         if ( ItemHasChildren( current ) )
         {
-            targetItem = findSession( current, address );
+            targetItem = searchSession( current, address );
             if ( targetItem.IsOk() )
                 return targetItem;
         }
@@ -230,9 +287,11 @@ void SessionTreeControl::shiftSession( std::string address, bool audio )
         }
 
         Delete( item );
+        forgetSession( address, item );
 
         wxTreeItemId newNode = AppendItem( newParent,
                 wxString( address.c_str(), wxConvUTF8 ) );
+        sessionItems.insert( std::make_pair( address, newNode ) );
         Expand( newParent );
 
         if ( newParent == availableVideoNodeID )
@@ -244,6 +303,9 @@ void SessionTreeControl::shiftSession( std::string address, bool audio )
         if ( newParent == videoNodeID &&
                 sessionManager->isInFailedState( address, VIDEOSESSION ) )
             SetItemBackgroundColour( newNode, *wxRED );
+        else if ( newParent == videoNodeID &&
+                sessionManager->isConnecting( address, VIDEOSESSION ) )
+            SetItemTextColour( newNode, *wxLIGHT_GREY );
     }
     else
     {
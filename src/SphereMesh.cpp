@@ -0,0 +1,148 @@
+/*
+ * @file SphereMesh.cpp
+ *
+ * Implementation of the sphere vertex buffer.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SphereMesh.h"
+
+#include <cmath>
+
+SphereMesh::SphereMesh( float radius, float u0, float v0, float du, float dv,
+                        int cols, int rows )
+{
+    // indices are 16 bit
+    if ( ( cols + 1 ) * ( rows + 1 ) > 65536 )
+    {
+        gravUtil::logWarning( "SphereMesh: %ix%i is too big, clamping\n",
+                              cols, rows );
+        cols = 254;
+        rows = 254;
+    }
+
+    for ( int r = 0; r <= rows; r++ )
+    {
+        float v = v0 + dv * ( (float)r / (float)rows );
+        // same parameterization as gluSphere: rho is the angle down from +z,
+        // theta goes around the other way from s
+        double rho = v * M_PI;
+        for ( int c = 0; c <= cols; c++ )
+        {
+            float u = u0 + du * ( (float)c / (float)cols );
+            double theta = ( 1.0 - u ) * 2.0 * M_PI;
+            verts.push_back( radius * sin( rho ) * sin( theta ) );
+            verts.push_back( radius * sin( rho ) * cos( theta ) );
+            verts.push_back( radius * cos( rho ) );
+            verts.push_back( (float)c / (float)cols );
+            verts.push_back( 1.0f - ( (float)r / (float)rows ) );
+        }
+    }
+
+    // two triangles per quad, counterclockwise seen from outside
+    for ( int r = 0; r < rows; r++ )
+    {
+        for ( int c = 0; c < cols; c++ )
+        {
+            GLushort tl = r * ( cols + 1 ) + c;
+            GLushort tr = tl + 1;
+            GLushort bl = tl + ( cols + 1 );
+            GLushort br = bl + 1;
+            indices.push_back( tl );
+            indices.push_back( bl );
+            indices.push_back( tr );
+            indices.push_back( tr );
+            indices.push_back( bl );
+            indices.push_back( br );
+        }
+    }
+    numIndices = indices.size();
+
+    vertexBuffer = 0;
+    indexBuffer = 0;
+    if ( haveVBOs() )
+    {
+        glGenBuffers( 1, &vertexBuffer );
+        glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
+        glBufferData( GL_ARRAY_BUFFER, verts.size() * sizeof( GLfloat ),
+                      &verts[0], GL_STATIC_DRAW );
+        glGenBuffers( 1, &indexBuffer );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBuffer );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER,
+                      indices.size() * sizeof( GLushort ), &indices[0],
+                      GL_STATIC_DRAW );
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+        // the GL has its own copy now
+        std::vector<GLfloat>().swap( verts );
+        std::vector<GLushort>().swap( indices );
+    }
+}
+
+SphereMesh::~SphereMesh()
+{
+    if ( vertexBuffer != 0 )
+        glDeleteBuffers( 1, &vertexBuffer );
+    if ( indexBuffer != 0 )
+        glDeleteBuffers( 1, &indexBuffer );
+}
+
+void SphereMesh::draw()
+{
+    const GLsizei stride = 5 * sizeof( GLfloat );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+    if ( vertexBuffer != 0 )
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBuffer );
+        glVertexPointer( 3, GL_FLOAT, stride, (GLvoid*)0 );
+        glTexCoordPointer( 2, GL_FLOAT, stride,
+                           (GLvoid*)( 3 * sizeof( GLfloat ) ) );
+        glDrawElements( GL_TRIANGLES, numIndices, GL_UNSIGNED_SHORT,
+                        (GLvoid*)0 );
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    }
+    else
+    {
+        glVertexPointer( 3, GL_FLOAT, stride, &verts[0] );
+        glTexCoordPointer( 2, GL_FLOAT, stride, &verts[3] );
+        glDrawElements( GL_TRIANGLES, numIndices, GL_UNSIGNED_SHORT,
+                        &indices[0] );
+    }
+
+    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+    glDisableClientState( GL_VERTEX_ARRAY );
+}
+
+unsigned int SphereMesh::getNumTriangles()
+{
+    return numIndices / 3;
+}
+
+bool SphereMesh::haveVBOs()
+{
+    // (glGenBuffers etc. are the core 1.5 names GLEW sets up)
+    return GLEW_VERSION_1_5;
+}
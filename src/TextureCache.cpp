@@ -0,0 +1,254 @@
+/*
+ * @file TextureCache.cpp
+ *
+ * Implementation of the on-disk decoded image cache.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextureCache.h"
+#include "gravUtil.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool TextureCache::enabled = false;
+std::string TextureCache::directory = "";
+volatile int TextureCache::tempCounter = 0;
+
+// start of every entry; the pixels follow straight after
+typedef struct CacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t width, height;
+    uint32_t texWidth, texHeight;
+} CacheHeader;
+
+static const char cacheMagic[4] = { 'g', 'r', 'v', 't' };
+
+void TextureCache::init( bool enable )
+{
+    enabled = false;
+    if ( !enable )
+    {
+        gravUtil::logVerbose( "TextureCache::init: cache disabled\n" );
+        return;
+    }
+
+    const char* xdg = getenv( "XDG_CACHE_HOME" );
+    const char* home = getenv( "HOME" );
+    std::string base;
+    if ( xdg != NULL && xdg[0] != '\0' )
+        base = xdg;
+    else if ( home != NULL && home[0] != '\0' )
+        base = std::string( home ) + "/.cache";
+    else
+    {
+        gravUtil::logWarning( "TextureCache::init: no cache dir (HOME not "
+                              "set), cache disabled\n" );
+        return;
+    }
+
+    // parent may not exist either (ie ~/.cache on a fresh account)
+    mkdir( base.c_str(), 0755 );
+    directory = base + "/grav/";
+    if ( mkdir( directory.c_str(), 0755 ) != 0 && errno != EEXIST )
+    {
+        gravUtil::logWarning( "TextureCache::init: couldn't create %s, cache "
+                              "disabled\n", directory.c_str() );
+        return;
+    }
+
+    enabled = true;
+    gravUtil::logVerbose( "TextureCache::init: using %s\n",
+                          directory.c_str() );
+}
+
+bool TextureCache::load( std::string filename, DecodedImage& image )
+{
+    PNGLoader::initImage( image );
+    long start = getTimeMS();
+
+    uint64_t hash = 0;
+    std::string entry;
+    if ( enabled && hashFile( filename, hash ) )
+    {
+        char name[32];
+        snprintf( name, sizeof( name ), "%016llx.rgba",
+                  (unsigned long long)hash );
+        entry = directory + name;
+
+        if ( readEntry( entry, hash, image ) )
+        {
+            gravUtil::logVerbose( "TextureCache::load: %s from cache in "
+                                  "%ldms\n", filename.c_str(),
+                                  getTimeMS() - start );
+            return true;
+        }
+    }
+
+    if ( !PNGLoader::decodePNG( filename, image ) )
+        return false;
+    gravUtil::logVerbose( "TextureCache::load: decoded %s in %ldms\n",
+                          filename.c_str(), getTimeMS() - start );
+
+    if ( entry.compare( "" ) != 0 )
+        writeEntry( entry, hash, image );
+    return true;
+}
+
+bool TextureCache::isEnabled()
+{
+    return enabled;
+}
+
+std::string TextureCache::getDirectory()
+{
+    return directory;
+}
+
+bool TextureCache::hashFile( std::string filename, uint64_t& hash )
+{
+    FILE* f = fopen( filename.c_str(), "rb" );
+    if ( f == NULL )
+        return false;
+
+    // 64 bit FNV-1a - reading the compressed file is cheap next to decoding
+    // it, and this doesn't need to be cryptographic
+    uint64_t h = 14695981039346656037ULL;
+    unsigned char buf[ 65536 ];
+    size_t read;
+    while ( ( read = fread( buf, 1, sizeof( buf ), f ) ) > 0 )
+    {
+        for ( size_t i = 0; i < read; i++ )
+        {
+            h ^= buf[i];
+            h *= 1099511628211ULL;
+        }
+    }
+    bool ok = !ferror( f );
+    fclose( f );
+
+    hash = h;
+    return ok;
+}
+
+bool TextureCache::readEntry( std::string entry, uint64_t hash,
+                              DecodedImage& image )
+{
+    int fd = open( entry.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        return false;
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || (size_t)st.st_size < sizeof( CacheHeader ) )
+    {
+        close( fd );
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void* mapping = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    // the mapping stays valid after the fd is closed
+    close( fd );
+    if ( mapping == MAP_FAILED )
+        return false;
+
+    const CacheHeader* header = (const CacheHeader*)mapping;
+    bool valid = memcmp( header->magic, cacheMagic, 4 ) == 0 &&
+        header->version == version && header->sourceHash == hash &&
+        header->texWidth >= header->width &&
+        header->texHeight >= header->height &&
+        size == sizeof( CacheHeader ) +
+            ( (size_t)header->texWidth * header->texHeight * 4 );
+    if ( !valid )
+    {
+        gravUtil::logWarning( "TextureCache::readEntry: ignoring bad entry "
+                              "%s\n", entry.c_str() );
+        munmap( mapping, size );
+        return false;
+    }
+
+    image.width = header->width;
+    image.height = header->height;
+    image.texWidth = header->texWidth;
+    image.texHeight = header->texHeight;
+    image.pixels = (unsigned char*)mapping + sizeof( CacheHeader );
+    image.mapping = mapping;
+    image.mappingSize = size;
+    return true;
+}
+
+bool TextureCache::writeEntry( std::string entry, uint64_t hash,
+                               const DecodedImage& image )
+{
+    CacheHeader header;
+    memcpy( header.magic, cacheMagic, 4 );
+    header.version = version;
+    header.sourceHash = hash;
+    header.width = image.width;
+    header.height = image.height;
+    header.texWidth = image.texWidth;
+    header.texHeight = image.texHeight;
+    size_t pixelBytes = (size_t)image.texWidth * image.texHeight * 4;
+
+    // write to a temp file & rename it into place, so another thread/process
+    // loading the same file never maps a half written entry
+    char suffix[48];
+    snprintf( suffix, sizeof( suffix ), ".%i.%i.tmp", (int)getpid(),
+              __sync_fetch_and_add( &tempCounter, 1 ) );
+    std::string temp = entry + suffix;
+
+    FILE* f = fopen( temp.c_str(), "wb" );
+    if ( f == NULL )
+    {
+        gravUtil::logWarning( "TextureCache::writeEntry: couldn't write %s\n",
+                              temp.c_str() );
+        return false;
+    }
+    bool ok = fwrite( &header, sizeof( header ), 1, f ) == 1 &&
+        fwrite( image.pixels, 1, pixelBytes, f ) == pixelBytes;
+    ok = ( fclose( f ) == 0 ) && ok;
+
+    if ( !ok || rename( temp.c_str(), entry.c_str() ) != 0 )
+    {
+        gravUtil::logWarning( "TextureCache::writeEntry: couldn't write %s\n",
+                              entry.c_str() );
+        remove( temp.c_str() );
+        return false;
+    }
+    return true;
+}
+
+long TextureCache::getTimeMS()
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return ( tv.tv_sec * 1000 ) + ( tv.tv_usec / 1000 );
+}
@@ -25,14 +25,17 @@
 
 #include "Timers.h"
 #include "SessionTreeControl.h"
+#include "TreeControl.h"
 #include "GLCanvas.h"
+#include "FrameScheduler.h"
 #include "gravUtil.h"
 
+#include <algorithm>
+
 RenderTimer::RenderTimer( GLCanvas* c, int i ) :
     canvas( c ), interval( i )
 {
-    gettimeofday( &time, NULL );
-    lastTimeMS = time.tv_usec;
+    lastTimeUS = FrameScheduler::getTimeUS();
 }
 
 void RenderTimer::Notify()
@@ -57,20 +60,12 @@ void RenderTimer::printTiming()
 
 time_t RenderTimer::getTiming()
 {
-    gettimeofday( &time, NULL );
-    time_t diff;
-
-    if ( lastTimeMS > time.tv_usec )
-        diff = (time.tv_usec+1000000) - lastTimeMS;
-    else
-        diff = time.tv_usec - lastTimeMS;
-
-    return diff;
+    return (time_t)( FrameScheduler::getTimeUS() - lastTimeUS );
 }
 
 void RenderTimer::resetTiming()
 {
-    lastTimeMS = time.tv_usec;
+    lastTimeUS = FrameScheduler::getTimeUS();
 }
 
 RotateTimer::RotateTimer( SessionTreeControl* s ) :
@@ -97,3 +92,19 @@ float RotateTimer::getProgress()
 {
     return (float)stopwatch.Time() / (float)counterMax;
 }
+
+long RotateTimer::getTimeLeft()
+{
+    if ( !IsRunning() )
+        return -1;
+    return std::max( 0L, (long)counterMax - stopwatch.Time() );
+}
+
+TreeSyncTimer::TreeSyncTimer( TreeControl* t ) :
+    tree( t )
+{ }
+
+void TreeSyncTimer::Notify()
+{
+    tree->applyChanges();
+}
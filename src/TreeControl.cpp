@@ -29,6 +29,7 @@
 #include "gravUtil.h"
 #include "TreeNode.h"
 #include "Runway.h"
+#include "Timers.h"
 
 #include <wx/wx.h>
 
@@ -36,22 +37,152 @@ IMPLEMENT_DYNAMIC_CLASS( TreeControl, wxTreeCtrl )
 
 TreeControl::TreeControl() :
     wxTreeCtrl( NULL, wxID_ANY )
-{ }
+{
+    batchDepth = 0;
+    syncTimer = new TreeSyncTimer( this );
+    syncScheduled = false;
+    syncDeferred = false;
+    sourceManager = NULL;
+}
 
 TreeControl::TreeControl( wxWindow* parent ) :
     wxTreeCtrl( parent, wxID_ANY, parent->GetPosition(), parent->GetSize() )
 {
     rootID = AddRoot( _("Groups"), -1, -1, new wxTreeItemData() );
     //SetWindowStyle( GetWindowStyle() | wxTR_HIDE_ROOT );
+    batchDepth = 0;
+    syncTimer = new TreeSyncTimer( this );
+    syncScheduled = false;
+    syncDeferred = false;
+    sourceManager = NULL;
 }
 
 TreeControl::~TreeControl()
 {
+    syncTimer->Stop();
+    delete syncTimer;
     sourceManager->setTree( NULL );
 }
 
 void TreeControl::addObject( RectangleBase* obj )
 {
+    pendingObjects[ obj ] = true;
+    scheduleSync();
+}
+
+void TreeControl::removeObject( RectangleBase* obj )
+{
+    pendingObjects.erase( obj );
+
+    std::map<RectangleBase*, wxTreeItemId>::iterator it =
+        itemIndex.find( obj );
+    if ( it == itemIndex.end() )
+        return;
+
+    // the object can be deleted before the item is, so make sure nothing
+    // (ie, sorting) can get to it through the item
+    TreeNode* data = dynamic_cast<TreeNode*>( GetItemData( it->second ) );
+    if ( data != NULL )
+        data->setObject( NULL );
+
+    pendingRemovals[ it->second.GetID() ] = it->second;
+    itemIndex.erase( it );
+    scheduleSync();
+}
+
+void TreeControl::updateObjectName( RectangleBase* obj )
+{
+    // insert, so this doesn't clobber a queued add
+    pendingObjects.insert( std::pair<RectangleBase*, bool>( obj, false ) );
+    scheduleSync();
+}
+
+void TreeControl::scheduleSync()
+{
+    // everything that comes in before the timer fires goes in the same sync
+    if ( syncScheduled )
+        return;
+    syncScheduled = true;
+
+    // timers can only be started from the GUI thread - from a render thread,
+    // startDeferredSync does it later
+    if ( wxIsMainThread() )
+        syncTimer->Start( syncIntervalMS, true );
+    else
+        syncDeferred = true;
+}
+
+void TreeControl::startDeferredSync()
+{
+    if ( !syncDeferred )
+        return;
+
+    // set by the render thread with the scene held (see scheduleSync)
+    if ( sourceManager != NULL )
+        sourceManager->lockScene();
+    syncDeferred = false;
+    if ( sourceManager != NULL )
+        sourceManager->unlockScene();
+
+    syncTimer->Start( syncIntervalMS, true );
+}
+
+void TreeControl::applyChanges()
+{
+    if ( sourceManager != NULL )
+        sourceManager->lockScene();
+
+    syncScheduled = false;
+    if ( pendingRemovals.empty() && pendingObjects.empty() )
+    {
+        if ( sourceManager != NULL )
+            sourceManager->unlockScene();
+        return;
+    }
+
+    // objects are only changed & deleted by whichever thread draws, or the
+    // GUI thread with the scene locked, so the ones left in the queue are all
+    // safe to look at here
+    beginBatch();
+
+    // removals first, so an object that was removed & added again (ie, to
+    // move it under a group) ends up with a fresh item
+    while ( !pendingRemovals.empty() )
+    {
+        std::map<void*, wxTreeItemId>::iterator it = pendingRemovals.begin();
+        wxTreeItemId item = it->second;
+        pendingRemovals.erase( it );
+        deleteItem( item );
+    }
+
+    std::map<RectangleBase*, bool> objects;
+    objects.swap( pendingObjects );
+
+    // groups before everything else, so their members have somewhere to go
+    std::map<RectangleBase*, bool>::iterator oi;
+    for ( oi = objects.begin(); oi != objects.end(); ++oi )
+    {
+        if ( oi->first->isGroup() )
+            syncObject( oi->first, oi->second );
+    }
+    for ( oi = objects.begin(); oi != objects.end(); ++oi )
+    {
+        if ( !oi->first->isGroup() )
+            syncObject( oi->first, oi->second );
+    }
+
+    endBatch();
+
+    if ( sourceManager != NULL )
+        sourceManager->unlockScene();
+}
+
+void TreeControl::syncObject( RectangleBase* obj, bool add )
+{
+    wxTreeItemId item = findObject( rootID, obj );
+    if ( !item.IsOk() && !add )
+        return;
+
     wxTreeItemId parentID;
 
     // if it's not grouped, or it's in the runway, we can add it to root
@@ -67,96 +198,136 @@ void TreeControl::addObject( RectangleBase* obj )
         parentID = findObject( rootID, parent );
     }
 
-    if ( parentID.IsOk() )
+    if ( !parentID.IsOk() )
     {
-        wxTreeItemId newItem = AppendItem( parentID,
-                        wxString( obj->getName().c_str(), wxConvUTF8 ),
-                        -1, -1, new TreeNode( obj, false ) );
-        if ( obj->getName() == "" )
-            SetItemText( newItem, _( "(waiting for name...)" ) );
-        SortChildren( parentID );
-
-        // if we're going from 1 to 2 objects (1 to 2 objects in the tree
-        // means 0 to 1 sources since the root node counts as an object)
-        // expand the root level automatically so it'll be expanded by
-        // default, but also if the number goes back to 0 and up again
-        if ( GetCount() == 2 )
-            Expand( rootID );
+        gravUtil::logWarning( "TreeControl::syncObject: parent NOT found\n" );
+        return;
     }
-    else
+
+    if ( !item.IsOk() )
+    {
+        appendObject( parentID, obj );
+    }
+    else if ( GetItemParent( item ) != parentID )
     {
-        gravUtil::logWarning( "TreeControl::addObject: parent NOT found\n" );
+        // moved in or out of a group - only non-groups get grouped, so there
+        // aren't any children to worry about
+        itemIndex.erase( obj );
+        pendingSorts.erase( item.GetID() );
+        Delete( item );
+        appendObject( parentID, obj );
+    }
+    else if ( obj->getName() != "" )
+    {
+        SetItemText( item, wxString( obj->getName().c_str(), wxConvUTF8 ) );
+        sortChildren( parentID );
     }
 }
 
-void TreeControl::removeObject( RectangleBase* obj )
+void TreeControl::deleteItem( wxTreeItemId item )
 {
-    wxTreeItemId item = findObject( rootID, obj );
-    if ( !item.IsOk() )
+    // if we're removing a group, queue all of its children to be added back
+    // (they get done after this, so they don't end up back under it).
+    // children that were removed too have no object & just go with the group
+    wxTreeItemIdValue temp;
+    wxTreeItemId current = GetFirstChild( item, temp );
+
+    while ( current.IsOk() )
     {
-        gravUtil::logWarning( "TreeControl::removeObject: item %s not found?\n",
-                    obj->getName().c_str() );
-        return;
+        TreeNode* data = dynamic_cast<TreeNode*>( GetItemData( current ) );
+        if ( data != NULL && data->getObject() != NULL )
+            pendingObjects[ data->getObject() ] = true;
+        else
+            pendingRemovals.erase( current.GetID() );
+        current = GetNextChild( item, temp );
     }
 
-    // if we're removing a group, take all of its children and add them to
-    // root
-    if ( obj->isGroup() )
-    {
-        wxTreeItemId parent = rootID;
-        wxTreeItemIdValue temp;
-        wxTreeItemId current = GetFirstChild( item, temp );
+    forgetChildren( item );
+    pendingSorts.erase( item.GetID() );
+    Delete( item );
+}
 
-        while ( current.IsOk() )
-        {
-            TreeNode* data = dynamic_cast<TreeNode*>( GetItemData( current ) );
-            if ( data != NULL )
-            {
-                RectangleBase* obj = data->getObject();
-                addObject( obj );
-            }
-            current = GetNextChild( item, temp );
-        }
+wxTreeItemId TreeControl::appendObject( wxTreeItemId parentID,
+                                        RectangleBase* obj )
+{
+    wxTreeItemId newItem = AppendItem( parentID,
+                    wxString( obj->getName().c_str(), wxConvUTF8 ),
+                    -1, -1, new TreeNode( obj, false ) );
+    if ( obj->getName() == "" )
+        SetItemText( newItem, _( "(waiting for name...)" ) );
+    itemIndex[ obj ] = newItem;
+    sortChildren( parentID );
 
-        DeleteChildren( item );
-    }
+    // if we're going from 1 to 2 objects (1 to 2 objects in the tree
+    // means 0 to 1 sources since the root node counts as an object)
+    // expand the root level automatically so it'll be expanded by
+    // default, but also if the number goes back to 0 and up again
+    if ( GetCount() == 2 )
+        Expand( rootID );
 
-    Delete( item );
+    return newItem;
 }
 
-wxTreeItemId TreeControl::findObject( wxTreeItemId root, RectangleBase* obj )
+void TreeControl::forgetChildren( wxTreeItemId item )
 {
-    wxTreeItemIdValue temp; // unused var, needed in getchild
-    wxTreeItemId targetItem;
-    wxTreeItemId current = GetFirstChild( root, temp );
+    wxTreeItemIdValue temp;
+    wxTreeItemId current = GetFirstChild( item, temp );
 
     while ( current.IsOk() )
     {
         TreeNode* data = dynamic_cast<TreeNode*>( GetItemData( current ) );
         if ( data != NULL )
         {
-            RectangleBase* target = data->getObject();
-            if ( target == obj )
-                return current;
+            std::map<RectangleBase*, wxTreeItemId>::iterator it =
+                itemIndex.find( data->getObject() );
+            if ( it != itemIndex.end() && it->second == current )
+                itemIndex.erase( it );
         }
+        pendingSorts.erase( current.GetID() );
         if ( ItemHasChildren( current ) )
-        {
-            targetItem = findObject( current, obj );
-            if ( targetItem.IsOk() )
-                return targetItem;
-        }
-        current = GetNextChild( root, temp );
+            forgetChildren( current );
+        current = GetNextChild( item, temp );
     }
+}
+
+wxTreeItemId TreeControl::findObject( wxTreeItemId root, RectangleBase* obj )
+{
+    std::map<RectangleBase*, wxTreeItemId>::iterator it =
+        itemIndex.find( obj );
+    if ( it != itemIndex.end() )
+        return it->second;
 
     wxTreeItemId none;
     return none; // return default value if not found
 }
 
-void TreeControl::updateObjectName( RectangleBase* obj )
+void TreeControl::beginBatch()
 {
-    wxTreeItemId item = findObject( rootID, obj );
-    SetItemText( item, wxString( obj->getName().c_str(), wxConvUTF8 ) );
-    SortChildren( GetItemParent( item ) );
+    if ( batchDepth++ == 0 )
+        Freeze();
+}
+
+void TreeControl::endBatch()
+{
+    if ( batchDepth == 0 || --batchDepth > 0 )
+        return;
+
+    std::map<void*, wxTreeItemId>::iterator it;
+    for ( it = pendingSorts.begin(); it != pendingSorts.end(); ++it )
+        SortChildren( it->second );
+    pendingSorts.clear();
+    Thaw();
+}
+
+void TreeControl::sortChildren( wxTreeItemId item )
+{
+    if ( !item.IsOk() )
+        return;
+
+    if ( batchDepth > 0 )
+        pendingSorts[ item.GetID() ] = item;
+    else
+        SortChildren( item );
 }
 
 int TreeControl::OnCompareItems( const wxTreeItemId& item1,
@@ -32,3 +32,8 @@ RectangleBase* TreeNode::getObject()
 {
     return object;
 }
+
+void TreeNode::setObject( RectangleBase* obj )
+{
+    object = obj;
+}
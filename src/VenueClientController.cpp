@@ -29,6 +29,8 @@
 #include "VenueNode.h"
 #include "gravUtil.h"
 
+#include <sys/time.h>
+
 VenueClientController::VenueClientController( float _x, float _y,
                                                 gravManager* g )
     : Group( _x, _y ), grav( g )
@@ -50,6 +52,17 @@ VenueClientController::VenueClientController( float _x, float _y,
 
     pyTools = PythonTools::getInstance();
 
+    clientRequest = NULL;
+    nameRequest = NULL;
+    exitsRequest = NULL;
+    streamsRequest = NULL;
+    enterRequest = NULL;
+    lastRefreshMS = 0;
+    haveRefreshed = false;
+    fullRefresh = false;
+    pendingShow = false;
+    pendingAddStreams = false;
+
     AGToolsScript = gravUtil::getInstance()->findFile( "AGTools.py" );
     if ( AGToolsScript.compare( "" ) == 0 )
     {
@@ -57,13 +70,20 @@ VenueClientController::VenueClientController( float _x, float _y,
                 "AGTools.py not found\n" );
     }
 
-    // if we have a valid venue client, this show call will update
-    // the venue name and exits as well as hide the interface by default
-    show( false, true );
+    // hidden by default. venue info isn't fetched until it's first shown,
+    // so python doesn't get started for runs that never use it
+    Group::show( false, true );
 }
 
 VenueClientController::~VenueClientController()
 {
+    PythonRequest* requests[] = { clientRequest, nameRequest, exitsRequest,
+                                  streamsRequest, enterRequest };
+    for ( int i = 0; i < 5; i++ )
+    {
+        if ( requests[i] != NULL )
+            requests[i]->release();
+    }
     removeAll();
 }
 
@@ -121,21 +141,14 @@ std::vector<RectangleBase*>::iterator VenueClientController::remove(
 
 bool VenueClientController::tryGetValidVenueClient( bool instantHide )
 {
-    PyObject* res = pyTools->call( AGToolsScript, "GetFirstValidClientURL" );
-    if ( res != NULL && res != Py_None )
-    {
-        venueClientUrl = PyString_AsString( res );
-    }
-    else
-    {
-        venueClientUrl = "";
-    }
-    Py_XDECREF( res );
+    if ( !haveRefreshed || getTimeMS() - lastRefreshMS > cacheTTLMS )
+        refresh( false );
 
     if ( venueClientUrl.compare( "" ) == 0 )
     {
-        gravUtil::logVerbose( "VenueClientController::tryGetValidVenueClient: "
-                "no venue clients found\n" );
+        if ( haveRefreshed )
+            gravUtil::logVerbose( "VenueClientController::"
+                    "tryGetValidVenueClient: no venue clients found\n" );
         /*
          * Since this function is equivalent to "is the VCC showable", if it's
          * not showable, forcibly hide it if it is shown, since that state makes
@@ -158,14 +171,118 @@ bool VenueClientController::tryGetValidVenueClient( bool instantHide )
     }
 }
 
-void VenueClientController::updateExitMap()
+void VenueClientController::refresh( bool full )
+{
+    fullRefresh = fullRefresh || full;
+    // the one in progress will pick up the full flag
+    if ( isRefreshing() )
+        return;
+
+    clientRequest = pyTools->callAsync( AGToolsScript,
+            "GetFirstValidClientURL", PythonRequest::STRING_RESULT );
+}
+
+void VenueClientController::checkRequests()
+{
+    if ( clientRequest != NULL && clientRequest->isDone() )
+    {
+        venueClientUrl = clientRequest->getString();
+        clientRequest->release();
+        clientRequest = NULL;
+
+        if ( venueClientUrl.compare( "" ) != 0 )
+            nameRequest = pyTools->callAsync( AGToolsScript,
+                    "GetCurrentVenueName", venueClientUrl,
+                    PythonRequest::STRING_RESULT );
+        else
+            finishRefresh();
+    }
+
+    if ( nameRequest != NULL && nameRequest->isDone() )
+    {
+        // only bother getting the rest if the venue's changed
+        std::string oldName = currentVenue;
+        currentVenue = nameRequest->getString();
+        nameRequest->release();
+        nameRequest = NULL;
+
+        if ( fullRefresh || oldName.compare( currentVenue ) != 0 )
+        {
+            fullRefresh = false;
+            exitsRequest = pyTools->callAsync( AGToolsScript, "GetExits",
+                    venueClientUrl, PythonRequest::MAP_RESULT );
+
+            std::vector<std::string> args;
+            args.push_back( venueClientUrl );
+            args.push_back( "video" );
+            streamsRequest = pyTools->callAsync( AGToolsScript,
+                    "GetFormattedVenueStreams", args,
+                    PythonRequest::MAP_RESULT );
+        }
+        else
+            finishRefresh();
+    }
+
+    if ( exitsRequest != NULL && exitsRequest->isDone() )
+    {
+        exitMap = exitsRequest->getMap();
+        exitsRequest->release();
+        exitsRequest = NULL;
+        updateExitNodes();
+        if ( streamsRequest == NULL )
+            finishRefresh();
+    }
+
+    if ( streamsRequest != NULL && streamsRequest->isDone() )
+    {
+        currentVenueStreams = streamsRequest->getMap();
+        streamsRequest->release();
+        streamsRequest = NULL;
+        if ( exitsRequest == NULL )
+            finishRefresh();
+    }
+
+    if ( enterRequest != NULL && enterRequest->isDone() )
+    {
+        enterRequest->release();
+        enterRequest = NULL;
+        // this will in turn update the exit map, venue streams, etc.
+        pendingAddStreams = true;
+        refresh( true );
+    }
+}
+
+void VenueClientController::finishRefresh()
 {
-    PyObject* pRes = pyTools->call( AGToolsScript, "GetExits",
-                                    venueClientUrl );
-    exitMap = pyTools->dtom( pRes );
-    Py_XDECREF( pRes );
+    // (see gravManager::updateSessions)
+    grav->lockScene();
+    lastRefreshMS = getTimeMS();
+    haveRefreshed = true;
+
+    if ( pendingAddStreams )
+    {
+        pendingAddStreams = false;
+        addAllVenueStreams();
+    }
+
+    if ( pendingShow )
+    {
+        pendingShow = false;
+        applyShow( true, false );
+    }
+    grav->unlockScene();
+}
 
+bool VenueClientController::isRefreshing()
+{
+    return clientRequest != NULL || nameRequest != NULL ||
+            exitsRequest != NULL || streamsRequest != NULL;
+}
+
+void VenueClientController::updateExitNodes()
+{
     // TODO check if exitMap changes here, to avoid needless remake?
+    grav->lockScene();
     removeAll();
     std::map<std::string, std::string>::iterator i;
     for ( i = exitMap.begin(); i != exitMap.end(); ++i )
@@ -179,12 +296,23 @@ void VenueClientController::updateExitMap()
         grav->unlockSources();
         add( node );
     }
+
+    // these can come in while shown, so put them in the right state
+    if ( shown )
+        rearrange();
+    else
+    {
+        for ( unsigned int i = 0; i < objects.size(); i++ )
+        {
+            objects[i]->show( false, true );
+            objects[i]->move( getX(), getY() );
+        }
+    }
+    grav->unlockScene();
 }
 
 void VenueClientController::printExitMap()
 {
-    //updateExitMap();
-
     if ( venueClientUrl.compare( "" ) == 0 )
     {
         return;
@@ -216,45 +344,32 @@ void VenueClientController::enterVenue( std::string venueName )
         return;
     }
 
+    if ( enterRequest != NULL )
+    {
+        gravUtil::logWarning( "VenueClientController::enterVenue: "
+                "already entering a venue\n" );
+        return;
+    }
+
     removeAllVenueStreams();
 
-    PyObject* args = PyTuple_New( 2 );
-    PyTuple_SetItem( args, 0, PyString_FromString( venueClientUrl.c_str() ) );
-    PyTuple_SetItem( args, 1, PyString_FromString( it->second.c_str() ) );
+    std::vector<std::string> args;
+    args.push_back( venueClientUrl );
+    args.push_back( it->second );
 
     gravUtil::logVerbose( "VenueClientController::calling entervenue on %s to"
             " %s\n", venueClientUrl.c_str(), it->second.c_str() );
 
-    pyTools->call( AGToolsScript, "EnterVenue", args );
+    // the rest happens in checkRequests once this is done
+    enterRequest = pyTools->callAsync( AGToolsScript, "EnterVenue", args );
 
-    // this will in turn update the exit map, venue streams, etc.
     show( false );
-
-    addAllVenueStreams();
 }
 
-void VenueClientController::updateVenueStreams()
+void VenueClientController::updateVenueStreams( bool add )
 {
-    std::string type = "video";
-    PyObject* args = PyTuple_New( 2 );
-    PyTuple_SetItem( args, 0, PyString_FromString( venueClientUrl.c_str() ) );
-    PyTuple_SetItem( args, 1, PyString_FromString( type.c_str() ) );
-
-    PyObject* res = pyTools->call( AGToolsScript, "GetFormattedVenueStreams",
-                                    args );
-    currentVenueStreams = pyTools->dtom( res );
-    Py_XDECREF( res );
-}
-
-void VenueClientController::updateVenueName()
-{
-    PyObject* res = pyTools->call( AGToolsScript, "GetCurrentVenueName",
-                                    venueClientUrl.c_str() );
-    if ( res != NULL && res != Py_None )
-        currentVenue = PyString_AsString( res );
-    else
-        currentVenue = "";
-    Py_XDECREF( res );
+    pendingAddStreams = pendingAddStreams || add;
+    refresh( true );
 }
 
 void VenueClientController::removeAllVenueStreams()
@@ -289,17 +404,12 @@ void VenueClientController::addAllVenueStreams()
 
 void VenueClientController::rearrange()
 {
-    std::map<std::string, std::string> opts;
-
-    std::map<std::string, std::vector<RectangleBase*> > data;
-    data["objects"] = objects;
-
     RectangleBase smaller = *this;
     // uneven since most screens will be widescreen - so make vertical area
     // bigger so objects on top/bottom are bigger and text more readable
     smaller.setScale( smaller.getScaleX() * 0.6f,
                         smaller.getScaleY() * 0.45f );
-    layouts.arrange( "perimeter", *this, smaller, data, opts );
+    layouts.arrange( PERIMETER_LAYOUT, *this, smaller, objects );
 }
 
 bool VenueClientController::updateName()
@@ -310,24 +420,25 @@ bool VenueClientController::updateName()
 
 void VenueClientController::show( bool s, bool instant )
 {
-    if ( tryGetValidVenueClient( instant ) )
-    {
-        // check if venue has changed in the meantime, if so update stuff
-        std::string oldName = currentVenue;
-        updateVenueName();
-
-        if ( oldName.compare( currentVenue ) != 0 )
-        {
-            updateExitMap();
-            updateVenueStreams();
-        }
-    }
-    else
+    // this works off the cached venue info, refreshing it in the background
+    // if it's old - if there isn't any yet, show once it's in
+    if ( s && !haveRefreshed )
     {
+        refresh( false );
+        pendingShow = true;
         return;
-        // tryGetValidVenueClient() will hide the object itself if it is shown &
-        // the venue client check fails
     }
+    pendingShow = false;
+
+    applyShow( s, instant );
+}
+
+void VenueClientController::applyShow( bool s, bool instant )
+{
+    // tryGetValidVenueClient() will hide the object itself if it is shown &
+    // the venue client check fails
+    if ( !tryGetValidVenueClient( instant ) )
+        return;
 
     // do nothing if there aren't any venues, otherwise state will get confusing
     // to the user (ie, shown with no exits, then venue move in AG, next ctrl-v
@@ -359,3 +470,10 @@ void VenueClientController::setSessionControl( SessionTreeControl* s )
 {
     sessionControl = s;
 }
+
+long VenueClientController::getTimeMS()
+{
+    timeval tv;
+    gettimeofday( &tv, NULL );
+    return ( tv.tv_sec * 1000L ) + ( tv.tv_usec / 1000L );
+}
@@ -26,8 +26,7 @@
 #include "VideoSource.h"
 #include "gravManager.h"
 #include "GLCanvas.h"
-#include "Group.h"
-#include "TreeControl.h"
+#include "FrameScheduler.h"
 #include "GLUtil.h"
 #include "gravUtil.h"
 
@@ -84,6 +83,8 @@ void VideoListener::vpmsession_source_created( VPMSession &session,
         }
 
         d->connectVideoProcessor(sink);
+        // so the frame latency stats can start from when frames are decoded
+        sink->addNewFrameCallback( &FrameScheduler::videoFrameDecoded, NULL );
 
         VideoSource* source = new VideoSource( &session, this, ssrc, sink, x,
 													y );
@@ -113,30 +114,19 @@ void VideoListener::vpmsession_source_deleted( VPMSession &session,
         uint32_t ssrc, const char *reason)
 {
     gravUtil::logVerbose( "VideoListener::deleting ssrc 0x%08x\n", ssrc );
-    std::vector<VideoSource*>::iterator si;
-    for ( si = grav->getSources()->begin();
-            si != grav->getSources()->end(); ++si )
-    {
-        if ( &session == (*si)->getSession() && (*si)->getssrc() == ssrc )
-        {
-            gravUtil::logVerbose( "VideoListener::found ssrc as source"
-                    " 0x%08x\n", (*si) );
-            sourceCount--;
-            updatePixelCount( -( (*si)->getVideoWidth() *
-                                 (*si)->getVideoHeight() ) );
-            grav->deleteSource( si );
-            return;
-        }
-    }
-    // seems to get a lot of "sources deleted but not in video sources list" on
-    // exit - may be that view-only clients are listed in the session. need to
-    // test more, but not that much of an issue
+
+    // this detaches the sink from the source right away, since it gets
+    // deleted after we return - the source is taken out on the next frame
+    if ( grav->removeSource( &session, ssrc ) )
+        sourceCount--;
 }
 
 void VideoListener::vpmsession_source_description( VPMSession &session,
         uint32_t ssrc )
 {
-  // Ignore
+    // names come from the SDES, so pick up changes right away rather than
+    // waiting for the periodic name update in draw
+    grav->renameSource( &session, ssrc );
 }
 
 void VideoListener::vpmsession_source_app( VPMSession &session,
@@ -147,58 +137,13 @@ void VideoListener::vpmsession_source_app( VPMSession &session,
 
     if ( appS.compare( "site" ) == 0 && grav->usingSiteIDGroups() )
     {
-        grav->lockSources();
-
         // vic sends 4 nulls at the end of the rtcp_app string for some
         // reason, so chop those off
         dataS = std::string( dataS, 0, 32 );
-        std::vector<VideoSource*>::iterator i = grav->getSources()->begin();
-
-        // sometimes, if groups are enabled by default, we can get RTCP APP
-        // before we get any sources added, resulting in a crash when we try
-        // and dereference the sources pointer - so skip this if we don't have
-        // any sources yet
-        if ( grav->getSources()->size() == 0 )
-        {
-            grav->unlockSources();
-            return;
-        }
-
-        while ( (*i)->getssrc() != ssrc )
-        {
-            ++i;
-            if ( i == grav->getSources()->end() )
-            {
-                grav->unlockSources();
-                return;
-            }
-        }
-
-        if ( !(*i)->isGrouped() )
-        {
-            Group* g;
-            std::map<std::string,Group*>::iterator mapi =
-                                     grav->getSiteIDGroups()->find(dataS);
-
-            if ( mapi == grav->getSiteIDGroups()->end() )
-                g = grav->createSiteIDGroup( dataS );
-            else
-                g = mapi->second;
-
-            (*i)->setSiteID( dataS );
-            g->add( *i );
-
-            // adding & removing will replace the object under its group
-            if ( grav->getTree() )
-            {
-                grav->getTree()->removeObject( (*i) );
-                grav->getTree()->addObject( (*i) );
-
-                grav->getTree()->updateObjectName( g );
-            }
-        }
 
-        grav->unlockSources();
+        // the grouping itself happens on the main thread - if the source
+        // isn't there (yet), it'll just get picked up on the next RTCP APP
+        grav->setSourceSiteID( &session, ssrc, dataS );
     }
 }
 
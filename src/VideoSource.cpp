@@ -25,8 +25,10 @@
 #include "VideoSource.h"
 #include "VideoListener.h"
 #include "GLUtil.h"
+#include "GLCanvas.h"
 #include "gravUtil.h"
 #include <cmath>
+#include <algorithm>
 
 #include <VPMedia/video/VPMVideoDecoder.h>
 
@@ -43,7 +45,10 @@ VideoSource::VideoSource( VPMSession* _session, VideoListener* l,
     texid = 0;
     aspect = 1.33f;
     useAlpha = false;
+    fadingIn = false;
     enableRendering = true;
+    staleTexture = false;
+    sinkMutex = mutex_create();
 }
 
 VideoSource::~VideoSource()
@@ -51,6 +56,7 @@ VideoSource::~VideoSource()
     // note that the buffer sink will be deleted when the decoder for the source
     // is (inside VPMedia), so that's why it isn't deleted here or in
     // videolistener
+    mutex_free( sinkMutex );
 
     // gl destructors
     glDeleteTextures( 1, &texid );
@@ -66,6 +72,48 @@ void VideoSource::draw()
     if ( borderColor.A < 0.01f )
         return;
 
+    float videoAlpha = borderColor.A;
+    if ( fadingIn )
+    {
+        if ( !borderColAnimating || destBColor.A < 0.01f )
+        {
+            fadingIn = false;
+            useAlpha = false;
+        }
+        else
+            videoAlpha = std::min( 1.0f, borderColor.A / destBColor.A );
+    }
+
+    // if the texture id hasn't been initialized yet, this must be the
+    // first draw call
+    init = (texid == 0);
+
+    // the sink can be taken away by the network thread at any point - see
+    // detachSink
+    mutex_lock( sinkMutex );
+    if ( videoSink == NULL )
+    {
+        mutex_unlock( sinkMutex );
+        return;
+    }
+
+    // allocate the buffer if it's the first time or if it's been resized -
+    // done even when off-screen, since the aspect ratio feeds into layouts
+    if ( init || vwidth != videoSink->getImageWidth() ||
+         vheight != videoSink->getImageHeight() )
+    {
+        resizeBuffer();
+    }
+
+    // if it's out of view or covered, leave the frame in the sink - the
+    // newest one will get uploaded when it's back
+    if ( culled )
+    {
+        staleTexture = true;
+        mutex_unlock( sinkMutex );
+        return;
+    }
+
     // set up our position
     glPushMatrix();
 
@@ -81,16 +129,6 @@ void VideoSource::draw()
 
     float s = 1.0;
     float t = 1.0;
-    // if the texture id hasn't been initialized yet, this must be the
-    // first draw call
-    init = (texid == 0);
-
-    // allocate the buffer if it's the first time or if it's been resized
-    if ( init || vwidth != videoSink->getImageWidth() ||
-         vheight != videoSink->getImageHeight() )
-    {
-        resizeBuffer();
-    }
 
     s = (float)vwidth/(float)tex_width;
     //if ( videoSink->getImageFormat() == VIDEO_FORMAT_YUV420 )
@@ -112,8 +150,12 @@ void VideoSource::draw()
     {
         videoSink->lockImage();
         // only bother doing a texture push if there's a new frame
-        if ( videoSink->haveNewFrameAvailable() )
+        if ( videoSink->haveNewFrameAvailable() || staleTexture )
         {
+            staleTexture = false;
+            GLCanvas* canvas = GLUtil::getInstance()->getCanvas();
+            if ( canvas != NULL )
+                canvas->getScheduler()->videoFrameUploaded();
             if ( videoSink->getImageFormat() == VIDEO_FORMAT_RGB24 )
             {
                 glTexSubImage2D( GL_TEXTURE_2D,
@@ -180,6 +222,7 @@ void VideoSource::draw()
         }
         videoSink->unlockImage();
     }
+    mutex_unlock( sinkMutex );
 
     // draw video texture, regardless of whether we just pushed something
     // new or not
@@ -191,14 +234,14 @@ void VideoSource::draw()
         if ( useAlpha )
         {
             glUniform1f( GLUtil::getInstance()->getYUV420alphaID(),
-                            borderColor.A );
+                            videoAlpha );
         }
     }
 
     // use alpha of border color for video if set
     if ( useAlpha )
     {
-        glColor4f( 1.0f, 1.0f, 1.0f, borderColor.A );
+        glColor4f( 1.0f, 1.0f, 1.0f, videoAlpha );
         glEnable( GL_BLEND );
         glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     }
@@ -398,8 +441,10 @@ bool VideoSource::updateName()
     {
         std::string latS = loc.substr( 0, pos );
         std::string lonS = loc.substr( pos+1 );
-        lat = strtod( latS.c_str(), NULL );
-        lon = strtod( lonS.c_str(), NULL );
+        float newLat = strtod( latS.c_str(), NULL );
+        float newLon = strtod( lonS.c_str(), NULL );
+        if ( newLat != lat || newLon != lon )
+            setLocation( newLat, newLon );
     }
 
     if ( nameChanged )
@@ -419,7 +464,12 @@ std::string VideoSource::getName()
 
 const char* VideoSource::getPayloadDesc()
 {
-    return videoSink->getVideoDecoder()->getDesc();
+    const char* desc = "";
+    mutex_lock( sinkMutex );
+    if ( videoSink != NULL )
+        desc = videoSink->getVideoDecoder()->getDesc();
+    mutex_unlock( sinkMutex );
+    return desc;
 }
 
 VPMSession* VideoSource::getSession()
@@ -530,8 +580,40 @@ bool VideoSource::getRendering()
     return enableRendering;
 }
 
+bool VideoSource::hasVideo()
+{
+    mutex_lock( sinkMutex );
+    bool video = videoSink != NULL && videoSink->getImageWidth() > 0;
+    mutex_unlock( sinkMutex );
+    return video;
+}
+
+void VideoSource::detachSink()
+{
+    // waits for a texture push in progress, if there is one
+    mutex_lock( sinkMutex );
+    videoSink = NULL;
+    mutex_unlock( sinkMutex );
+}
+
+bool VideoSource::isOpaque()
+{
+    if ( useAlpha || borderColor.A < 0.99f )
+        return false;
+
+    // nothing gets drawn in the middle once the sink's gone, so occlusion
+    // culling shouldn't hide what's behind it
+    mutex_lock( sinkMutex );
+    bool opaque = videoSink != NULL;
+    mutex_unlock( sinkMutex );
+    return opaque;
+}
+
 void VideoSource::show( bool s, bool instant )
 {
     RectangleBase::show( s, instant );
-    useAlpha = !s;
+    // when fading back in, keep blending until the fade's done rather than
+    // popping to full opacity straight away
+    fadingIn = s && !instant && animated;
+    useAlpha = !s || fadingIn;
 }
@@ -0,0 +1,115 @@
+/*
+ * @file VoiceActivityDetector.cpp
+ *
+ * Implementation of the level-based speech detector.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VoiceActivityDetector.h"
+
+#include <cmath>
+
+// the on threshold is the same as the old fixed audio focus trigger level
+const float VoiceActivityDetector::onThreshold = 0.01f;
+const float VoiceActivityDetector::offThreshold = 0.005f;
+const long VoiceActivityDetector::attackMS = 200;
+const long VoiceActivityDetector::releaseMS = 1500;
+const long VoiceActivityDetector::minHoldMS = 4000;
+const float VoiceActivityDetector::smoothingMS = 150.0f;
+
+VoiceActivityDetector::VoiceActivityDetector()
+{
+    reset();
+}
+
+void VoiceActivityDetector::reset()
+{
+    smoothed = 0.0f;
+    speaking = false;
+    haveTime = false;
+    lastTimeMS = 0;
+    aboveSinceMS = -1;
+    belowSinceMS = -1;
+    speakingSinceMS = 0;
+}
+
+bool VoiceActivityDetector::update( float level, long timeMS )
+{
+    // meters report negative values for "no data"
+    if ( level < 0.0f )
+        level = 0.0f;
+
+    // exponential smoothing (starting from silence), scaled by the time since
+    // the last update so the result doesn't depend on how often we get called
+    if ( haveTime )
+    {
+        float dt = (float)( timeMS - lastTimeMS );
+        if ( dt < 0.0f )
+            dt = 0.0f;
+        float alpha = 1.0f - expf( -dt / smoothingMS );
+        smoothed += alpha * ( level - smoothed );
+    }
+    haveTime = true;
+    lastTimeMS = timeMS;
+
+    if ( smoothed > onThreshold )
+    {
+        if ( aboveSinceMS < 0 )
+            aboveSinceMS = timeMS;
+    }
+    else
+        aboveSinceMS = -1;
+
+    if ( smoothed < offThreshold )
+    {
+        if ( belowSinceMS < 0 )
+            belowSinceMS = timeMS;
+    }
+    else
+        belowSinceMS = -1;
+
+    if ( !speaking && aboveSinceMS >= 0 &&
+            timeMS - aboveSinceMS >= attackMS )
+    {
+        speaking = true;
+        speakingSinceMS = timeMS;
+        return true;
+    }
+
+    if ( speaking && belowSinceMS >= 0 &&
+            timeMS - belowSinceMS >= releaseMS &&
+            timeMS - speakingSinceMS >= minHoldMS )
+    {
+        speaking = false;
+        return true;
+    }
+
+    return false;
+}
+
+bool VoiceActivityDetector::isSpeaking()
+{
+    return speaking;
+}
+
+float VoiceActivityDetector::getSmoothedLevel()
+{
+    return smoothed;
+}
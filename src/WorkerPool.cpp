@@ -0,0 +1,163 @@
+/*
+ * @file WorkerPool.cpp
+ *
+ * Implementation of the worker thread pool.
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool( int max )
+    : maxThreads( max )
+{
+    queueMutex = mutex_create();
+    activeThreads = 0;
+    pendingCount = 0;
+    running = true;
+}
+
+WorkerPool::~WorkerPool()
+{
+    running = false;
+    for ( unsigned int i = 0; i < threads.size(); i++ )
+        thread_join( threads[i] );
+
+    for ( unsigned int i = 0; i < queued.size(); i++ )
+        delete queued[i];
+    for ( unsigned int i = 0; i < finished.size(); i++ )
+        delete finished[i];
+
+    mutex_free( queueMutex );
+}
+
+void WorkerPool::push( WorkerJob* job )
+{
+    bool startThread = false;
+    mutex_lock( queueMutex );
+    queued.push_back( job );
+    pendingCount++;
+    if ( activeThreads < maxThreads )
+    {
+        activeThreads++;
+        startThread = true;
+    }
+    mutex_unlock( queueMutex );
+
+    if ( startThread )
+        threads.push_back( thread_start( threadMain, this ) );
+}
+
+bool WorkerPool::remove( WorkerJob* job )
+{
+    mutex_lock( queueMutex );
+    std::vector<WorkerJob*>::iterator it =
+            std::find( queued.begin(), queued.end(), job );
+    bool found = it != queued.end();
+    if ( found )
+    {
+        queued.erase( it );
+        pendingCount--;
+    }
+    mutex_unlock( queueMutex );
+    return found;
+}
+
+void WorkerPool::takeFinished( std::vector<WorkerJob*>& done )
+{
+    mutex_lock( queueMutex );
+    done.insert( done.end(), finished.begin(), finished.end() );
+    pendingCount -= finished.size();
+    finished.clear();
+    mutex_unlock( queueMutex );
+
+    reapThreads();
+}
+
+bool WorkerPool::hasFinished()
+{
+    mutex_lock( queueMutex );
+    bool ret = !finished.empty();
+    mutex_unlock( queueMutex );
+
+    // otherwise takeFinished wouldn't get the chance to clean up after them
+    if ( !ret )
+        reapThreads();
+    return ret;
+}
+
+int WorkerPool::getPendingCount()
+{
+    mutex_lock( queueMutex );
+    int pending = pendingCount;
+    mutex_unlock( queueMutex );
+    return pending;
+}
+
+void* WorkerPool::threadMain( void* args )
+{
+    WorkerPool* pool = (WorkerPool*)args;
+
+    while ( pool->running )
+    {
+        mutex_lock( pool->queueMutex );
+        if ( pool->queued.empty() )
+        {
+            // decided under the lock, so push either sees this thread as
+            // gone & starts another, or queued the job before this
+            pool->activeThreads--;
+            mutex_unlock( pool->queueMutex );
+            return NULL;
+        }
+        WorkerJob* job = pool->queued.front();
+        pool->queued.erase( pool->queued.begin() );
+        mutex_unlock( pool->queueMutex );
+
+        job->run();
+
+        mutex_lock( pool->queueMutex );
+        pool->finished.push_back( job );
+        mutex_unlock( pool->queueMutex );
+    }
+
+    mutex_lock( pool->queueMutex );
+    pool->activeThreads--;
+    mutex_unlock( pool->queueMutex );
+    return NULL;
+}
+
+void WorkerPool::reapThreads()
+{
+    if ( threads.empty() )
+        return;
+
+    mutex_lock( queueMutex );
+    bool idle = activeThreads == 0;
+    mutex_unlock( queueMutex );
+
+    // they've all returned (or are just about to), so this won't block
+    if ( idle )
+    {
+        for ( unsigned int i = 0; i < threads.size(); i++ )
+            thread_join( threads[i] );
+        threads.clear();
+    }
+}
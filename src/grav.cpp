@@ -36,15 +36,24 @@
 #include "VideoSource.h"
 #include "VideoListener.h"
 #include "AudioManager.h"
+#include "AudioMeterDecoder.h"
 #include "Frame.h"
 #include "SideFrame.h"
 #include "Timers.h"
 #include "VenueClientController.h"
+#include "LayoutBenchmark.h"
+#include "MeterBenchmark.h"
+#include "TextureCache.h"
+#include "RenderThread.h"
 
 #include <VPMedia/VPMLog.h>
 #include <VPMedia/VPMPayloadDecoderFactory.h>
 #include <VPMedia/VPMSessionFactory.h>
 
+#if defined(__WXGTK__)
+#include <X11/Xlib.h>
+#endif
+
 IMPLEMENT_APP( gravApp )
 
 BEGIN_EVENT_TABLE(gravApp, wxApp)
@@ -55,8 +64,32 @@ END_EVENT_TABLE(); // this ; is not necessary, just makes eclipse's syntax
 bool gravApp::threadDebug = false;
 int gravApp::threadCounter = 0;
 
+bool gravApp::Initialize( int& argc, wxChar** argv )
+{
+#if defined(__WXGTK__)
+    // this has to be the first Xlib call if more than one thread is going to
+    // use it, which is before the command line gets parsed properly
+    for ( int i = 1; i < argc; i++ )
+    {
+        wxString arg( argv[i] );
+        if ( arg == wxT("-rt") || arg == wxT("--render-thread") )
+        {
+            XInitThreads();
+            break;
+        }
+    }
+#endif
+    return wxApp::Initialize( argc, argv );
+}
+
 bool gravApp::OnInit()
 {
+    // for the startup phase timings in the verbose log
+    wxStopWatch startupTime;
+    renderThread = NULL;
+    benchmarkOnly = false;
+    exitCode = 0;
+
     grav = new gravManager();
     // defaults - can be changed by command line
     windowWidth = 900; windowHeight = 550;
@@ -86,6 +119,24 @@ bool gravApp::OnInit()
     if ( VPMverbose )
         vpmlog_set_log_level( VPMLOG_LEVEL_DEBUG );
 
+    // layout benchmark doesn't need any GUI or GL, so just run it & quit -
+    // returning true so the result makes it to the exit status (see OnRun)
+    if ( runLayoutBenchmark )
+    {
+        LayoutBenchmark bench;
+        exitCode = bench.run( layoutBenchmarkSnapshot ) ? 0 : 1;
+        benchmarkOnly = true;
+        return true;
+    }
+
+    if ( runMeterBenchmark )
+    {
+        MeterBenchmark bench;
+        exitCode = bench.run() ? 0 : 1;
+        benchmarkOnly = true;
+        return true;
+    }
+
     // GUI setup
     mainFrame = new Frame( (wxFrame*)NULL, -1, _("grav"),
                         wxPoint( startX, startY ),
@@ -117,6 +168,7 @@ bool gravApp::OnInit()
 
     canvas = new GLCanvas( mainFrame, grav, attribList,
                             mainFrame->GetClientSize() );
+    canvas->getScheduler()->setInterval( timerIntervalUS );
     sourceTree = new TreeControl( treeNotebook );
     sourceTree->setSourceManager( grav );
     sessionTree = new SessionTreeControl( treeNotebook );
@@ -133,6 +185,9 @@ bool gravApp::OnInit()
     // put the main frame on top
     mainFrame->Raise();
 
+    gravUtil::logVerbose( "grav::startup: GUI created at %ld ms\n",
+                          startupTime.Time() );
+
     // log here instead of in handleargs, see above/in handleargs
     // (handleargs is where the timer intervals actually get set)
     // might be that we can't do logging until main window is created
@@ -160,6 +215,7 @@ bool gravApp::OnInit()
     // since these bools are used in glinit, set them before glinit
     GLUtil::getInstance()->setShaderEnable( enableShaders );
     GLUtil::getInstance()->setBufferFontUsage( bufferFont );
+    GLUtil::getInstance()->setVSync( useVSync );
 
     // initialize GL stuff (+ shaders) needs to be done AFTER attriblist is
     // used in making the canvas
@@ -172,9 +228,15 @@ bool gravApp::OnInit()
         return false;
     }
 
+    gravUtil::logVerbose( "grav::startup: GL initialized at %ld ms\n",
+                          startupTime.Time() );
+
+    TextureCache::init( useTextureCache );
     GLUtil::getInstance()->addTexture( "border", "border.png" );
     GLUtil::getInstance()->addTexture( "circle", "circle.png" );
-    GLUtil::getInstance()->addTexture( "earth", "earth.png" );
+    // this is the big one, so don't hold up startup for it - the earth is
+    // drawn plain until it's ready
+    GLUtil::getInstance()->addTextureAsync( "earth", "earth.png", true );
 
     GLUtil::getInstance()->setCanvas( canvas );
 
@@ -200,11 +262,14 @@ bool gravApp::OnInit()
     canvas->SetFocus();
     canvas->setTimer( timer );
 
+    // python itself is started on first use, on its own thread
     if ( !disablePython )
     {
         venueClientController = new VenueClientController( 0.0f, 0.0f, grav );
         venueClientController->setSessionControl( sessionTree );
     }
+    gravUtil::logVerbose( "grav::startup: scene set up at %ld ms\n",
+                          startupTime.Time() );
 
     grav->setEarth( earth );
     grav->setInput( input );
@@ -244,8 +309,8 @@ bool gravApp::OnInit()
 
     if ( getAGVenueStreams && !disablePython )
     {
-        venueClientController->updateVenueStreams();
-        venueClientController->addAllVenueStreams();
+        // added once they come back from the venue client
+        venueClientController->updateVenueStreams( true );
     }
 
     sessionTree->setTimerInterval( rotateIntervalMS );
@@ -255,18 +320,58 @@ bool gravApp::OnInit()
         sessionTree->rotateVideoSessions();
     }
 
-    gravUtil::logVerbose( "grav::init function complete\n" );
+    // last, since the GL context goes over to the render thread here
+    if ( useRenderThread && !usingThreads )
+    {
+        gravUtil::logWarning( "grav::OnInit: render thread needs network "
+                              "threading on, drawing on the main thread\n" );
+    }
+    else if ( useRenderThread )
+    {
+        renderThread = new RenderThread( canvas, grav, input );
+        if ( !renderThread->start() )
+        {
+            delete renderThread;
+            renderThread = NULL;
+        }
+    }
+
+    gravUtil::logVerbose( "grav::init function complete (%ld ms)\n",
+                          startupTime.Time() );
     return true;
 }
 
+int gravApp::OnRun()
+{
+    if ( benchmarkOnly )
+        return exitCode;
+    return wxApp::OnRun();
+}
+
 int gravApp::OnExit()
 {
+    if ( benchmarkOnly )
+    {
+        delete grav;
+        return exitCode;
+    }
+
     gravUtil::logVerbose( "grav::Exiting...\n" );
     // TODO: test this stuff more, valgrind etc
 
+    // (normally already stopped when the main frame closed)
+    if ( renderThread != NULL )
+    {
+        renderThread->stop();
+        delete renderThread;
+    }
+
     if ( usingThreads )
     {
         threadRunning = false;
+        // so the network thread doesn't wait on a draw that isn't coming if
+        // it's in the middle of removing a source
+        grav->setThreads( false );
         thread_join( VPMthread );
     }
 
@@ -307,30 +412,38 @@ void gravApp::idleHandler( wxIdleEvent& evt )
     }
 
     if ( !usingThreads )
+    {
         sessionManager->iterateSessions();
+        audioSessionListener->publishLevels();
+    }
 
-    if ( timerIntervalUS > 0 )
+    // the render thread draws on its own - all that's left for this thread
+    // is the part of each frame that updates the GUI
+    if ( renderThread != NULL )
     {
-        // this is the method for rendering on idle, with a limiter based on the
-        // timer interval
-        unsigned long time = (unsigned long)timer->getTiming();
-        if ( time > (unsigned long)timerIntervalUS )
-        {
-            //gravUtil::logVerbose( "%lu\n", time );
-            canvas->draw();
-            timer->resetTiming();
-        }
-        else
-        {
-            wxMilliSleep( 1 );
-        }
+        // (these lock the scene themselves, only as long as they need to)
+        grav->updateSessions();
+        sourceTree->startDeferredSync();
+
+        wxMilliSleep( 5 );
+        evt.RequestMore();
+        return;
     }
-    // otherwise (if fps value isn't set) just constantly draw - if vsync is on,
-    // will be limited to vsync
-    else if ( timerIntervalUS == 0 )
+
+    // render on idle, paced by the scheduler if there's a framerate set -
+    // otherwise (if fps value isn't set) it's always due, so this just
+    // constantly draws, limited by vsync if it's on
+    FrameScheduler* scheduler = canvas->getScheduler();
+    if ( scheduler->isFrameDue() )
     {
         canvas->draw();
     }
+    else
+    {
+        // sleep towards the deadline, but wake up often enough to keep
+        // handling events (and the network, if not threaded) in between
+        scheduler->waitForFrame( 4000 );
+    }
 
     evt.RequestMore();
 }
@@ -338,6 +451,9 @@ void gravApp::idleHandler( wxIdleEvent& evt )
 void gravApp::iterateSessions()
 {
     bool haveSessions = sessionManager->iterateSessions();
+    // audio levels are read by the main thread, so hand them over now that
+    // the meters are up to date
+    audioSessionListener->publishLevels();
 
     // if there are no sessions, sleep so as not to spin and consume CPU
     // needlessly
@@ -385,6 +501,8 @@ bool gravApp::handleArgs()
     disablePython = parser.Found( _("no-python") );
 
     enableShaders = parser.Found( _("enable-shaders") );
+    useVSync = !parser.Found( _("no-vsync") );
+    useRenderThread = parser.Found( _("render-thread") );
 
     bufferFont = parser.Found( _("use-buffer-font") );
 
@@ -394,6 +512,18 @@ bool gravApp::handleArgs()
 
     getAGVenueStreams = parser.Found( _("get-ag-venue-streams") );
 
+    runLayoutBenchmark = parser.Found( _("layout-benchmark") );
+    wxString snapshotWX;
+    if ( parser.Found( _("layout-benchmark-snapshot"), &snapshotWX ) )
+    {
+        runLayoutBenchmark = true;
+        layoutBenchmarkSnapshot = std::string( (char*)snapshotWX.char_str() );
+    }
+
+    runMeterBenchmark = parser.Found( _("meter-benchmark") );
+
+    useTextureCache = !parser.Found( _("no-texture-cache") );
+
     grav->setAutoFocusRotate( parser.Found( _("automatic") ) );
 
     grav->setGridAuto( parser.Found( _("gridauto") ) );
@@ -488,6 +618,13 @@ void gravApp::mapRTP()
     decoderFactory->mapPayloadType( 115, "L16_32k_stereo" );
     decoderFactory->mapPayloadType( 116, "L16_48k_mono" );
     decoderFactory->mapPayloadType( 117, "L16_48k_stereo" );
+
+    // VPMedia only has linear16 audio decoders, so for other common audio
+    // formats use ones that just measure levels for speaker detection
+    AudioMeterDecoder::registerDecoders( decoderFactory );
+    decoderFactory->mapPayloadType( 0, "PCMU" );
+    decoderFactory->mapPayloadType( 3, "GSM" );
+    decoderFactory->mapPayloadType( 8, "PCMA" );
 }
 
 void* gravApp::threadTest( void* args )
@@ -45,6 +45,11 @@
 #include "VideoListener.h"
 #include "TreeControl.h"
 #include "LayoutManager.h"
+#include "IncrementalGridLayout.h"
+#include "LayoutWorker.h"
+#include "SceneCommandQueue.h"
+#include "LockStats.h"
+#include "DrawOrder.h"
 #include "VenueClientController.h"
 #include "SessionManager.h"
 #include "Camera.h"
@@ -54,6 +59,18 @@
 
 #include <VPMedia/random_helper.h>
 
+#include <sys/time.h>
+
+static long getTimeUS()
+{
+    struct timeval t;
+    gettimeofday( &t, NULL );
+    return t.tv_sec * 1000000L + t.tv_usec;
+}
+
+// set on the render thread, if there is one - see claimRenderThread
+static __thread bool onRenderThread = false;
+
 gravManager::gravManager()
 {
     windowWidth = 0; windowHeight = 0; // this should be set immediately
@@ -62,21 +79,27 @@ gravManager::gravManager()
     drawCounter = 0;
     autoCounter = 0;
     intersectCounter = 0;
+    sessionCounter = 0;
 
     origCamPoint = Point( 0.0f, 0.0f, 9.0f );
     Point lookat( 0.0f, 0.0f, -25.0f );
     cam = new Camera( origCamPoint, lookat );
+    // objects that are off-screen (ie, zoomed in) skip drawing
+    RectangleBase::setCullFrustum( cam->getFrustum() );
+    lastCulledCount = 0;
+    lastOccludedCount = 0;
 
     sources = new std::vector<VideoSource*>();
-    drawnObjects = new std::vector<RectangleBase*>();
+    drawnObjects = new DrawOrder();
     selectedObjects = new std::vector<RectangleBase*>();
     siteIDGroups = new std::map<std::string,Group*>();
 
-    objectsToDelete = new std::vector<RectangleBase*>();
-    objectsToAddToTree = new std::vector<RectangleBase*>();
-    objectsToRemoveFromTree = new std::vector<RectangleBase*>();
+    commands = new SceneCommandQueue();
+    sinkMutex = mutex_create();
 
     layouts = new LayoutManager();
+    gridLayout = new IncrementalGridLayout();
+    layoutWorker = new LayoutWorker();
 
     screenRectFull.setName( "screen rectangle full" );
     screenRectFull.setAnimation( false );
@@ -104,7 +127,7 @@ gravManager::gravManager()
 
     runway = new Runway( -10.0f, 0.0f );
     runway->setScale( 2.0f, 10.0f );
-    drawnObjects->push_back( runway );
+    drawnObjects->add( runway );
 
     headerString = "";
     useHeader = false;
@@ -117,11 +140,18 @@ gravManager::gravManager()
     autoFocusRotate = false;
 
     audioEnabled = false;
-    audioFocusTrigger = false;
+    lastSpeakerChange = 0;
     audio = NULL;
 
     sourceMutex = mutex_create();
     lockCount = 0;
+    lockStartUS = 0;
+    lockStats = new LockStats();
+
+    renderThreaded = false;
+    sceneMutex = mutex_create();
+    sceneLockDepth = 0;
+    sceneWaiters = 0;
 
     graphicsDebugView = false;
     pixelCount = 0;
@@ -131,7 +161,20 @@ gravManager::gravManager()
 
 gravManager::~gravManager()
 {
-    doDelayedDelete();
+    // anything still queued at this point is from sessions shutting down -
+    // the listener & tree may be gone already, so just throw it out
+    SceneCommand* cmd = commands->takeAll();
+    while ( cmd != NULL )
+    {
+        SceneCommand* next = cmd->next;
+        if ( cmd->type == SceneCommand::ADD_SOURCE )
+            delete cmd->source;
+        delete cmd;
+        cmd = next;
+    }
+
+    for ( unsigned int i = 0; i < retiredSources.size(); i++ )
+        delete retiredSources[i];
 
     delete sources;
     delete drawnObjects;
@@ -139,16 +182,23 @@ gravManager::~gravManager()
     delete siteIDGroups;
 
     delete layouts;
+    delete gridLayout;
+    delete layoutWorker;
 
     delete runway;
 
+    RectangleBase::setCullFrustum( NULL );
     delete cam;
 
-    delete objectsToDelete;
-    delete objectsToAddToTree;
-    delete objectsToRemoveFromTree;
+    delete commands;
+    mutex_free( sinkMutex );
 
     mutex_free( sourceMutex );
+    mutex_free( sceneMutex );
+
+    if ( lockStats->getNumLocks() > 0 )
+        lockStats->log( "sources" );
+    delete lockStats;
 }
 
 void gravManager::draw()
@@ -158,6 +208,10 @@ void gravManager::draw()
 
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
+    // pick up anything that finished loading in the background
+    if ( GLUtil::getInstance()->updateTextures() > 0 )
+        earth->updateTexture();
+
     cam->animateValues();
     cam->doGLLookat();
 
@@ -174,14 +228,11 @@ void gravManager::draw()
         gluSphere( sphereQuad, overalllevel * 30.0f + 0.5f, 50, 50 );
     }*/
 
-    // set it to update names only every 30 frames
+    // set it to update names only every 30 frames (audio source names are
+    // updated by AudioManager itself as SDES comes in)
     bool updateNames = false;
     if ( drawCounter == 0 )
-    {
         updateNames = true;
-        if ( audioAvailable() )
-            audio->updateNames();
-    }
 
     // polygon offset to fix z-fighting of coplanar polygons (videos)
     // disabled, since making the depth buffer read-only in some area takes
@@ -196,82 +247,89 @@ void gravManager::draw()
 
     lockSources();
 
+    // add/remove/etc sources according to what came in from the network since
+    // the last frame
+    processCommands();
+
+    // and delete anything that was taken out of the scene from the GUI thread
+    for ( unsigned int i = 0; i < retiredSources.size(); i++ )
+        delete retiredSources[i];
+    retiredSources.clear();
+
+    // move/resize objects according to any layouts that finished since the
+    // last frame
+    layoutWorker->applyResults();
+
     // periodically automatically rearrange if on automatic - take last object
     // and put it in center
     if ( autoCounter == 0 && getMovableObjects().size() > 0 && autoFocusRotate )
     {
         outerObjs = getMovableObjects();
-        innerObjs = std::vector<RectangleBase*>( outerObjs.begin(),
-                                                    outerObjs.begin()+1 );
-        outerObjs.erase( outerObjs.begin() );
-
-        std::map<std::string, std::vector<RectangleBase*> > data = \
-            std::map<std::string, std::vector<RectangleBase*> >();
-        data["inners"] = innerObjs;
-        data["outers"] = outerObjs;
-        layouts->arrange( "aspectFocus", getScreenRect(), RectangleBase(),
-                            data );
+        ObjectSpan movable( outerObjs );
+        layoutWorker->request( ASPECTFOCUS_LAYOUT, getScreenRect(),
+                               RectangleBase(),
+                               movable.sub( 1, movable.size() - 1 ),
+                               movable.sub( 0, 1 ) );
 
-        moveToTop( innerObjs[0] );
+        moveToTop( movable[0] );
 
         outerObjs.clear();
-        innerObjs.clear();
     }
 
-    // add objects to tree that need to be added - similar to delete, tree is
-    // modified on the main thread (in other WX places) so
-    if ( objectsToAddToTree->size() > 0 && tree != NULL )
-    {
-        for ( unsigned int i = 0; i < objectsToAddToTree->size(); i++ )
-        {
-            tree->addObject( (*objectsToAddToTree)[i] );
-        }
-        objectsToAddToTree->clear();
-    }
-    // same for remove
-    if ( objectsToRemoveFromTree->size() > 0 && tree != NULL )
-    {
-        for ( unsigned int i = 0; i < objectsToRemoveFromTree->size(); i++ )
-        {
-            tree->removeObject( (*objectsToRemoveFromTree)[i] );
-        }
-        objectsToRemoveFromTree->clear();
-    }
-    // delete sources that need to be deleted - see deleteSource for the reason
-    doDelayedDelete();
+    // take this frame's snapshot of what to draw and let go of the lock -
+    // everything below until the focus/runway checks only reads the lists.
+    // objects are only ever deleted on this thread (or the GUI thread with
+    // the scene locked), so everything in the snapshot stays valid for the
+    // rest of the frame
+    const std::vector<RectangleBase*>& drawList = drawnObjects->getList();
+    renderObjects.assign( drawList.begin(), drawList.end() );
+    renderSelected.assign( selectedObjects->begin(), selectedObjects->end() );
+
+    unlockSources();
+
+    updateOcclusion();
 
     // draw point on geographical position, selected ones on top (and bigger)
-    for ( si = drawnObjects->begin(); si != drawnObjects->end(); si++ )
+    for ( si = renderObjects.begin(); si != renderObjects.end(); si++ )
     {
-        RGBAColor col = (*si)->getColor();
-        glColor4f( col.R, col.G, col.B, col.A );
         if ( !(*si)->isGrouped() && !(*si)->isSelected() )
         {
-            //drawCurvedEarthLine( (*si)->getLat(), (*si)->getLon(),
-            //                    (*si)->getX(), (*si)->getY(), (*si)->getZ() );
-            drawEarthPoint( (*si)->getLat(), (*si)->getLon(), 3.0f );
+            //addCurvedEarthLine( (*si), earthLines );
+            addEarthPoint( (*si), earthPoints );
         }
     }
-    for ( si = selectedObjects->begin(); si != selectedObjects->end(); si++ )
+    for ( si = renderSelected.begin(); si != renderSelected.end(); si++ )
     {
-        RGBAColor col = (*si)->getColor();
-        glColor4f( col.R, col.G, col.B, col.A );
         if ( !(*si)->isGrouped() )
         {
-            //drawCurvedEarthLine( (*si)->getLat(), (*si)->getLon(),
-            //                    (*si)->getX(), (*si)->getY(), (*si)->getZ() );
-            drawEarthPoint( (*si)->getLat(), (*si)->getLon(), 6.0f );
+            //addCurvedEarthLine( (*si), earthLines );
+            addEarthPoint( (*si), selectedEarthPoints );
         }
     }
+    //drawEarthBatch( earthLines, GL_LINES, 2.0f );
+    drawEarthBatch( earthPoints, GL_POINTS, 3.0f );
+    drawEarthBatch( selectedEarthPoints, GL_POINTS, 6.0f );
 
-    earth->draw();
+    earth->draw( cam->getCenter(), windowWidth, windowHeight );
 
     // this makes the depth buffer read-only for this bit - this prevents
     // z-fighting on the videos which are coplanar
     glDepthMask( GL_FALSE );
 
+    // only sort objects into speakers & non-speakers for the audio focus if
+    // the set of people talking actually changed since we last did - the
+    // count is kept from here, so a change during the frame gets picked up
+    // next time
+    bool checkSpeakers = false;
+    if ( audioAvailable() && drawCounter == 0 )
+    {
+        unsigned int speakerChange = audio->getSpeakerChangeCount();
+        checkSpeakers = speakerChange != lastSpeakerChange;
+        lastSpeakerChange = speakerChange;
+    }
+
     // iterate through all objects to be drawn, and draw
-    for ( si = drawnObjects->begin(); si != drawnObjects->end(); si++ )
+    for ( si = renderObjects.begin(); si != renderObjects.end(); si++ )
     {
         // do things we only want to do every X frames,
         // like updating the name
@@ -287,34 +345,27 @@ void gravManager::draw()
         // drawing their members
         if ( !(*si)->isGrouped() )
         {
-            // set the audio effect level on the drawcounter, if audio is
-            // enabled, and if it's selectable (excludes runway)
+            // sort into speakers/non-speakers if audio is enabled, and if
+            // it's selectable (excludes runway)
             // TODO maybe change this if meaning of selectable changes
-            if ( audioAvailable() && drawCounter == 0 && (*si)->isSelectable() )
+            if ( checkSpeakers && (*si)->isSelectable() )
             {
-                // had a really bizarre bug here - if uninitialized, would hit
-                // > 0.01f check and succeed later if object was selected. what?
-                float level = 0.0f;
+                bool speaking = false;
                 // if source has siteID, send that (and tell audiomanager to
                 // only check siteIDs), if not, use cname if available
                 if ( (*si)->getSiteID().compare("") != 0 )
                 {
-                    level = audio->getLevel( (*si)->getSiteID(), true, false );
+                    speaking = audio->isSpeaking( (*si)->getSiteID(), false );
                 }
                 else if ( (*si)->getAltName().compare("") != 0 )
                 {
-                    level = audio->getLevel( (*si)->getAltName(), true, true );
+                    speaking = audio->isSpeaking( (*si)->getAltName(), true );
                 }
 
-                if ( level > 0.01f )
-                {
+                if ( speaking )
                     innerObjs.push_back( (*si) );
-                    audioFocusTrigger = true;
-                }
                 else
-                {
                     outerObjs.push_back( (*si) );
-                }
             }
             (*si)->draw();
         }
@@ -324,18 +375,30 @@ void gravManager::draw()
         }
     }
 
-    // do the audio focus if it triggered
-    if ( audioAvailable() )
+    Frustum* frustum = cam->getFrustum();
+    if ( frustum->getCulledCount() != lastCulledCount )
     {
-        if ( audioFocusTrigger )
+        lastCulledCount = frustum->getCulledCount();
+        gravUtil::logVerbose( "gravManager::draw: %i of %i objects culled\n",
+                              lastCulledCount, frustum->getTestedCount() );
+    }
+
+    // back under the lock for anything that changes the lists
+    lockSources();
+
+    // do the audio focus if the speakers changed - if everyone just stopped
+    // talking, leave the last speakers in focus
+    if ( checkSpeakers )
+    {
+        // compare as sets (sorted by pointer), but lay out in draw order so
+        // speakers don't land in arbitrary spots
+        std::vector<RectangleBase*> speakers( innerObjs );
+        std::sort( speakers.begin(), speakers.end() );
+        if ( !innerObjs.empty() && speakers != focusedSpeakers )
         {
-            std::map<std::string, std::vector<RectangleBase*> > data = \
-                std::map<std::string, std::vector<RectangleBase*> >();
-            data["inners"] = innerObjs;
-            data["outers"] = outerObjs;
-            layouts->arrange( "aspectFocus", getScreenRect(), RectangleBase(),
-                                data );
-            audioFocusTrigger = false;
+            layoutWorker->request( ASPECTFOCUS_LAYOUT, getScreenRect(),
+                                   RectangleBase(), outerObjs, innerObjs );
+            focusedSpeakers.swap( speakers );
         }
 
         outerObjs.clear();
@@ -366,12 +429,9 @@ void gravManager::draw()
 
     unlockSources();
 
-    // check session manager for moved session entry objects & shift if
-    // necessary - this needs to be outside the lock() since a shift might
-    // trigger a session disable, which may delete a video which needs to lock
-    // on its own (ie, we're not doing reentrant mutexes)
-    if ( intersectCounter == 0 && sessionManager->getColor().A > 0.01f )
-        sessionManager->checkGUISessionShift();
+    // with a render thread, the GUI thread does this instead
+    if ( !renderThreaded )
+        updateSessions();
 
     // draw the click-and-drag selection box
     if ( holdCounter > 1 && drawSelectionBox )
@@ -440,12 +500,18 @@ void gravManager::draw()
         glTranslatef( 0.0f, screenRectFull.getUBound() * 0.9f, 0.0f );
         float debugScale = textScale / 2.5f;
         glScalef( debugScale, debugScale, debugScale );
-        char text[100];
+        FrameScheduler* scheduler = canvas->getScheduler();
+        char text[256];
         sprintf( text,
                 "Draw time: %3ld  Non-draw time: %3ld  Pixel count: %8ld "
-                "FPS: %2.2f",
+                "FPS: %2.2f  Jitter: %5ldus  Latency: %6ldus  Vsync: %s  "
+                "Lock hold p99: %6ldus max: %6ldus",
                 canvas->getDrawTime(), canvas->getNonDrawTime(),
-                videoListener->getPixelCount(), canvas->getFPS() );
+                videoListener->getPixelCount(), canvas->getFPS(),
+                scheduler->getJitterUS(), scheduler->getLatencyUS(),
+                GLUtil::getInstance()->isVSyncEnabled() ? "on" : "off",
+                lockStats->getHoldPercentile( 0.99f ),
+                lockStats->getMaxHold() );
         GLUtil::getInstance()->getMainFont()->Render( text );
 
         glPopMatrix();
@@ -468,6 +534,105 @@ void gravManager::draw()
     autoCounter = ( autoCounter + 1 ) % 900;
 }
 
+void gravManager::updateSessions()
+{
+    // check session manager for moved session entry objects & shift if
+    // necessary - this needs to be outside the source lock since a shift
+    // might trigger a session disable, which may delete a video which needs
+    // to lock on its own (ie, we're not doing reentrant mutexes)
+    // with a render thread this runs on the GUI thread, so the scene is only
+    // locked around what needs it rather than the whole thing - the session
+    // functions lock the scene themselves (through lockSessions) when they
+    // actually have something to change
+    if ( sessionCounter == 0 && sessionManager->getColor().A > 0.01f )
+    {
+        lockScene();
+        sessionManager->checkGUISessionShift();
+        unlockScene();
+    }
+    sessionCounter = ( sessionCounter + 1 ) % 20;
+
+    // same goes for clicks on session entries, sessions that finished
+    // starting & rotation switches
+    sessionManager->applyPendingActions();
+    sessionManager->finishSessionInits();
+    sessionManager->updateRotation();
+    // and results from the venue client
+    if ( venueClientController != NULL )
+        venueClientController->checkRequests();
+}
+
+void gravManager::updateOcclusion()
+{
+    // opaque videos drawn above the current object, going down from the top
+    std::vector<VideoSource*> occluders;
+    int occludedCount = 0;
+
+    for ( int i = (int)renderObjects.size() - 1; i >= 0; i-- )
+    {
+        RectangleBase* obj = renderObjects[i];
+        // grouped objects are drawn with their group, so they get checked
+        // below at the group's place in the order
+        if ( obj->isGrouped() )
+            continue;
+
+        bool covered = coveredBy( obj, occluders );
+        obj->setOccluded( covered );
+        if ( covered )
+            occludedCount++;
+
+        Group* g = dynamic_cast<Group*>( obj );
+        if ( g != NULL )
+        {
+            std::vector<RectangleBase*>::iterator mi;
+            for ( mi = g->getBeginIterator(); mi != g->getEndIterator(); ++mi )
+            {
+                bool memberCovered = covered || coveredBy( *mi, occluders );
+                (*mi)->setOccluded( memberCovered );
+                if ( memberCovered )
+                    occludedCount++;
+            }
+        }
+
+        VideoSource* s = dynamic_cast<VideoSource*>( obj );
+        if ( !covered && s != NULL && s->isOpaque() && !s->isMoving() &&
+                occluders.size() < maxOccluders )
+            occluders.push_back( s );
+    }
+
+    if ( occludedCount != lastOccludedCount )
+    {
+        lastOccludedCount = occludedCount;
+        gravUtil::logVerbose( "gravManager::updateOcclusion: %i objects "
+                              "occluded\n", occludedCount );
+    }
+}
+
+bool gravManager::coveredBy( RectangleBase* obj,
+                             const std::vector<VideoSource*>& occluders )
+{
+    if ( occluders.empty() || obj->isMoving() )
+        return false;
+
+    float halfWidth, halfHeight;
+    obj->getDrawExtent( halfWidth, halfHeight );
+    float L = obj->getX() - halfWidth;
+    float R = obj->getX() + halfWidth;
+    float U = obj->getY() + halfHeight;
+    float D = obj->getY() - halfHeight;
+
+    // only the video itself is opaque (not the border), so that's what
+    // has to cover everything
+    for ( unsigned int i = 0; i < occluders.size(); i++ )
+    {
+        VideoSource* o = occluders[i];
+        if ( L >= o->getLBound() && R <= o->getRBound() &&
+                U <= o->getUBound() && D >= o->getDBound() )
+            return true;
+    }
+    return false;
+}
+
 void gravManager::clearSelected()
 {
     for ( std::vector<RectangleBase*>::iterator sli = selectedObjects->begin();
@@ -493,10 +658,10 @@ void gravManager::ungroupAll()
             // to the tree properly when the group is removed from the tree
             g->removeAll();
             removeFromLists( g );
-            objectsToDelete->push_back( g );
 
-            gravUtil::logVerbose( "gravManager::ungroupAll: group %s set to be "
-                    "deleted on draw\n", g->getName().c_str() );
+            gravUtil::logVerbose( "gravManager::ungroupAll: deleting group "
+                    "%s\n", g->getName().c_str() );
+            delete g;
         }
     }
     siteIDGroups->clear();
@@ -510,7 +675,7 @@ void gravManager::addTestObject()
     lockSources();
 
     RectangleBase* obj = new RectangleBase( 0.0f, 0.0f );
-    drawnObjects->push_back( obj );
+    drawnObjects->add( obj );
     bool useRandName = false;
     if ( useRandName )
     {
@@ -564,60 +729,51 @@ void gravManager::moveToTop( RectangleBase* object, bool checkGrouping )
 {
     if ( object == NULL )
     {
-        gravUtil::logError( "gravManager::moveToTop: object %s is NULL\n",
-                            object->getName().c_str() );
+        gravUtil::logError( "gravManager::moveToTop: object is NULL\n" );
         return;
     }
 
-    std::vector<RectangleBase*>::iterator i = drawnObjects->begin();
-    while ( i != drawnObjects->end() && (*i) != object ) ++i;
-    if ( i == drawnObjects->end() )
+    if ( !drawnObjects->contains( object ) )
     {
         gravUtil::logError( "gravManager::moveToTop: object %s not found in "
                             "draw list\n", object->getName().c_str() );
         return;
     }
-    moveToTop( i, checkGrouping );
-}
-
-/*
- * Note this is NOT thread-safe, lockSources() should be called around any calls
- * to this.
- */
-void gravManager::moveToTop( std::vector<RectangleBase*>::iterator i,
-                                bool checkGrouping )
-{
-    RectangleBase* temp = (*i);
-    RectangleBase* orig = temp;
 
     // find highest group in the chain, to move up group members from the top
     // of the chain
+    RectangleBase* temp = object;
     while ( checkGrouping && temp->isGrouped() )
         temp = temp->getGroup();
 
-    // do this to properly find iterator position, since i != temp now
-    if ( temp != orig )
-        moveToTop( temp, checkGrouping );
-    else
+    if ( temp != object )
     {
-        drawnObjects->erase( i );
-        drawnObjects->push_back( temp );
+        moveToTop( temp, checkGrouping );
+        return;
+    }
 
-        if ( temp->isGroup() )
-        {
-            Group* g = (Group*)temp;
-            for ( int i = 0; i < g->numObjects(); i++ )
-                moveToTop( (*g)[i], false );
-        }
+    drawnObjects->moveToTop( temp );
+
+    if ( temp->isGroup() )
+    {
+        Group* g = (Group*)temp;
+        for ( int i = 0; i < g->numObjects(); i++ )
+            moveToTop( (*g)[i], false );
     }
 }
 
-void gravManager::drawCurvedEarthLine( float lat, float lon,
-                                float destx, float desty, float destz )
+void gravManager::addCurvedEarthLine( RectangleBase* object,
+                                      EarthBatch& batch )
 {
+    float destx = object->getX();
+    float desty = object->getY();
+    float destz = object->getZ();
+
     // old method
+    float ux, uy, uz;
     float sx, sy, sz;
-    earth->convertLatLong( lat, lon, sx, sy, sz );
+    object->getEarthUnitPos( ux, uy, uz );
+    earth->convertUnit( ux, uy, uz, sx, sy, sz );
     float vecX = (sx - earth->getX()) * 0.08f;
     float vecY = (sy - earth->getY()) * 0.08f;
     float vecZ = (sz - earth->getZ()) * 0.08f;
@@ -631,13 +787,21 @@ void gravManager::drawCurvedEarthLine( float lat, float lon,
     float distanceScale = fabs(zdist/maxzdist);
     int i = 0;
 
-    glLineWidth( 2.0f );
-    glBegin( GL_LINE_STRIP );
-    glVertex3f( sx, sy, sz );
+    // the batch is GL_LINES rather than a strip (so lines for different
+    // objects can go in together), so every point after the first goes in
+    // twice: once to end the previous segment, once to start the next
+    RGBAColor col = object->getColor();
+    unsigned int start = batch.verts.size();
+    batch.verts.push_back( sx );
+    batch.verts.push_back( sy );
+    batch.verts.push_back( sz );
 
     while ( zdist > 1.0f )
     {
-        glVertex3f( tx, ty, tz );
+        batch.verts.push_back( tx ); batch.verts.push_back( ty );
+        batch.verts.push_back( tz );
+        batch.verts.push_back( tx ); batch.verts.push_back( ty );
+        batch.verts.push_back( tz );
         float weight = (((float)(iter-i))/(float)iter)*0.6f;
         //float weight = 0.2f;
         //weight *= weight;
@@ -672,10 +836,21 @@ void gravManager::drawCurvedEarthLine( float lat, float lon,
     }
     // shift the z back a bit so it doesn't overshoot the object
     if ( tz > destz - 0.3f ) tz -= 0.3f;
-    glVertex3f( tx, ty, tz );
+    batch.verts.push_back( tx ); batch.verts.push_back( ty );
+    batch.verts.push_back( tz );
+    batch.verts.push_back( tx ); batch.verts.push_back( ty );
+    batch.verts.push_back( tz );
     // -0.05f is so the line doesn't poke through the objects
-    glVertex3f( destx, desty, destz-0.05f );
-    glEnd();
+    batch.verts.push_back( destx ); batch.verts.push_back( desty );
+    batch.verts.push_back( destz-0.05f );
+
+    for ( unsigned int v = start; v < batch.verts.size(); v += 3 )
+    {
+        batch.colors.push_back( col.R );
+        batch.colors.push_back( col.G );
+        batch.colors.push_back( col.B );
+        batch.colors.push_back( col.A );
+    }
 
     // new method
     /*
@@ -820,15 +995,44 @@ void gravManager::drawCurvedEarthLine( float lat, float lon,
     */
 }
 
-void gravManager::drawEarthPoint( float lat, float lon, float size )
+void gravManager::addEarthPoint( RectangleBase* object, EarthBatch& batch )
 {
+    float ux, uy, uz;
     float sx, sy, sz;
-    earth->convertLatLong( lat, lon, sx, sy, sz );
+    object->getEarthUnitPos( ux, uy, uz );
+    earth->convertUnit( ux, uy, uz, sx, sy, sz );
 
-    glPointSize( size );
-    glBegin( GL_POINTS );
-    glVertex3f( sx, sy, sz );
-    glEnd();
+    RGBAColor col = object->getColor();
+    batch.verts.push_back( sx );
+    batch.verts.push_back( sy );
+    batch.verts.push_back( sz );
+    batch.colors.push_back( col.R );
+    batch.colors.push_back( col.G );
+    batch.colors.push_back( col.B );
+    batch.colors.push_back( col.A );
+}
+
+void gravManager::drawEarthBatch( EarthBatch& batch, GLenum mode, float size )
+{
+    if ( batch.verts.empty() )
+        return;
+
+    if ( mode == GL_POINTS )
+        glPointSize( size );
+    else
+        glLineWidth( size );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    glVertexPointer( 3, GL_FLOAT, 0, &batch.verts[0] );
+    glColorPointer( 4, GL_FLOAT, 0, &batch.colors[0] );
+    glDrawArrays( mode, 0, batch.verts.size() / 3 );
+    glDisableClientState( GL_COLOR_ARRAY );
+    glDisableClientState( GL_VERTEX_ARRAY );
+
+    // (clear keeps the capacity, so this doesn't reallocate every frame)
+    batch.verts.clear();
+    batch.colors.clear();
 }
 
 void gravManager::setBoxSelectDrawing( bool draw )
@@ -956,9 +1160,9 @@ std::vector<VideoSource*>* gravManager::getSources()
     return sources;
 }
 
-std::vector<RectangleBase*>* gravManager::getDrawnObjects()
+const std::vector<RectangleBase*>* gravManager::getDrawnObjects()
 {
-    return drawnObjects;
+    return &( drawnObjects->getList() );
 }
 
 std::vector<RectangleBase*>* gravManager::getSelectedObjects()
@@ -974,12 +1178,12 @@ std::map<std::string,Group*>* gravManager::getSiteIDGroups()
 std::vector<RectangleBase*> gravManager::getMovableObjects()
 {
     std::vector<RectangleBase*> objects;
-    for ( unsigned int i = 0; i < drawnObjects->size(); i++ )
+    const std::vector<RectangleBase*>& drawList = drawnObjects->getList();
+    for ( unsigned int i = 0; i < drawList.size(); i++ )
     {
-        if ( !(*drawnObjects)[i]->isGrouped() &&
-                (*drawnObjects)[i]->isUserMovable() )
+        if ( !drawList[i]->isGrouped() && drawList[i]->isUserMovable() )
         {
-            objects.push_back( (*drawnObjects)[i] );
+            objects.push_back( drawList[i] );
         }
     }
     return objects;
@@ -1004,69 +1208,287 @@ void gravManager::addNewSource( VideoSource* s )
 {
     if ( s == NULL ) return;
 
+    mutex_lock( sinkMutex );
+    sinkSources[ SourceKey( s->getSession(), s->getssrc() ) ] = s;
+    mutex_unlock( sinkMutex );
+
+    SceneCommand* cmd = new SceneCommand( SceneCommand::ADD_SOURCE );
+    cmd->source = s;
+    postCommand( cmd );
+}
+
+bool gravManager::removeSource( VPMSession* session, uint32_t ssrc )
+{
+    VideoSource* s = NULL;
+    mutex_lock( sinkMutex );
+    std::map<SourceKey, VideoSource*>::iterator i =
+            sinkSources.find( SourceKey( session, ssrc ) );
+    if ( i != sinkSources.end() )
+    {
+        s = i->second;
+        sinkSources.erase( i );
+    }
+    mutex_unlock( sinkMutex );
+
+    if ( s == NULL )
+        return false;
+
+    // VPMedia deletes the sink once we return - the source itself can wait
+    // for the next frame to go, since it won't touch the sink after this.
+    // (this can't wait for the frame: the network thread has the session lock
+    // here, which the drawing & GUI threads take between frames)
+    s->detachSink();
+
+    SceneCommand* cmd = new SceneCommand( SceneCommand::REMOVE_SOURCE );
+    cmd->session = session;
+    cmd->ssrc = ssrc;
+    postCommand( cmd );
+    return true;
+}
+
+void gravManager::setSourceSiteID( VPMSession* session, uint32_t ssrc,
+                                   std::string siteID )
+{
+    SceneCommand* cmd = new SceneCommand( SceneCommand::SET_SITE_ID );
+    cmd->session = session;
+    cmd->ssrc = ssrc;
+    cmd->data = siteID;
+    postCommand( cmd );
+}
+
+void gravManager::renameSource( VPMSession* session, uint32_t ssrc )
+{
+    SceneCommand* cmd = new SceneCommand( SceneCommand::RENAME_SOURCE );
+    cmd->session = session;
+    cmd->ssrc = ssrc;
+    postCommand( cmd );
+}
+
+void gravManager::postCommand( SceneCommand* cmd )
+{
+    commands->push( cmd );
+
+    // if this is the thread that draws (ie, threads are off, or a session is
+    // being deleted from the GUI) there's no reason to wait for the next draw.
+    // same for the GUI thread holding the scene away from a render thread
+    if ( ownsScene() )
+    {
+        lockSources();
+        processCommands();
+        unlockSources();
+    }
+}
+
+void gravManager::processCommands()
+{
+    SceneCommand* cmd = commands->takeAll();
+    while ( cmd != NULL )
+    {
+        SceneCommand* next = cmd->next;
+        runCommand( cmd );
+        delete cmd;
+        cmd = next;
+    }
+}
+
+void gravManager::runCommand( SceneCommand* cmd )
+{
+    if ( cmd->type == SceneCommand::ADD_SOURCE )
+    {
+        doAddSource( cmd->source );
+        return;
+    }
+
+    VideoSource* s = findSource( cmd->session, cmd->ssrc );
+    if ( s == NULL )
+    {
+        // seems to get a lot of "sources deleted but not in video sources
+        // list" on exit - may be that view-only clients are listed in the
+        // session. need to test more, but not that much of an issue
+        return;
+    }
+
+    switch ( cmd->type )
+    {
+    case SceneCommand::REMOVE_SOURCE:
+        doDeleteSource( s );
+        break;
+    case SceneCommand::SET_SITE_ID:
+        // standby sources aren't in the scene to group - they'll get picked
+        // up on the next RTCP APP after they're shown
+        if ( !isStandby( s ) )
+            doSetSiteID( s, cmd->data );
+        break;
+    case SceneCommand::RENAME_SOURCE:
+        // only bother updating it on the tree if it actually changes
+        if ( s->updateName() && tree && !isStandby( s ) )
+            tree->updateObjectName( s );
+        break;
+    default:
+        break;
+    }
+}
+
+VideoSource* gravManager::findSource( VPMSession* session, uint32_t ssrc )
+{
+    std::map<SourceKey, VideoSource*>::iterator i =
+            sourceIndex.find( SourceKey( session, ssrc ) );
+    return i != sourceIndex.end() ? i->second : NULL;
+}
+
+void gravManager::doAddSource( VideoSource* s )
+{
     Texture t = GLUtil::getInstance()->getTexture( "border" );
     s->setTexture( t.ID, t.width, t.height );
 
-    lockSources();
+    sourceIndex[ SourceKey( s->getSession(), s->getssrc() ) ] = s;
+
+    if ( standbySessions.count( s->getSession() ) > 0 )
+    {
+        s->updateName();
+        standbySources.push_back( s );
+        return;
+    }
+
+    addToScene( s, true );
+}
 
+void gravManager::addToScene( VideoSource* s, bool place )
+{
     sources->push_back( s );
-    drawnObjects->push_back( s );
+    drawnObjects->add( s );
     s->updateName();
 
-    // tree add needs to be done on main thread since WX accesses the tree in
-    // other places (ie, not thread safe, and this could be on a separate
-    // thread)
     if ( tree != NULL )
-        objectsToAddToTree->push_back( (RectangleBase*)s );
+        tree->addObject( s );
+
+    if ( !place )
+        return;
 
     // do extra placement stuff
     // execute automatic mode layout again if it's on...
     if ( autoFocusRotate )
     {
-        std::vector<RectangleBase*> tempOuterObjs = getMovableObjects();
-        std::vector<RectangleBase*> tempInnerObj( tempOuterObjs.end()-1,
-                                                    tempOuterObjs.end() );
-        tempOuterObjs.erase( tempOuterObjs.end()-1 );
-
-        std::map<std::string, std::vector<RectangleBase*> > data = \
-            std::map<std::string, std::vector<RectangleBase*> >();
-        data["inners"] = tempInnerObj;
-        data["outers"] = tempOuterObjs;
-        layouts->arrange( "aspectFocus", getScreenRect(), RectangleBase(),
-                            data );
+        std::vector<RectangleBase*> movableObjs = getMovableObjects();
+        ObjectSpan movable( movableObjs );
+        layoutWorker->request( ASPECTFOCUS_LAYOUT, getScreenRect(),
+                               RectangleBase(),
+                               movable.sub( 0, movable.size() - 1 ),
+                               movable.sub( movable.size() - 1, 1 ) );
     }
     // ...or rearrange it as a grid if the option is set...
     else if ( gridAuto )
     {
-        std::map<std::string, std::vector<RectangleBase*> > data = \
-            std::map<std::string, std::vector<RectangleBase*> >();
-        data["objects"] = getMovableObjects();
-        layouts->arrange("grid", getScreenRect(), getEarthRect(), data);
+        updateGridAuto();
     }
     // otherwise add to runway if we're using it & have >9 videos
     else if ( useRunway && videoListener->getSourceCount() > 9 )
         runway->add( s );
     // base case will just use placement defined in VideoListener (9 grid with
     // stacking)
+}
 
-    unlockSources();
+bool gravManager::isStandby( VideoSource* s )
+{
+    return std::find( standbySources.begin(), standbySources.end(), s ) !=
+            standbySources.end();
+}
+
+void gravManager::setSessionStandby( VPMSession* session, bool standby )
+{
+    if ( standby )
+        standbySessions.insert( session );
+    else
+        standbySessions.erase( session );
 }
 
-void gravManager::deleteSource( std::vector<VideoSource*>::iterator si )
+bool gravManager::sessionHasVideo( VPMSession* session )
+{
+    // standby sources only change on this thread, so no need to lock
+    for ( unsigned int i = 0; i < standbySources.size(); i++ )
+    {
+        if ( standbySources[i]->getSession() == session &&
+                standbySources[i]->hasVideo() )
+            return true;
+    }
+    return false;
+}
+
+int gravManager::revealSession( VPMSession* session, VPMSession* replacing )
 {
     lockSources();
+    standbySessions.erase( session );
 
-    RectangleBase* temp = (RectangleBase*)(*si);
-    VideoSource* s = *si;
+    std::vector<VideoSource*> revealed;
+    std::vector<VideoSource*>::iterator si = standbySources.begin();
+    while ( si != standbySources.end() )
+    {
+        if ( (*si)->getSession() == session )
+        {
+            revealed.push_back( *si );
+            si = standbySources.erase( si );
+        }
+        else
+            ++si;
+    }
 
-    removeFromLists( temp );
+    std::vector<VideoSource*> replaced;
+    if ( replacing != NULL )
+    {
+        for ( si = sources->begin(); si != sources->end(); ++si )
+        {
+            if ( (*si)->getSession() == replacing )
+                replaced.push_back( *si );
+        }
+    }
 
-    sources->erase( si );
+    for ( unsigned int i = 0; i < revealed.size(); i++ )
+    {
+        VideoSource* s = revealed[i];
+        if ( i < replaced.size() )
+        {
+            // go where the old one is & fade in over it - since it's added to
+            // the draw list after, it's drawn on top
+            RectangleBase* old = replaced[i];
+            // (height only, since the width depends on the new video's
+            // aspect)
+            s->setPos( old->getDestX(), old->getDestY() );
+            s->setHeight( old->getDestHeight() );
+            s->show( false, true );
+            addToScene( s, false );
+            s->show( true );
+        }
+        else
+            addToScene( s, true );
+    }
+
+    for ( unsigned int i = 0; i < replaced.size(); i++ )
+        replaced[i]->show( false );
+
+    unlockSources();
+    return revealed.size();
+}
+
+void gravManager::doDeleteSource( VideoSource* s )
+{
+    gravUtil::logVerbose( "gravManager::deleting source 0x%08x\n",
+                          s->getssrc() );
+
+    removeFromLists( s, !isStandby( s ) );
+
+    sourceIndex.erase( SourceKey( s->getSession(), s->getssrc() ) );
+    std::vector<VideoSource*>::iterator si =
+            std::find( sources->begin(), sources->end(), s );
+    if ( si != sources->end() )
+        sources->erase( si );
+    si = std::find( standbySources.begin(), standbySources.end(), s );
+    if ( si != standbySources.end() )
+        standbySources.erase( si );
 
     // TODO need case for runway grouping?
-    if ( temp->isGrouped() )
+    if ( s->isGrouped() )
     {
-        Group* g = temp->getGroup();
+        Group* g = s->getGroup();
 
         // remove object from the group, regardless of whether it's a siteID
         // group or not.
@@ -1074,7 +1496,7 @@ void gravManager::deleteSource( std::vector<VideoSource*>::iterator si )
         // groups of groups? maybe in removefromlists, but careful not to
         // degroup object before it hits that siteID check above or siteIDgroups
         // will have invalid references
-        g->remove( temp );
+        g->remove( s );
 
         // delete the group the object was in if this is the last object in it
         // and it's an automatically made siteID group
@@ -1090,28 +1512,52 @@ void gravManager::deleteSource( std::vector<VideoSource*>::iterator si )
                     siteIDGroups->find( g->getSiteID() );
             siteIDGroups->erase( gi );
 
-            // put off the group delete, since removing it from the tree has to
-            // happen on the main thread, and can't delete it before we remove
-            // it from the tree
-            objectsToDelete->push_back( g );
+            delete g;
         }
     }
 
     if ( gridAuto )
     {
-        std::map<std::string, std::vector<RectangleBase*> > data =
-            std::map<std::string, std::vector<RectangleBase*> >();
-        data["objects"] = getMovableObjects();
-        layouts->arrange("grid", getScreenRect(), getEarthRect(), data);
+        updateGridAuto();
     }
 
-    // we need to do videosource's delete somewhere else, since this function
-    // might be on a second thread, which would crash since the videosource
-    // delete needs to do a GL call to delete its texture and GL calls can only
-    // be on the main thread
-    objectsToDelete->push_back( s );
+    if ( videoListener != NULL )
+        videoListener->updatePixelCount( -( s->getVideoWidth() *
+                                            s->getVideoHeight() ) );
 
-    unlockSources();
+    // the GL texture delete in VideoSource's destructor has to be on the
+    // thread with the GL context - if this is the GUI thread holding the
+    // scene, the render thread deletes it at the start of the next frame
+    if ( isRenderThread() )
+        delete s;
+    else
+        retiredSources.push_back( s );
+}
+
+void gravManager::doSetSiteID( VideoSource* s, std::string siteID )
+{
+    if ( !enableSiteIDGroups || s->isGrouped() )
+        return;
+
+    Group* g;
+    std::map<std::string,Group*>::iterator mapi = siteIDGroups->find( siteID );
+
+    if ( mapi == siteIDGroups->end() )
+        g = createSiteIDGroup( siteID );
+    else
+        g = mapi->second;
+
+    s->setSiteID( siteID );
+    g->add( s );
+
+    // adding & removing will replace the object under its group
+    if ( tree != NULL )
+    {
+        tree->removeObject( s );
+        tree->addObject( s );
+
+        tree->updateObjectName( g );
+    }
 }
 
 void gravManager::deleteGroup( Group* g )
@@ -1120,34 +1566,42 @@ void gravManager::deleteGroup( Group* g )
 
     g->removeAll();
     removeFromLists( g );
-    // need to delete groups later as well, since we need to remove them from
-    // the tree first
-    objectsToDelete->push_back( g );
+    delete g;
 
     unlockSources();
 }
 
 void gravManager::addToDrawList( RectangleBase* obj )
 {
-    drawnObjects->push_back( obj );
+    drawnObjects->add( obj );
+}
+
+void gravManager::updateGridAuto()
+{
+    RectangleBase screen = getScreenRect();
+    gridLayout->update( getMovableObjects(),
+                        screen.getDestLBound(), screen.getDestRBound(),
+                        screen.getDestUBound(), screen.getDestDBound() );
 }
 
 void gravManager::removeFromLists( RectangleBase* obj, bool treeRemove )
 {
+    // the object might get deleted after this, so make sure the grid doesn't
+    // hold onto it
+    gridLayout->remove( obj );
+    layoutWorker->forget( obj );
+    focusedSpeakers.erase( std::remove( focusedSpeakers.begin(),
+                                        focusedSpeakers.end(), obj ),
+                           focusedSpeakers.end() );
+
     // remove it from the tree
     if ( tree && treeRemove )
     {
-        objectsToRemoveFromTree->push_back( obj );
+        tree->removeObject( obj );
     }
 
     // remove it from drawnobjects, if it is being drawn
-    std::vector<RectangleBase*>::iterator i = drawnObjects->begin();
-    while ( i != drawnObjects->end() && (*i) != obj ) i++;
-
-    // TODO: confirm this (checking whether it actually is in drawnobjects
-    //                      or not)
-    if ( i != drawnObjects->end() )
-        drawnObjects->erase( i );
+    drawnObjects->remove( obj );
 
     if ( obj->isSelected() )
     {
@@ -1172,7 +1626,7 @@ Group* gravManager::createSiteIDGroup( std::string data )
     // something that calls this function should mutex around it itself
     //lockSources();
 
-    drawnObjects->push_back( g );
+    drawnObjects->add( g );
     siteIDGroups->insert( std::pair<std::string,Group*>( data, g ) );
 
     if ( tree != NULL )
@@ -1279,22 +1733,19 @@ void gravManager::setVenueClientController( VenueClientController* vcc )
     // if setting a new one, stop drawing the old one
     if ( venueClientController != NULL )
     {
-        std::vector<RectangleBase*>::iterator i = drawnObjects->begin();
-        while ( i != drawnObjects->end() && (*i) != venueClientController )
-            i++;
-        drawnObjects->erase( i );
+        drawnObjects->remove( venueClientController );
     }
     venueClientController = vcc;
     if ( venueClientController != NULL)
     {
-        drawnObjects->push_back( venueClientController );
+        drawnObjects->add( venueClientController );
     }
 }
 
 void gravManager::setSessionManager( SessionManager* s )
 {
     sessionManager = s;
-    drawnObjects->push_back( sessionManager );
+    drawnObjects->add( sessionManager );
 }
 
 void gravManager::setHeaderString( std::string h )
@@ -1320,8 +1771,14 @@ void gravManager::lockSources()
 {
     if ( usingThreads )
     {
+        long start = getTimeUS();
         mutex_lock( sourceMutex );
         lockCount++;
+
+        // (stats are only touched while holding the lock, so they don't need
+        // any protection of their own)
+        lockStartUS = getTimeUS();
+        lockStats->addWait( lockStartUS - start );
     }
 }
 
@@ -1329,14 +1786,92 @@ void gravManager::unlockSources()
 {
     if ( usingThreads )
     {
+        lockStats->addHold( getTimeUS() - lockStartUS );
         mutex_unlock( sourceMutex );
         lockCount--;
     }
 }
 
+void gravManager::lockScene()
+{
+    if ( !renderThreaded || onRenderThread )
+        return;
+
+    if ( wxIsMainThread() && sceneLockDepth++ > 0 )
+        return;
+
+    __sync_fetch_and_add( &sceneWaiters, 1 );
+    mutex_lock( sceneMutex );
+    __sync_fetch_and_sub( &sceneWaiters, 1 );
+}
+
+void gravManager::unlockScene()
+{
+    if ( !renderThreaded || onRenderThread )
+        return;
+
+    if ( wxIsMainThread() && --sceneLockDepth > 0 )
+        return;
+
+    mutex_unlock( sceneMutex );
+}
+
+void gravManager::beginFrame()
+{
+    mutex_lock( sceneMutex );
+}
+
+void gravManager::endFrame()
+{
+    mutex_unlock( sceneMutex );
+
+    // the mutex isn't fair, so if the GUI thread is waiting on the scene, let
+    // it in before the next frame locks it again
+    while ( sceneWaiters > 0 )
+        wxMicroSleep( 100 );
+}
+
+void gravManager::setRenderThreaded( bool r )
+{
+    renderThreaded = r;
+}
+
+bool gravManager::isRenderThreaded()
+{
+    return renderThreaded;
+}
+
+void gravManager::claimRenderThread()
+{
+    onRenderThread = true;
+}
+
+bool gravManager::isRenderThread()
+{
+    return renderThreaded ? onRenderThread : wxIsMainThread();
+}
+
+bool gravManager::ownsScene()
+{
+    return isRenderThread() ||
+            ( renderThreaded && wxIsMainThread() && sceneLockDepth > 0 );
+}
+
+LockStats* gravManager::getLockStats()
+{
+    return lockStats;
+}
+
 void gravManager::setThreads( bool threads )
 {
     usingThreads = threads;
+
+    // layouts go on their own thread too if we're threading - otherwise
+    // they're done immediately & applied on the next draw
+    if ( threads )
+        layoutWorker->start();
+    else
+        layoutWorker->stop();
 }
 
 bool gravManager::usingRunway()
@@ -1365,6 +1900,10 @@ void gravManager::setRunwayUsage( bool run )
 
 void gravManager::setGridAuto( bool g )
 {
+    // objects have probably been moved around since grid mode was last on,
+    // so start the grid from scratch
+    if ( g && !gridAuto )
+        gridLayout->reset();
     gridAuto = g;
     if ( g && useRunway )
         setRunwayUsage( false );
@@ -1429,15 +1968,3 @@ bool gravManager::audioAvailable()
 {
     return audioEnabled && audio->getSourceCount() > 0;
 }
-
-void gravManager::doDelayedDelete()
-{
-    if ( objectsToDelete->size() > 0 )
-    {
-        for ( unsigned int i = 0; i < objectsToDelete->size(); i++ )
-        {
-            delete (*objectsToDelete)[i];
-        }
-        objectsToDelete->clear();
-    }
-}
@@ -64,7 +64,7 @@ gravUtil::~gravUtil()
 
 }
 
-std::string gravUtil::findFile( std::string file )
+std::string gravUtil::findFile( std::string file, bool required )
 {
     for ( std::vector<std::string>::iterator i = resourceDirList.begin();
             i != resourceDirList.end(); ++i )
@@ -78,7 +78,10 @@ std::string gravUtil::findFile( std::string file )
             return full;
         }
     }
-    logError( "gravUtil::findFile: file %s not found\n", file.c_str() );
+    if ( required )
+        logError( "gravUtil::findFile: file %s not found\n", file.c_str() );
+    else
+        logVerbose( "gravUtil::findFile: file %s not found\n", file.c_str() );
     return "";
 }
 
@@ -0,0 +1,750 @@
+/*
+ * @file rtpreplay.cpp
+ *
+ * Standalone RTP/RTCP replayer - reads a pcap or rtpdump capture and resends
+ * the RTP & RTCP packets in it to a (loopback or multicast) address, either
+ * with the original timing, time-scaled, or as fast as possible. SSRCs can be
+ * rewritten to turn a single captured stream into many, so grav can be loaded
+ * with a realistic number of sources without needing the remote sites.
+ *
+ * Example, replaying a capture as 30 sources to a local grav instance:
+ *
+ *   grav-rtpreplay -c 30 -d 127.0.0.1 -p 20002 site.pcap
+ *   grav 127.0.0.1/20002
+ *
+ * @author Andrew Ford
+ * Copyright (C) 2011 Rochester Institute of Technology
+ *
+ * This file is part of grav.
+ *
+ * grav is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * grav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with grav.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace
+{
+
+struct Packet
+{
+    double time;        // seconds since the first packet in the capture
+    bool rtcp;
+    uint16_t port;      // original destination port
+    std::vector<uint8_t> data;
+};
+
+/*
+ * Per-SSRC sequence/timestamp ranges, so that looped playback can keep
+ * sequence numbers and timestamps moving forward - otherwise the receiver
+ * sees every loop as a huge backwards jump & resets the source.
+ */
+struct StreamRange
+{
+    uint16_t firstSeq, lastSeq;
+    uint32_t firstTS, lastTS;
+    uint32_t tsChanges;
+};
+
+struct Options
+{
+    std::string dest;
+    int port;           // -1 means use the port(s) from the capture
+    double speed;       // 0 means as fast as possible
+    int copies;
+    int loops;          // 0 means forever
+    int ttl;
+    std::string iface;
+    bool verbose;
+};
+
+volatile sig_atomic_t stopRequested = 0;
+
+void handleSignal( int )
+{
+    stopRequested = 1;
+}
+
+uint16_t get16( const uint8_t* p )
+{
+    return ( p[0] << 8 ) | p[1];
+}
+
+uint32_t get32( const uint8_t* p )
+{
+    return ( (uint32_t)p[0] << 24 ) | ( (uint32_t)p[1] << 16 ) |
+           ( (uint32_t)p[2] << 8 ) | p[3];
+}
+
+void put16( uint8_t* p, uint16_t v )
+{
+    p[0] = v >> 8; p[1] = v & 0xFF;
+}
+
+void put32( uint8_t* p, uint32_t v )
+{
+    p[0] = v >> 24; p[1] = ( v >> 16 ) & 0xFF;
+    p[2] = ( v >> 8 ) & 0xFF; p[3] = v & 0xFF;
+}
+
+/*
+ * RTP & RTCP share ports in some setups (RFC 5761), so classify by the
+ * payload type byte rather than by port: 192-223 can't be a valid RTP payload
+ * type when the marker bit is included, so it has to be RTCP.
+ */
+bool isRTPVersion2( const uint8_t* p, size_t len )
+{
+    return len >= 8 && ( p[0] >> 6 ) == 2;
+}
+
+bool looksLikeRTCP( const uint8_t* p, size_t len )
+{
+    return isRTPVersion2( p, len ) && p[1] >= 192 && p[1] <= 223;
+}
+
+/*
+ * Given a link-layer frame, find the UDP payload and destination port.
+ * Handles ethernet (with optional VLAN tag), BSD loopback, raw IP and Linux
+ * cooked captures, over IPv4 or IPv6 without extension headers. Fragments are
+ * skipped.
+ */
+bool extractUDP( uint32_t linkType, const uint8_t* frame, size_t len,
+                    const uint8_t*& payload, size_t& payloadLen,
+                    uint16_t& dstPort )
+{
+    size_t off = 0;
+    uint16_t etherType = 0;
+
+    switch ( linkType )
+    {
+    case 1: // ethernet
+        if ( len < 14 ) return false;
+        etherType = get16( frame + 12 );
+        off = 14;
+        if ( etherType == 0x8100 && len >= 18 )
+        {
+            etherType = get16( frame + 16 );
+            off = 18;
+        }
+        break;
+    case 0: // BSD loopback - 4-byte host-order address family
+        // (plus the first byte of the IP header, for the version)
+        if ( len < 5 ) return false;
+        off = 4;
+        etherType = ( frame[off] >> 4 ) == 6 ? 0x86DD : 0x0800;
+        break;
+    case 101: // raw IP
+    case 228: // raw IPv4
+    case 229: // raw IPv6
+        off = 0;
+        if ( len < 1 ) return false;
+        etherType = ( frame[0] >> 4 ) == 6 ? 0x86DD : 0x0800;
+        break;
+    case 113: // linux cooked
+        if ( len < 16 ) return false;
+        etherType = get16( frame + 14 );
+        off = 16;
+        break;
+    case 276: // linux cooked v2
+        if ( len < 20 ) return false;
+        etherType = get16( frame );
+        off = 20;
+        break;
+    default:
+        return false;
+    }
+
+    const uint8_t* ip = frame + off;
+    size_t ipLen = len - off;
+    const uint8_t* udp;
+    size_t udpAvail;
+
+    if ( etherType == 0x0800 )
+    {
+        if ( ipLen < 20 || ( ip[0] >> 4 ) != 4 ) return false;
+        size_t ihl = ( ip[0] & 0x0F ) * 4;
+        if ( ihl < 20 || ipLen < ihl || ip[9] != 17 ) return false;
+        // skip fragments - either more-fragments set or nonzero offset
+        if ( get16( ip + 6 ) & 0x3FFF ) return false;
+        size_t total = get16( ip + 2 );
+        if ( total < ihl || total > ipLen ) total = ipLen;
+        udp = ip + ihl;
+        udpAvail = total - ihl;
+    }
+    else if ( etherType == 0x86DD )
+    {
+        if ( ipLen < 40 || ip[6] != 17 ) return false;
+        udp = ip + 40;
+        udpAvail = std::min( (size_t)get16( ip + 4 ), ipLen - 40 );
+    }
+    else
+    {
+        return false;
+    }
+
+    if ( udpAvail < 8 ) return false;
+    size_t udpLen = get16( udp + 4 );
+    if ( udpLen < 8 || udpLen > udpAvail ) udpLen = udpAvail;
+
+    dstPort = get16( udp + 2 );
+    payload = udp + 8;
+    payloadLen = udpLen - 8;
+    return true;
+}
+
+bool readPcap( FILE* f, const uint8_t* magicBytes,
+                std::vector<Packet>& packets )
+{
+    uint8_t rest[20];
+    if ( fread( rest, 1, 20, f ) != 20 )
+    {
+        fprintf( stderr, "rtpreplay: truncated pcap header\n" );
+        return false;
+    }
+
+    uint32_t magicBE = get32( magicBytes );
+    bool swapped = ( magicBE == 0xd4c3b2a1 || magicBE == 0x4d3cb2a1 );
+    bool nano = ( magicBE == 0xa1b23c4d || magicBE == 0x4d3cb2a1 );
+
+    // pcap fields are in the writer's byte order
+    struct
+    {
+        bool le;
+        uint32_t operator()( const uint8_t* p ) const
+        {
+            if ( le )
+                return ( (uint32_t)p[3] << 24 ) | ( (uint32_t)p[2] << 16 ) |
+                       ( (uint32_t)p[1] << 8 ) | p[0];
+            return get32( p );
+        }
+    } field32 = { swapped };
+
+    uint32_t linkType = field32( rest + 16 );
+
+    uint8_t rec[16];
+    std::vector<uint8_t> frame;
+    bool haveStart = false;
+    double start = 0.0;
+    unsigned long skipped = 0;
+
+    while ( fread( rec, 1, 16, f ) == 16 )
+    {
+        uint32_t sec = field32( rec );
+        uint32_t frac = field32( rec + 4 );
+        uint32_t inclLen = field32( rec + 8 );
+
+        if ( inclLen > 262144 )
+        {
+            fprintf( stderr, "rtpreplay: bogus pcap record length %u\n",
+                        inclLen );
+            return false;
+        }
+
+        frame.resize( inclLen );
+        if ( inclLen && fread( &frame[0], 1, inclLen, f ) != inclLen )
+        {
+            fprintf( stderr, "rtpreplay: truncated pcap record\n" );
+            break;
+        }
+
+        const uint8_t* payload;
+        size_t payloadLen;
+        uint16_t dstPort;
+        if ( inclLen == 0 ||
+                !extractUDP( linkType, &frame[0], inclLen, payload,
+                                payloadLen, dstPort ) ||
+                !isRTPVersion2( payload, payloadLen ) )
+        {
+            skipped++;
+            continue;
+        }
+
+        double t = sec + frac / ( nano ? 1e9 : 1e6 );
+        if ( !haveStart )
+        {
+            start = t;
+            haveStart = true;
+        }
+
+        Packet p;
+        p.time = t - start;
+        p.rtcp = looksLikeRTCP( payload, payloadLen );
+        p.port = dstPort;
+        p.data.assign( payload, payload + payloadLen );
+        packets.push_back( p );
+    }
+
+    if ( skipped > 0 )
+        fprintf( stderr, "rtpreplay: skipped %lu non-RTP frames\n", skipped );
+
+    return true;
+}
+
+/*
+ * rtpdump format (as written by rtpdump -F dump / read by rtpplay):
+ *   "#!rtpplay1.0 address/port\n"
+ *   RD_hdr_t: start sec, start usec, source addr (all u32), port, pad (u16)
+ *   then per packet: u16 length (incl. this 8-byte header), u16 plen
+ *   (original packet length, 0 for RTCP), u32 offset in ms, then data.
+ */
+bool readRtpdump( FILE* f, std::vector<Packet>& packets )
+{
+    char line[256];
+    if ( fgets( line, sizeof( line ), f ) == NULL )
+        return false;
+
+    uint16_t port = 0;
+    char* slash = strrchr( line, '/' );
+    if ( slash != NULL )
+        port = (uint16_t)atoi( slash + 1 );
+
+    uint8_t hdr[16];
+    if ( fread( hdr, 1, 16, f ) != 16 )
+    {
+        fprintf( stderr, "rtpreplay: truncated rtpdump header\n" );
+        return false;
+    }
+
+    uint8_t rec[8];
+    while ( fread( rec, 1, 8, f ) == 8 )
+    {
+        uint16_t length = get16( rec );
+        uint16_t plen = get16( rec + 2 );
+        uint32_t offset = get32( rec + 4 );
+
+        if ( length < 8 )
+            break;
+
+        Packet p;
+        p.data.resize( length - 8 );
+        if ( length > 8 &&
+                fread( &p.data[0], 1, length - 8, f ) != (size_t)length - 8 )
+        {
+            fprintf( stderr, "rtpreplay: truncated rtpdump record\n" );
+            break;
+        }
+
+        if ( !isRTPVersion2( p.data.empty() ? NULL : &p.data[0],
+                                p.data.size() ) )
+            continue;
+
+        p.time = offset / 1000.0;
+        p.rtcp = plen == 0 || looksLikeRTCP( &p.data[0], p.data.size() );
+        p.port = p.rtcp ? port + 1 : port;
+        packets.push_back( p );
+    }
+
+    return true;
+}
+
+bool earlierPacket( const Packet& a, const Packet& b )
+{
+    return a.time < b.time;
+}
+
+bool loadCapture( const char* filename, std::vector<Packet>& packets )
+{
+    FILE* f = fopen( filename, "rb" );
+    if ( f == NULL )
+    {
+        fprintf( stderr, "rtpreplay: can't open %s: %s\n", filename,
+                    strerror( errno ) );
+        return false;
+    }
+
+    uint8_t magic[4];
+    bool ret = false;
+    if ( fread( magic, 1, 4, f ) == 4 )
+    {
+        uint32_t m = get32( magic );
+        if ( m == 0xa1b2c3d4 || m == 0xd4c3b2a1 ||
+                m == 0xa1b23c4d || m == 0x4d3cb2a1 )
+        {
+            ret = readPcap( f, magic, packets );
+        }
+        else if ( memcmp( magic, "#!rt", 4 ) == 0 )
+        {
+            rewind( f );
+            ret = readRtpdump( f, packets );
+        }
+        else
+        {
+            fprintf( stderr, "rtpreplay: %s is not a pcap or rtpdump file "
+                        "(pcapng is not supported, convert it with "
+                        "editcap -F pcap)\n", filename );
+        }
+    }
+    fclose( f );
+
+    // captures from multiple interfaces aren't always in order
+    std::stable_sort( packets.begin(), packets.end(), earlierPacket );
+    if ( !packets.empty() )
+    {
+        double first = packets.front().time;
+        for ( size_t i = 0; i < packets.size(); i++ )
+            packets[i].time -= first;
+    }
+    return ret;
+}
+
+/*
+ * Deriving copy SSRCs with a multiplicative hash keeps copy 0 as the original
+ * and makes collisions between copies of different original streams unlikely.
+ */
+uint32_t copySSRC( uint32_t ssrc, int copy )
+{
+    return ssrc ^ ( (uint32_t)copy * 0x9E3779B9u );
+}
+
+void rewriteRTCP( uint8_t* p, size_t len, int copy )
+{
+    size_t off = 0;
+    while ( off + 8 <= len )
+    {
+        uint8_t* pkt = p + off;
+        int count = pkt[0] & 0x1F;
+        uint8_t pt = pkt[1];
+        size_t pktLen = ( get16( pkt + 2 ) + 1 ) * 4;
+        if ( off + pktLen > len )
+            pktLen = len - off;
+
+        switch ( pt )
+        {
+        case 200: // SR: sender SSRC, 20 bytes sender info, report blocks
+        case 201: // RR: sender SSRC, report blocks
+        {
+            size_t block = ( pt == 200 ) ? 28 : 8;
+            put32( pkt + 4, copySSRC( get32( pkt + 4 ), copy ) );
+            for ( int i = 0; i < count && block + 24 <= pktLen; i++ )
+            {
+                put32( pkt + block, copySSRC( get32( pkt + block ), copy ) );
+                block += 24;
+            }
+            break;
+        }
+        case 202: // SDES: chunks of SSRC + items, each padded to 32 bits
+        {
+            size_t c = 4;
+            for ( int i = 0; i < count && c + 4 <= pktLen; i++ )
+            {
+                put32( pkt + c, copySSRC( get32( pkt + c ), copy ) );
+                c += 4;
+                while ( c < pktLen && pkt[c] != 0 )
+                {
+                    if ( c + 1 >= pktLen ) break;
+                    c += 2 + pkt[c+1];
+                }
+                c = ( c + 4 ) & ~(size_t)3;
+            }
+            break;
+        }
+        case 203: // BYE: list of SSRCs
+            for ( int i = 0; i < count && 8 + i * 4 <= (int)pktLen; i++ )
+                put32( pkt + 4 + i * 4,
+                        copySSRC( get32( pkt + 4 + i * 4 ), copy ) );
+            break;
+        default: // APP & others start with an SSRC
+            put32( pkt + 4, copySSRC( get32( pkt + 4 ), copy ) );
+            break;
+        }
+
+        off += pktLen;
+    }
+}
+
+void usage()
+{
+    fprintf( stderr,
+        "Usage: grav-rtpreplay [options] capture-file\n"
+        "  Replays the RTP/RTCP packets in a pcap or rtpdump capture.\n\n"
+        "  -d, --dest=<addr>     destination address (default 127.0.0.1,\n"
+        "                        may be multicast)\n"
+        "  -p, --port=<num>      RTP port to send to, RTCP goes to port+1\n"
+        "                        (default: ports from the capture)\n"
+        "  -s, --speed=<num>     time scale, 2 = twice as fast (default 1)\n"
+        "  -f, --fast            send as fast as possible, ignoring timing\n"
+        "  -c, --copies=<num>    send each stream num times with rewritten\n"
+        "                        SSRCs, to simulate more sources (default 1)\n"
+        "  -l, --loop=<num>      play the capture num times, 0 = forever\n"
+        "                        (default 1)\n"
+        "  -t, --ttl=<num>       multicast TTL (default 1)\n"
+        "  -i, --interface=<ip>  local interface address for multicast\n"
+        "  -v, --verbose         print per-loop statistics\n"
+        "  -h, --help            displays this help message\n" );
+}
+
+double monotonicNow()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void sleepUntil( double when )
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)when;
+    ts.tv_nsec = (long)( ( when - ts.tv_sec ) * 1e9 );
+    while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL )
+                == EINTR && !stopRequested )
+        ;
+}
+
+} // end anonymous namespace
+
+int main( int argc, char* argv[] )
+{
+    Options opts;
+    opts.dest = "127.0.0.1";
+    opts.port = -1;
+    opts.speed = 1.0;
+    opts.copies = 1;
+    opts.loops = 1;
+    opts.ttl = 1;
+    opts.verbose = false;
+
+    static const struct option longOpts[] =
+    {
+        { "dest", required_argument, NULL, 'd' },
+        { "port", required_argument, NULL, 'p' },
+        { "speed", required_argument, NULL, 's' },
+        { "fast", no_argument, NULL, 'f' },
+        { "copies", required_argument, NULL, 'c' },
+        { "loop", required_argument, NULL, 'l' },
+        { "ttl", required_argument, NULL, 't' },
+        { "interface", required_argument, NULL, 'i' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int c;
+    while ( ( c = getopt_long( argc, argv, "d:p:s:fc:l:t:i:vh", longOpts,
+                                NULL ) ) != -1 )
+    {
+        switch ( c )
+        {
+        case 'd': opts.dest = optarg; break;
+        case 'p': opts.port = atoi( optarg ); break;
+        case 's': opts.speed = atof( optarg ); break;
+        case 'f': opts.speed = 0.0; break;
+        case 'c': opts.copies = atoi( optarg ); break;
+        case 'l': opts.loops = atoi( optarg ); break;
+        case 't': opts.ttl = atoi( optarg ); break;
+        case 'i': opts.iface = optarg; break;
+        case 'v': opts.verbose = true; break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if ( optind != argc - 1 || opts.copies < 1 || opts.speed < 0.0 ||
+            opts.loops < 0 || opts.port > 65534 )
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<Packet> packets;
+    if ( !loadCapture( argv[optind], packets ) )
+        return 1;
+    if ( packets.empty() )
+    {
+        fprintf( stderr, "rtpreplay: no RTP/RTCP packets found in %s\n",
+                    argv[optind] );
+        return 1;
+    }
+
+    std::map<uint32_t, StreamRange> ranges;
+    unsigned long rtpCount = 0;
+    for ( size_t i = 0; i < packets.size(); i++ )
+    {
+        Packet& p = packets[i];
+        if ( p.rtcp || p.data.size() < 12 )
+            continue;
+        rtpCount++;
+        uint32_t ssrc = get32( &p.data[8] );
+        uint16_t seq = get16( &p.data[2] );
+        uint32_t ts = get32( &p.data[4] );
+        std::map<uint32_t, StreamRange>::iterator r = ranges.find( ssrc );
+        if ( r == ranges.end() )
+        {
+            StreamRange sr = { seq, seq, ts, ts, 0 };
+            ranges[ ssrc ] = sr;
+        }
+        else
+        {
+            if ( ts != r->second.lastTS )
+                r->second.tsChanges++;
+            r->second.lastSeq = seq;
+            r->second.lastTS = ts;
+        }
+    }
+
+    double duration = packets.back().time;
+    printf( "rtpreplay: %lu packets (%lu RTP, %lu streams) over %.2f s\n",
+            (unsigned long)packets.size(), rtpCount,
+            (unsigned long)ranges.size(), duration );
+
+    int sock = socket( AF_INET, SOCK_DGRAM, 0 );
+    if ( sock < 0 )
+    {
+        perror( "rtpreplay: socket" );
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family = AF_INET;
+    if ( inet_pton( AF_INET, opts.dest.c_str(), &addr.sin_addr ) != 1 )
+    {
+        fprintf( stderr, "rtpreplay: invalid destination %s\n",
+                    opts.dest.c_str() );
+        return 1;
+    }
+
+    if ( IN_MULTICAST( ntohl( addr.sin_addr.s_addr ) ) )
+    {
+        unsigned char ttl = (unsigned char)opts.ttl;
+        unsigned char loop = 1;
+        setsockopt( sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof( ttl ) );
+        setsockopt( sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop,
+                    sizeof( loop ) );
+        if ( !opts.iface.empty() )
+        {
+            struct in_addr ifaddr;
+            if ( inet_pton( AF_INET, opts.iface.c_str(), &ifaddr ) != 1 ||
+                    setsockopt( sock, IPPROTO_IP, IP_MULTICAST_IF, &ifaddr,
+                                sizeof( ifaddr ) ) != 0 )
+                fprintf( stderr, "rtpreplay: couldn't use interface %s\n",
+                            opts.iface.c_str() );
+        }
+    }
+
+    // with many copies the default send buffer fills up quickly in fast mode
+    int sndbuf = 4 * 1024 * 1024;
+    setsockopt( sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof( sndbuf ) );
+
+    signal( SIGINT, handleSignal );
+    signal( SIGTERM, handleSignal );
+
+    std::vector<uint8_t> buf;
+    unsigned long sent = 0, failed = 0, late = 0;
+    unsigned long long bytes = 0;
+    double maxLate = 0.0;
+    double start = monotonicNow();
+    // a loop's length includes one average packet gap, so the first packet of
+    // the next loop isn't sent at the same time as the last one
+    double loopLength = duration +
+            ( packets.size() > 1 ? duration / ( packets.size() - 1 ) : 0.0 );
+
+    for ( int loop = 0; !stopRequested && ( opts.loops == 0 ||
+                                             loop < opts.loops ); loop++ )
+    {
+        double loopStart = monotonicNow();
+        for ( size_t i = 0; i < packets.size() && !stopRequested; i++ )
+        {
+            const Packet& p = packets[i];
+
+            if ( opts.speed > 0.0 )
+            {
+                double target = start +
+                        ( loop * loopLength + p.time ) / opts.speed;
+                double now = monotonicNow();
+                if ( target > now )
+                {
+                    sleepUntil( target );
+                }
+                else if ( now - target > 0.005 )
+                {
+                    late++;
+                    maxLate = std::max( maxLate, now - target );
+                }
+            }
+
+            int port = opts.port >= 0 ?
+                        ( p.rtcp ? opts.port + 1 : opts.port ) : p.port;
+            addr.sin_port = htons( port );
+
+            for ( int copy = 0; copy < opts.copies; copy++ )
+            {
+                buf = p.data;
+                if ( p.rtcp )
+                {
+                    rewriteRTCP( &buf[0], buf.size(), copy );
+                }
+                else if ( buf.size() >= 12 )
+                {
+                    uint32_t ssrc = get32( &buf[8] );
+                    const StreamRange& r = ranges[ ssrc ];
+                    uint32_t tsStep = r.tsChanges > 0 ?
+                            ( r.lastTS - r.firstTS ) / r.tsChanges : 0;
+                    put16( &buf[2], get16( &buf[2] ) + loop *
+                            (uint16_t)( r.lastSeq - r.firstSeq + 1 ) );
+                    put32( &buf[4], get32( &buf[4] ) + loop *
+                            ( r.lastTS - r.firstTS + tsStep ) );
+                    put32( &buf[8], copySSRC( ssrc, copy ) );
+                }
+
+                if ( sendto( sock, &buf[0], buf.size(), 0,
+                            (struct sockaddr*)&addr, sizeof( addr ) ) < 0 )
+                {
+                    failed++;
+                }
+                else
+                {
+                    sent++;
+                    bytes += buf.size();
+                }
+            }
+        }
+
+        if ( opts.verbose )
+        {
+            double elapsed = monotonicNow() - loopStart;
+            printf( "rtpreplay: loop %i done in %.2f s\n", loop + 1, elapsed );
+        }
+    }
+
+    double elapsed = monotonicNow() - start;
+    printf( "rtpreplay: sent %lu packets (%.1f MB) in %.2f s, %.0f pkt/s, "
+            "%.2f Mbit/s\n", sent, bytes / 1e6, elapsed,
+            elapsed > 0.0 ? sent / elapsed : 0.0,
+            elapsed > 0.0 ? bytes * 8 / elapsed / 1e6 : 0.0 );
+    if ( failed > 0 )
+        printf( "rtpreplay: %lu sends failed\n", failed );
+    if ( late > 0 )
+        printf( "rtpreplay: %lu packets sent more than 5 ms late "
+                "(worst %.1f ms)\n", late, maxLate * 1000.0 );
+
+    close( sock );
+    return 0;
+}